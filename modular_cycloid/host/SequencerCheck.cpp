@@ -0,0 +1,188 @@
+/**
+ * SequencerCheck.cpp
+ *
+ * Host check of the built-in sequencer programs. Sequencer.cpp is built
+ * unchanged against the stub core in hal/ and a stand-in for the
+ * MotorControl and MenuSystem calls it makes. Every program is then run
+ * at several master times in LFO_UPDATE_INTERVAL ticks, and the values it
+ * sets, the ramps, the pause and the end are checked against the master
+ * revolution count at which the program says they happen.
+ *
+ * Build and run from this directory:
+ *   g++ -std=c++17 -Wall -Wextra -I hal -I ../main -o sequencer_check SequencerCheck.cpp ../main/Sequencer.cpp
+ *   ./sequencer_check
+ */
+
+#include <math.h>
+#include <Arduino.h>
+#include "Sequencer.h"
+#include "MotorControl.h"
+#include "MenuSystem.h"
+#include "Config.h"
+
+HostSerial Serial;
+
+// --- Stand-in Motor Settings ---
+static float wheelSpeeds[MOTORS_COUNT];
+static float lfoDepths[MOTORS_COUNT];
+static float lfoRates[MOTORS_COUNT];
+static bool lfoPolarities[MOTORS_COUNT];
+static float masterTime = 1000;
+static bool paused = false;
+
+float getWheelSpeed(byte motorIndex) { return wheelSpeeds[motorIndex]; }
+float getLfoDepth(byte motorIndex) { return lfoDepths[motorIndex]; }
+float getLfoRate(byte motorIndex) { return lfoRates[motorIndex]; }
+bool getLfoPolarity(byte motorIndex) { return lfoPolarities[motorIndex]; }
+float getMasterTime() { return masterTime; }
+void setWheelSpeed(byte motorIndex, float speed) { wheelSpeeds[motorIndex] = speed; }
+void setLfoDepth(byte motorIndex, float depth) { lfoDepths[motorIndex] = depth; }
+void setLfoRate(byte motorIndex, float rate) { lfoRates[motorIndex] = rate; }
+void setLfoPolarity(byte motorIndex, bool isBipolar) { lfoPolarities[motorIndex] = isBipolar; }
+void setMasterTime(float time) { masterTime = time; }
+void commitMotorSettings() {}
+bool getSystemPaused() { return paused; }
+void setSystemPaused(bool pause) { paused = pause; }
+
+// --- Expected Timelines ---
+#define CHECK_MAX_POINTS 24
+#define CHECK_TIMING_TICKS 2   // Ticks an event may land from its revolution: one to start, one to finish,
+                               // and one more after a pause, as execution resumes on the next tick
+
+// Value a parameter must hold at a master revolution count
+struct Checkpoint {
+  float revs;
+  byte param;       // SequenceParam
+  byte wheel;
+  float value;
+  float tolerance;  // Covers CHECK_TIMING_TICKS of a ramp's slope
+};
+
+struct ExpectedTimeline {
+  const char* name;
+  float pauseRevs;  // < 0: the program never pauses
+  float endRevs;
+  byte pointCount;
+  Checkpoint points[CHECK_MAX_POINTS];
+};
+
+static const ExpectedTimeline expectedTimelines[NUM_SEQUENCE_PROGRAMS] = {
+  { "Evolving spiral", -1, 160, 9, {
+    { 10, SEQ_PARAM_SPEED, 1, 2.0, 0.001 },
+    { 40, SEQ_PARAM_SPEED, 1, -0.25, 0.01 },
+    { 70, SEQ_PARAM_SPEED, 1, -2.5, 0.001 },
+    { 70, SEQ_PARAM_RATE, 1, 0, 0.001 },
+    { 85, SEQ_PARAM_RATE, 1, 0.2, 0.001 },
+    { 90, SEQ_PARAM_DEPTH, 1, 15, 0.05 },
+    { 120, SEQ_PARAM_DEPTH, 1, 30, 0.001 },
+    { 150, SEQ_PARAM_DEPTH, 1, 15, 0.05 },
+    { 150, SEQ_PARAM_SPEED, 3, 4.0, 0.001 } } },
+  { "Step ladder", -1, 160, 16, {
+    { 5, SEQ_PARAM_SPEED, 3, -1, 0.001 }, { 15, SEQ_PARAM_SPEED, 3, -2, 0.01 },
+    { 25, SEQ_PARAM_SPEED, 3, -3, 0.001 }, { 35, SEQ_PARAM_SPEED, 3, -2, 0.01 },
+    { 45, SEQ_PARAM_SPEED, 3, -1, 0.001 }, { 55, SEQ_PARAM_SPEED, 3, -2, 0.01 },
+    { 65, SEQ_PARAM_SPEED, 3, -3, 0.001 }, { 75, SEQ_PARAM_SPEED, 3, -2, 0.01 },
+    { 85, SEQ_PARAM_SPEED, 3, -1, 0.001 }, { 95, SEQ_PARAM_SPEED, 3, -2, 0.01 },
+    { 105, SEQ_PARAM_SPEED, 3, -3, 0.001 }, { 115, SEQ_PARAM_SPEED, 3, -2, 0.01 },
+    { 125, SEQ_PARAM_SPEED, 3, -1, 0.001 }, { 135, SEQ_PARAM_SPEED, 3, -2, 0.01 },
+    { 145, SEQ_PARAM_SPEED, 3, -3, 0.001 }, { 155, SEQ_PARAM_SPEED, 3, -2, 0.01 } } },
+  { "Two colour", 30, 60, 4, {
+    { 15, SEQ_PARAM_SPEED, 1, 1.5, 0.001 },
+    { 15, SEQ_PARAM_SPEED, 3, 3.375, 0.001 },
+    { 45, SEQ_PARAM_SPEED, 1, -1.5, 0.001 },
+    { 45, SEQ_PARAM_SPEED, 3, -3.375, 0.001 } } }
+};
+
+// Master times to run at: one a whole number of ticks per tenth, two not
+static const float checkMasterTimes[] = { 2000, 1234.7, 777.3 };
+
+// --- Runner ---
+
+static float readParam(byte param, byte wheel) {
+  switch (param) {
+    case SEQ_PARAM_SPEED: return wheelSpeeds[wheel];
+    case SEQ_PARAM_DEPTH: return lfoDepths[wheel];
+    case SEQ_PARAM_RATE: return lfoRates[wheel];
+    case SEQ_PARAM_POLARITY: return lfoPolarities[wheel] ? 1 : 0;
+    case SEQ_PARAM_MASTER: return masterTime;
+  }
+  return 0;
+}
+
+static bool checkEvent(const char* event, double revs, float expected, double allowedRevs) {
+  if (fabs(revs - expected) <= allowedRevs) return true;
+  printf("  %s at %.4f revs, expected %.4f\n", event, revs, expected);
+  return false;
+}
+
+// Run one program to its end; false after printing what went wrong
+static bool checkProgram(byte index, float startMasterTime) {
+  const ExpectedTimeline& expected = expectedTimelines[index];
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    wheelSpeeds[i] = 0;
+    lfoDepths[i] = 0;
+    lfoRates[i] = 0;
+    lfoPolarities[i] = false;
+  }
+  masterTime = startMasterTime;
+  paused = false;
+
+  bool ok = true;
+  double revs = 0, pauseRevs = -1;   // Summed per tick, as a float would drift over a long program
+  byte nextPoint = 0;
+  startSequence(index);
+  while (isSequenceRunning()) {
+    if (revs > expected.endRevs + 1) {
+      printf("  still running at %.4f revs\n", revs);
+      return false;
+    }
+
+    // Ticks stop while the machine is paused; resume at once
+    if (paused) {
+      pauseRevs = revs;
+      paused = false;
+    }
+    serviceSequencer(LFO_UPDATE_INTERVAL);
+    revs += LFO_UPDATE_INTERVAL / (double)masterTime;
+
+    while (nextPoint < expected.pointCount && expected.points[nextPoint].revs <= revs) {
+      const Checkpoint& point = expected.points[nextPoint++];
+      float value = readParam(point.param, point.wheel);
+      if (fabs(value - point.value) > point.tolerance) {
+        printf("  param %d of wheel %d is %.4f at %.4f revs, expected %.4f\n",
+               point.param, point.wheel, value, revs, point.value);
+        ok = false;
+      }
+    }
+  }
+
+  double tickRevs = LFO_UPDATE_INTERVAL / (double)masterTime;
+  if (nextPoint < expected.pointCount) {
+    printf("  ended before %.4f revs\n", expected.points[nextPoint].revs);
+    ok = false;
+  }
+  if (expected.pauseRevs >= 0) {
+    ok = checkEvent("paused", pauseRevs, expected.pauseRevs, CHECK_TIMING_TICKS * tickRevs) && ok;
+    ok = checkEvent("ended", revs, expected.endRevs, (CHECK_TIMING_TICKS + 1) * tickRevs) && ok;
+  } else {
+    ok = checkEvent("ended", revs, expected.endRevs, CHECK_TIMING_TICKS * tickRevs) && ok;
+  }
+  return ok;
+}
+
+int main() {
+  int failures = 0;
+  for (byte index = 0; index < NUM_SEQUENCE_PROGRAMS; index++) {
+    for (float time : checkMasterTimes) {
+      printf("%s at %g ms per revolution\n", expectedTimelines[index].name, time);
+      if (!checkProgram(index, time)) failures++;
+    }
+  }
+
+  if (failures) {
+    printf("FAIL: %d runs off their timeline\n", failures);
+    return 1;
+  }
+  printf("OK: every program keeps to its timeline\n");
+  return 0;
+}
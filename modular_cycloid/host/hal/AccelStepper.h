@@ -0,0 +1,13 @@
+/**
+ * AccelStepper.h (host)
+ * 
+ * Declares the type Config.h names; the host checks stand in for
+ * MotorControl and never step a motor.
+ */
+
+#ifndef HOST_ACCEL_STEPPER_H
+#define HOST_ACCEL_STEPPER_H
+
+class AccelStepper {};
+
+#endif // HOST_ACCEL_STEPPER_H
@@ -0,0 +1,26 @@
+/**
+ * Arduino.h (host)
+ * 
+ * Just enough of the Arduino core to build firmware modules with a desktop
+ * compiler for the host checks. Serial output goes to stdout.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#define F(text) (text)
+#define PROGMEM
+
+struct HostSerial {
+  void println(const char* text) { puts(text); }
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,12 @@
+/**
+ * LiquidCrystal_I2C.h (host)
+ * 
+ * Declares the type Config.h names; the host checks never draw.
+ */
+
+#ifndef HOST_LIQUID_CRYSTAL_I2C_H
+#define HOST_LIQUID_CRYSTAL_I2C_H
+
+class LiquidCrystal_I2C {};
+
+#endif // HOST_LIQUID_CRYSTAL_I2C_H
@@ -0,0 +1,10 @@
+/**
+ * Wire.h (host)
+ * 
+ * Empty: the host checks never touch the I2C bus.
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#endif // HOST_WIRE_H
@@ -100,6 +100,12 @@ const float RATIO_PRESETS[NUM_RATIO_PRESETS][MOTORS_COUNT] = {
   {1.0, -1.5, 2.25, -3.375}    // Preset 7: Mixed direction geometric
 };
 
+// --- PARAMETER LIMITS ---
+#define WHEEL_SPEED_MIN -10.0   // Minimum wheel speed ratio
+#define WHEEL_SPEED_MAX 10.0    // Maximum wheel speed ratio
+#define MASTER_TIME_MIN 10.0    // Min 10 ms period
+#define MASTER_TIME_MAX 60000.0 // Max 1 min period
+
 // --- LFO CONFIGURATION ---
 #define LFO_DEPTH_MAX 100   // Maximum LFO depth as a percentage
 #define LFO_RATE_MAX 10     // Maximum LFO rate in Hz
@@ -110,6 +116,88 @@ const float RATIO_PRESETS[NUM_RATIO_PRESETS][MOTORS_COUNT] = {
 #define NUM_VALID_MICROSTEPS 8
 const int VALID_MICROSTEPS[NUM_VALID_MICROSTEPS] = {1, 2, 4, 8, 16, 32, 64, 128};
 
+// --- STREAMED MOTION SEGMENTS ---
+#define SEGMENT_QUEUE_SIZE 8         // Segments buffered ahead of the one executing
+#define SEGMENT_DURATION_MAX 60000   // Longest single segment in milliseconds
+
+// --- PATTERN SEQUENCER ---
+#define NUM_SEQUENCE_PROGRAMS 3          // Built-in programs in Sequencer.cpp
+#define SEQUENCER_MAX_STEPS_PER_TICK 8   // Instant instructions run per motor tick
+
+// --- PRESET MORPH ---
+#define MORPH_SCHEDULE_STEPS 256   // Parameter updates per morph
+#define MORPH_REVS_MAX 1000        // Longest morph in master revolutions
+#define MORPH_DEFAULT_REVS 10      // Morph length used by the RATIO menu
+
+// --- PATTERN PERIOD ---
+#define PERIOD_MAX_DENOMINATOR 100     // Ratios needing a larger denominator are treated as non-closing
+#define PERIOD_RATIO_TOLERANCE 0.00002 // Max |ratio - p/q| for an exact match (above float noise)
+
+// --- AUTO-STOP ---
+#define STOP_AFTER_REVS_MAX 100000     // Longest stopafter=<revs> in master revolutions
+
+// --- STEP RATE BUDGET ---
+// Aggregate steps/s the main loop sustains across all axes (AccelStepper
+// runSpeed on a 16 MHz Uno with LCD and serial active). Demand above this
+// is scaled down on every wheel together instead of losing steps.
+#define STEP_RATE_BUDGET 4000
+
+// --- MODULATION MATRIX ---
+#define MOD_ROUTE_COUNT 8              // Source -> destination routes
+#define MOD_COUNTER_REVS 16            // Master revolutions per rev-counter ramp
+#define MOD_ENVELOPE_DEFAULT_REVS 8    // Envelope attack length in master revolutions
+#define MOD_ENVELOPE_REVS_MAX 1000     // Longest modenv=<revs> attack
+#define MOD_MASTER_FACTOR_MIN 8192     // Q15 floor for the master time factor (x0.25)
+// Worst case for a full matrix is ~1000 cycles (~65 us) on a 16 MHz Uno;
+// the measured peak is reported by 'mod' and must stay under this
+#define MOD_TICK_BUDGET_US 250
+
+// --- PAUSE/RESUME ---
+#define PAUSE_RAMP_MS 500   // All wheels ramp down (pause) or up (resume) together over this time
+
+// --- DRIVER TYPES AND DIL SWITCH ---
+// A 3-pole DIL switch drives MS1/MS2/MS3 on all four drivers together
+enum DriverType {
+  DRIVER_A4988,
+  DRIVER_TMC2208
+};
+#define DEFAULT_DRIVER_TYPE DRIVER_A4988
+
+// DIL switch positions {MS1, MS2, MS3} per supported microstep mode
+#define A4988_DIL_COUNT 5
+const byte A4988_DIL_MODES[A4988_DIL_COUNT] = {1, 2, 4, 8, 16};
+const bool A4988_DIL_CONFIGS[A4988_DIL_COUNT][3] = {
+  {0, 0, 0},  // 1x (full step)
+  {1, 0, 0},  // 2x (half step)
+  {0, 1, 0},  // 4x (quarter step)
+  {1, 1, 0},  // 8x (eighth step)
+  {1, 1, 1}   // 16x (sixteenth step)
+};
+
+#define TMC2208_DIL_COUNT 8
+const byte TMC2208_DIL_MODES[TMC2208_DIL_COUNT] = {1, 2, 4, 8, 16, 32, 64, 128};
+const bool TMC2208_DIL_CONFIGS[TMC2208_DIL_COUNT][3] = {
+  {0, 0, 0},  // 1x (full step)
+  {1, 0, 0},  // 2x (half step)
+  {0, 1, 0},  // 4x (quarter step)
+  {1, 1, 0},  // 8x (eighth step)
+  {0, 0, 1},  // 16x (sixteenth step)
+  {1, 0, 1},  // 32x
+  {0, 1, 1},  // 64x
+  {1, 1, 1}   // 128x
+};
+
+#define ADVISE_HEADROOM_MIN 10   // % of the step budget the advised mode must leave free
+
+// --- EEPROM SETTINGS STORE ---
+#define SETTINGS_EEPROM_BASE 0     // First byte of the settings slot ring
+#define SETTINGS_SLOT_SIZE 64      // Bytes per slot (record is padded to this)
+#define SETTINGS_SLOT_COUNT 8      // Slots rotated through for wear leveling (512 bytes)
+#define SETTINGS_VERSION 1         // Bump when the stored record layout changes
+#define SETTINGS_SAVE_DELAY 5000   // ms settings must be unchanged before saving
+#define PRESET_EEPROM_BASE 512     // User preset bank follows the settings ring
+#define PRESET_SLOT_COUNT 8        // User presets (save=<n>/load=<n>), same slot size
+
 // --- DEFAULT VALUES ---
 #define DEFAULT_MASTER_TIME 2000 // Default master time (period) in milliseconds (e.g., 1000ms for 60RPM at speed 1.0)
 #define DEFAULT_SPEED_RATIO 1.0 // Default ratio for all motors
@@ -17,15 +17,19 @@ static unsigned long lastEncoderChangeTime = 0;
 static int lastChange = 0;
 static int accumulatedChange = 0;
 static int stableStateCounter = 0;
-static unsigned long lastActionTime = 0;
-static int consecutiveSteps = 0;
+static unsigned long lastDetentTime = 0;     // micros() timestamp of the last registered detent
+static unsigned int smoothedVelocity = 0;     // Detents per second, Q4 fixed point (x16)
 
 // Enhanced debounce parameters
 #define ENCODER_DEBOUNCE_TIME 5000    // Microseconds between readings
 #define ENCODER_STABLE_TIME 50000     // Microseconds before considering state stable
 #define ENCODER_ACCUMULATION_THRESHOLD 2 // Minimum accumulated changes to register
 #define ACCELERATION_TIMEOUT 400      // ms - if no movement for this time, reset acceleration (reduced for quicker response)
-#define MAX_ACCELERATION 30           // Maximum acceleration multiplier (increased from 15)
+
+// Velocity estimation (see applyEncoderAcceleration)
+#define VELOCITY_FRAC_BITS 4          // Smoothed velocity is stored in Q4 (1/16 detent per second)
+#define VELOCITY_SMOOTHING_SHIFT 2    // Exponential smoothing factor alpha = 1/4
+#define VELOCITY_MAX_DPS 100          // Clamp on instantaneous velocity (detents/s) to reject glitches
 
 static volatile bool buttonPressed = false;
 static volatile bool buttonLongPressed = false;
@@ -37,6 +41,7 @@ static volatile unsigned long lastButtonDebounceTime = 0;
 // --- Forward Declarations for Static Functions ---
 static void handleShortPress();
 static void handleLongPress();
+static void updateEncoderVelocity(unsigned long detentTime);
 
 // Initialize encoder pins
 void setupEncoder() {
@@ -116,38 +121,11 @@ void processEncoderChanges() {
       // Update encoder position
       encoderPos += finalChange;
       
-      // Calculate acceleration based on timing
-      unsigned long currentMillis = millis();
-      
-      // Check if this is part of a continuous motion
-      if (currentMillis - lastActionTime < ACCELERATION_TIMEOUT) {
-        // This is a continuous movement, increase acceleration
-        consecutiveSteps++;
-        // Cap the acceleration at a maximum value
-        if (consecutiveSteps > MAX_ACCELERATION) {
-          consecutiveSteps = MAX_ACCELERATION;
-        }
-      } else {
-        // This is a new movement after a pause, reset acceleration
-        consecutiveSteps = 1;
-      }
-      
-      // Save the time of this action
-      lastActionTime = currentMillis;
-      
-      // Apply acceleration to the final change
-      int acceleratedChange = finalChange * consecutiveSteps;
-      
-      // Remove debug output
-      // Serial.print(F("Encoder: "));
-      // Serial.print(finalChange);
-      // Serial.print(F(" Accel: "));
-      // Serial.print(consecutiveSteps);
-      // Serial.print(F(" Final: "));
-      // Serial.println(acceleratedChange);
+      // Update the angular velocity estimate from the detent timestamp
+      updateEncoderVelocity(currentTime);
       
-      // Forward to the menu system to handle with acceleration
-      handleMenuNavigation(acceleratedChange);
+      // Forward the direction only; handlers scale it through their own curve
+      handleMenuNavigation(finalChange);
     }
     
     // Reset accumulated change after processing
@@ -157,6 +135,63 @@ void processEncoderChanges() {
   }
 }
 
+/**
+ * Update the smoothed encoder velocity from the time between detents.
+ * Instantaneous velocity is 1/dt, blended into the running estimate with
+ * an exponential moving average. A pause longer than ACCELERATION_TIMEOUT
+ * restarts the estimate from zero so a fresh turn always begins fine.
+ * @param detentTime micros() timestamp of the detent just registered
+ */
+static void updateEncoderVelocity(unsigned long detentTime) {
+  unsigned long interval = detentTime - lastDetentTime;
+  lastDetentTime = detentTime;
+  
+  if (interval >= (unsigned long)ACCELERATION_TIMEOUT * 1000UL) {
+    smoothedVelocity = 0;
+    return;
+  }
+  
+  // Instantaneous velocity in Q4 detents/s: (1e6 us/s << 4) / interval
+  unsigned long instant = (1000000UL << VELOCITY_FRAC_BITS) / (interval ? interval : 1);
+  if (instant > ((unsigned long)VELOCITY_MAX_DPS << VELOCITY_FRAC_BITS)) {
+    instant = (unsigned long)VELOCITY_MAX_DPS << VELOCITY_FRAC_BITS;
+  }
+  
+  // v += (instant - v) * alpha, done in signed integer math
+  int delta = (int)instant - (int)smoothedVelocity;
+  smoothedVelocity = (unsigned int)((int)smoothedVelocity + (delta >> VELOCITY_SMOOTHING_SHIFT));
+}
+
+// Smoothed encoder velocity in whole detents per second
+unsigned int getEncoderVelocity() {
+  return smoothedVelocity >> VELOCITY_FRAC_BITS;
+}
+
+/**
+ * Map a single detent through a parameter's acceleration curve.
+ * The multiplier grows with the square of the velocity above the curve's
+ * threshold: mult = 1 + (excess^2 * gain) / 256, capped at maxMultiplier.
+ * Integer only, so it is cheap on the AVR (no pow()).
+ * @param direction +1 or -1 from handleMenuNavigation
+ * @param curve The parameter-specific curve
+ * @return Signed number of fine steps to apply
+ */
+long applyEncoderAcceleration(int direction, const EncoderAccelCurve& curve) {
+  if (direction == 0) return 0;
+  
+  unsigned int velocity = getEncoderVelocity();
+  unsigned long multiplier = 1;
+  if (velocity > curve.thresholdDps) {
+    unsigned long excess = velocity - curve.thresholdDps;
+    multiplier += (excess * excess * curve.gain) >> 8;
+    if (multiplier > curve.maxMultiplier) {
+      multiplier = curve.maxMultiplier;
+    }
+  }
+  
+  return (direction > 0) ? (long)multiplier : -(long)multiplier;
+}
+
 // Check for button presses (regularly called from loop)
 void checkButtonPress() {
   // Read the button state
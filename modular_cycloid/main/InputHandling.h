@@ -15,6 +15,17 @@ void setupEncoder();
 void processEncoderChanges(); // New function to be called from loop
 void checkButtonPress(); // Called from loop, keep public
 
+// --- Encoder Acceleration ---
+// Per-parameter curve mapping encoder velocity (detents/s) to a step multiplier
+struct EncoderAccelCurve {
+  unsigned int thresholdDps;   // Below this velocity every detent is one fine step
+  unsigned int gain;           // Quadratic gain above the threshold (1/256 units)
+  unsigned int maxMultiplier;  // Upper bound on fine steps per detent
+};
+
+unsigned int getEncoderVelocity(); // Smoothed velocity in detents per second
+long applyEncoderAcceleration(int direction, const EncoderAccelCurve& curve);
+
 // The following are primarily internal logic or forwarders, can be removed from public header
 // void processEncoderChange(int change); // Becomes static internal
 // Button press handlers
@@ -10,6 +10,10 @@
 
 #include "MenuSystem.h"
 #include "MotorControl.h"
+#include "InputHandling.h"
+#include "SettingsStore.h"
+#include "PresetMorph.h"
+#include "PatternPeriod.h"
 #include "Config.h"
 
 // --- LCD Instance ---
@@ -21,6 +25,23 @@ const byte NUM_MAIN_OPTIONS = 7; // SPEED, LFO, RATIO, MASTER, MICROSTEP, RESET,
 const byte NUM_LFO_PARAMS_PER_WHEEL = 3; // Depth, Rate, Polarity
 const byte NUM_LFO_PARAMS_TOTAL = MOTORS_COUNT * NUM_LFO_PARAMS_PER_WHEEL; // Calculate as needed, MOTORS_COUNT is from Config.h
 
+// Encoder acceleration curves {thresholdDps, gain, maxMultiplier}.
+// A fast spin is roughly 30 detents/s; gains are chosen so the full range
+// of each parameter is covered in about two seconds at that speed.
+static const EncoderAccelCurve SPEED_ACCEL_CURVE  = {4, 8, 20};   // 0.1 steps, -10..10
+static const EncoderAccelCurve DEPTH_ACCEL_CURVE  = {4, 24, 50};  // 0.1% steps, 0..100%
+static const EncoderAccelCurve RATE_ACCEL_CURVE   = {4, 4, 10};   // 0.1 Hz steps, 0..10 Hz
+static const EncoderAccelCurve MASTER_ACCEL_CURVE = {4, 76, 200}; // 10 ms steps, 10..60000 ms
+
+// RATIO menu lists the built-in presets followed by the user preset bank
+const byte NUM_RATIO_MENU_ENTRIES = NUM_RATIO_PRESETS + PRESET_SLOT_COUNT;
+enum RatioChoice {
+  RATIO_CHOICE_NO,
+  RATIO_CHOICE_APPLY, // YES for built-in presets, LOAD for user presets
+  RATIO_CHOICE_MORPH, // Crossfade over MORPH_DEFAULT_REVS revolutions
+  RATIO_CHOICE_SAVE   // User presets only
+};
+
 // Remove duplicate definitions clashing with Config.h defines
 // const byte NUM_RATIO_PRESETS = 4;
 // const byte NUM_VALID_MICROSTEPS = 8;
@@ -42,7 +63,7 @@ static bool editingMaster = false;
 static bool editingMicrostep = false;
 static bool confirmingRatio = false;
 static bool confirmingReset = false;
-static bool ratioChoice = false; // false=NO, true=YES for ratio preset confirmation
+static byte ratioChoice = RATIO_CHOICE_NO; // Selected action on the preset confirmation screen
 static bool resetChoice = false; // false=NO, true=YES for reset confirmation
 
 // Pause state
@@ -92,6 +113,10 @@ static void handleMicrostepMenu(int change);
 static void handleResetMenu(int change);
 static void handlePauseMenu(int change);
 static void applyRatioPreset(byte presetIndex);
+static void morphToRatioEntry(byte entryIndex);
+static void applyUserPreset(byte presetIndex);
+static void formatRatioPreview(const float* ratios, char* line);
+static int lcdHeadroom(byte microstepMode);
 static void enterSubmenu(MenuState menu);
 static void returnToMainMenu();
 
@@ -239,14 +264,20 @@ void handleMenuSelection() {
       if (!confirmingRatio) {
         // Go to confirmation screen
         confirmingRatio = true;
-        ratioChoice = false;  // Default to NO
+        ratioChoice = RATIO_CHOICE_NO;  // Default to NO
       } else {
-        if (ratioChoice) {  // YES selected
-          applyRatioPreset(selectedRatioPreset);
-          confirmingRatio = false;
-        } else {
-          confirmingRatio = false;  // Return to ratio selection
+        if (ratioChoice == RATIO_CHOICE_APPLY) {
+          if (selectedRatioPreset < NUM_RATIO_PRESETS) {
+            applyRatioPreset(selectedRatioPreset);
+          } else {
+            applyUserPreset(selectedRatioPreset - NUM_RATIO_PRESETS);
+          }
+        } else if (ratioChoice == RATIO_CHOICE_MORPH) {
+          morphToRatioEntry(selectedRatioPreset);
+        } else if (ratioChoice == RATIO_CHOICE_SAVE) {
+          savePreset(selectedRatioPreset - NUM_RATIO_PRESETS);
         }
+        confirmingRatio = false;  // Return to ratio selection
       }
       break;
       
@@ -349,16 +380,11 @@ static void handleSpeedMenu(int change) {
     // Get current value, modify it, and set it back
     float currentSpeed = getWheelSpeed(selectedSpeedWheel);
     
-    // Calculate step size based on change magnitude
-    float stepSize = 0.1;
-    if (abs(change) > 1) {
-      // Use a more aggressive non-linear scaling for larger changes
-      stepSize = 0.1 * pow(abs(change), 0.7); // More aggressive than sqrt (which is pow(x, 0.5))
-    }
-    
-    // Apply the change with appropriate step size
-    float newSpeed = currentSpeed + (change > 0 ? stepSize : -stepSize);
+    // Scale the detent through the speed acceleration curve (0.1 per fine step)
+    long steps = applyEncoderAcceleration(change, SPEED_ACCEL_CURVE);
+    float newSpeed = currentSpeed + steps * 0.1;
     setWheelSpeed(selectedSpeedWheel, newSpeed);
+    commitMotorSettings();
   } else {
     // Cycle through wheels
     selectedSpeedWheel = (selectedSpeedWheel + MOTORS_COUNT + change) % MOTORS_COUNT;
@@ -381,46 +407,27 @@ static void handleLfoMenu(int change) {
     if (paramType == 0) {  // Depth (0-100%)
       float currentDepth = getLfoDepth(wheelIndex);
       
-      // Calculate step size based on change magnitude
-      float stepSize = 0.1;
-      if (abs(change) > 1) {
-        // Use a more aggressive scaling for larger changes
-        stepSize = 0.1 * pow(abs(change), 0.7);
-        
-        // For larger values, make bigger steps
-        if (currentDepth > 50) {
-          stepSize *= 1.5; // Faster adjustment for higher values
-        }
-      }
-      
-      // Apply the change with appropriate step size
-      float newDepth = currentDepth + (change > 0 ? stepSize : -stepSize);
+      // Scale the detent through the depth acceleration curve (0.1% per fine step)
+      long steps = applyEncoderAcceleration(change, DEPTH_ACCEL_CURVE);
+      float newDepth = currentDepth + steps * 0.1;
       setLfoDepth(wheelIndex, newDepth);
+      commitMotorSettings();
     }
     else if (paramType == 1) {  // Rate (0-10.0)
       float currentRate = getLfoRate(wheelIndex);
       
-      // Calculate step size based on change magnitude
-      float stepSize = 0.1;
-      if (abs(change) > 1) {
-        // Use a more aggressive scaling for larger changes
-        stepSize = 0.1 * pow(abs(change), 0.7);
-        
-        // For larger values, make bigger steps
-        if (currentRate > 5) {
-          stepSize *= 1.5; // Faster adjustment for higher values
-        }
-      }
-      
-      // Apply the change with appropriate step size
-      float newRate = currentRate + (change > 0 ? stepSize : -stepSize);
+      // Scale the detent through the rate acceleration curve (0.1 Hz per fine step)
+      long steps = applyEncoderAcceleration(change, RATE_ACCEL_CURVE);
+      float newRate = currentRate + steps * 0.1;
       setLfoRate(wheelIndex, newRate);
+      commitMotorSettings();
     }
     else if (paramType == 2) {  // Polarity (toggle UNI/BI)
       if (change != 0) { 
         bool currentPolarity = getLfoPolarity(wheelIndex);
         bool newPolarity = !currentPolarity;
         setLfoPolarity(wheelIndex, newPolarity);
+        commitMotorSettings();
       }
     }
   } else {
@@ -449,11 +456,13 @@ static void handleLfoMenu(int change) {
 // Handle RATIO menu navigation
 static void handleRatioMenu(int change) {
   if (confirmingRatio) {
-    // Toggle YES/NO choice
-    if (change != 0) ratioChoice = !ratioChoice;
+    // Built-in presets cycle NO/YES/MORPH, user presets NO/LOAD/MORPH/SAVE
+    byte numChoices = (selectedRatioPreset < NUM_RATIO_PRESETS) ? 3 : 4;
+    if (change > 0) ratioChoice = (ratioChoice + 1) % numChoices;
+    else if (change < 0) ratioChoice = (ratioChoice + numChoices - 1) % numChoices;
   } else {
-    // Cycle through ratio presets
-    selectedRatioPreset = (selectedRatioPreset + NUM_RATIO_PRESETS + change) % NUM_RATIO_PRESETS;
+    // Cycle through built-in and user presets
+    selectedRatioPreset = (selectedRatioPreset + NUM_RATIO_MENU_ENTRIES + change) % NUM_RATIO_MENU_ENTRIES;
   }
 }
 
@@ -462,21 +471,11 @@ static void handleMasterMenu(int change) {
   if (editingMaster) {
     float currentTime = getMasterTime();
     
-    // Calculate step size based on change magnitude and current value
-    float stepSize = 10.0; // Base step size in ms
-    if (abs(change) > 1) {
-      // More aggressive scaling for larger changes
-      stepSize = 10.0 * pow(abs(change), 0.8);
-      
-      // For larger values, make even bigger steps
-      if (currentTime > 1000) {
-        stepSize *= 3.0; // Increased from 2.0 for faster adjustment
-      }
-    }
-    
-    // Apply the change with appropriate step size
-    float newTime = currentTime + (change > 0 ? stepSize : -stepSize);
+    // Scale the detent through the master acceleration curve (10 ms per fine step)
+    long steps = applyEncoderAcceleration(change, MASTER_ACCEL_CURVE);
+    float newTime = currentTime + steps * 10.0;
     setMasterTime(newTime);
+    commitMotorSettings();
   }
   // No cycling needed if not editing
 }
@@ -678,14 +677,46 @@ static void displayLfoMenu(char* line1, char* line2) {
  * @param line2 Buffer for the second line of display
  */
 static void displayRatioMenu(char* line1, char* line2) {
+  bool userPreset = selectedRatioPreset >= NUM_RATIO_PRESETS;
+  byte userIndex = selectedRatioPreset - NUM_RATIO_PRESETS;
+  
   if (confirmingRatio) {
-    strcpy(line1, "Apply Preset?");
+    if (userPreset) {
+      sprintf(line1, "User Preset %d:", userIndex + 1);
+      
+      // Show NO/LOAD/MORPH/SAVE options with cursor
+      if (ratioChoice == RATIO_CHOICE_APPLY) {
+        strcpy(line2, " NO>LOAD MRPH SV");
+      } else if (ratioChoice == RATIO_CHOICE_MORPH) {
+        strcpy(line2, " NO LOAD>MRPH SV");
+      } else if (ratioChoice == RATIO_CHOICE_SAVE) {
+        strcpy(line2, " NO LOAD MRPH>SV");
+      } else {
+        strcpy(line2, ">NO LOAD MRPH SV");
+      }
+    } else {
+      strcpy(line1, "Apply Preset?");
+      
+      // Show NO/YES/MORPH options with cursor
+      if (ratioChoice == RATIO_CHOICE_APPLY) {
+        strcpy(line2, " NO >YES  MORPH");
+      } else if (ratioChoice == RATIO_CHOICE_MORPH) {
+        strcpy(line2, " NO  YES >MORPH");
+      } else {
+        strcpy(line2, ">NO  YES  MORPH");
+      }
+    }
+  } else if (userPreset) {
+    sprintf(line1, "User %d", userIndex + 1);
     
-    // Show YES/NO options with cursor
-    if (ratioChoice) {
-      strcpy(line2, " NO   >YES");
+    // Preview the stored ratios, or flag the slot as unused
+    MachineSettings settings;
+    if (readPreset(userIndex, settings)) {
+      float ratios[MOTORS_COUNT];
+      for (byte i = 0; i < MOTORS_COUNT; i++) ratios[i] = settings.wheels[i].wheelSpeed;
+      formatRatioPreview(ratios, line2);
     } else {
-      strcpy(line2, ">NO    YES");
+      strcpy(line2, "(empty)");
     }
   } else {
     // Show the preset number in first line
@@ -694,20 +725,27 @@ static void displayRatioMenu(char* line1, char* line2) {
     strcpy(line1, buffer);
     
     // Show a preview of the ratios in the second line
-    char ratioBuffer[LCD_COLS + 1] = "";
+    formatRatioPreview(RATIO_PRESETS[selectedRatioPreset], line2);
+  }
+}
+
+/**
+ * Format wheel ratios as "r1:r2:r3:r4", truncated to the LCD width
+ * @param ratios One ratio per wheel
+ * @param line Output buffer of at least LCD_COLS + 1 bytes
+ */
+static void formatRatioPreview(const float* ratios, char* line) {
+  line[0] = '\0';
+  
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    char ratioStr[8]; // Buffer for ratio display
+    dtostrf(ratios[i], 3, 1, ratioStr);
     
-    for (byte i = 0; i < MOTORS_COUNT; i++) {
-      char ratioStr[5]; // Buffer for ratio display (smaller to fit)
-      dtostrf(RATIO_PRESETS[selectedRatioPreset][i], 3, 1, ratioStr);
-      
-      // Add to buffer (with separator if not last)
-      strcat(ratioBuffer, ratioStr);
-      if (i < MOTORS_COUNT - 1) {
-        strcat(ratioBuffer, ":");
-      }
+    // Add to buffer (with separator if not last), never past the LCD width
+    strncat(line, ratioStr, LCD_COLS - strlen(line));
+    if (i < MOTORS_COUNT - 1) {
+      strncat(line, ":", LCD_COLS - strlen(line));
     }
-    
-    strcpy(line2, ratioBuffer);
   }
 }
 
@@ -720,7 +758,10 @@ static void displayMasterMenu(char* line1, char* line2) {
   if (editingMaster) {
     strcpy(line1, "MASTER TIME:#");
   } else {
-    strcpy(line1, "MASTER TIME:");
+    // Show when the pattern closes, in master revolutions
+    char periodStr[8];
+    formatPatternPeriod(periodStr);
+    sprintf(line1, "MASTER  P=%s", periodStr);
   }
   
   // Use getter instead of direct access
@@ -736,15 +777,29 @@ static void displayMasterMenu(char* line1, char* line2) {
  * @param line2 Buffer for the second line of display
  */
 static void displayMicrostepMenu(char* line1, char* line2) {
-  if (editingMicrostep) {
-    strcpy(line1, "MICROSTEP:#");
-    // When editing, show the pending value that hasn't been applied yet
-    sprintf(line2, "Value: %dx", pendingMicrostepMode);
+  // First line carries the advised mode for the selected driver
+  byte advised = getAdvisedMicrostepMode(getDriverType());
+  if (advised == 0) {
+    strcpy(line1, editingMicrostep ? "STEP:# best none" : "STEP:  best none");
   } else {
-    strcpy(line1, "MICROSTEP:");
-    // When not editing, show the current actual value using the getter
-    sprintf(line2, "Value: %dx", getCurrentMicrostepMode());
+    sprintf(line1, editingMicrostep ? "STEP:# best %dx" : "STEP:  best %dx", advised);
+  }
+  
+  // When editing, show the pending value that hasn't been applied yet;
+  // otherwise the current actual value. D = DIL switches MS1-MS3.
+  byte mode = editingMicrostep ? pendingMicrostepMode : getCurrentMicrostepMode();
+  bool switches[3];
+  char dil[4] = "---";
+  if (getDilSwitchConfig(mode, getDriverType(), switches)) {
+    for (byte pole = 0; pole < 3; pole++) dil[pole] = switches[pole] ? '1' : '0';
   }
+  sprintf(line2, "%dx H%d%% D%s", mode, lcdHeadroom(mode), dil);
+}
+
+// Step rate headroom for a microstep mode, clamped to fit the LCD line
+static int lcdHeadroom(byte microstepMode) {
+  int headroom = getStepRateHeadroom(microstepMode);
+  return (headroom < -99) ? -99 : headroom;
 }
 
 /**
@@ -776,12 +831,50 @@ static void applyRatioPreset(byte presetIndex) {
       // Use the centralized ratio presets from Config.h
       setWheelSpeed(i, RATIO_PRESETS[presetIndex][i]);
     }
+    commitMotorSettings(); // All wheels change at the same motor tick
     // Keep this message as it's important user feedback
     Serial.print(F("Applied ratio preset "));
     Serial.println(presetIndex + 1);
   }
 }
 
+/**
+ * Morph to a RATIO menu entry over MORPH_DEFAULT_REVS master revolutions
+ * @param entryIndex Built-in preset index, or NUM_RATIO_PRESETS + user slot
+ */
+static void morphToRatioEntry(byte entryIndex) {
+  MachineSettings target;
+  if (entryIndex < NUM_RATIO_PRESETS) {
+    // Built-in presets only set ratios; LFO settings are kept
+    getMachineSettings(target);
+    for (byte i = 0; i < MOTORS_COUNT; i++) {
+      target.wheels[i].wheelSpeed = RATIO_PRESETS[entryIndex][i];
+    }
+  } else if (!readPreset(entryIndex - NUM_RATIO_PRESETS, target)) {
+    Serial.println(F("User preset is empty"));
+    return;
+  }
+  
+  startMorph(target, MORPH_DEFAULT_REVS);
+  Serial.print(F("Morphing to RATIO entry "));
+  Serial.println(entryIndex + 1);
+}
+
+/**
+ * Load a preset from the user bank (applied at the next motor update tick)
+ * @param presetIndex The index of the user preset to load (0-based)
+ */
+static void applyUserPreset(byte presetIndex) {
+  if (loadPreset(presetIndex)) {
+    Serial.print(F("Loaded user preset "));
+    Serial.println(presetIndex + 1);
+  } else {
+    Serial.print(F("User preset "));
+    Serial.print(presetIndex + 1);
+    Serial.println(F(" is empty"));
+  }
+}
+
 /**
  * Reset all settings to their default values
  */
@@ -861,7 +954,7 @@ static void returnToMainMenu() {
   confirmingRatio = false;
   confirmingReset = false;
   resetChoice = false;
-  ratioChoice = false;
+  ratioChoice = RATIO_CHOICE_NO;
   // Do NOT toggle pause state when returning to main menu
   updateDisplay();
 } 
\ No newline at end of file
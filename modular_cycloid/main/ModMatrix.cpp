@@ -0,0 +1,274 @@
+/**
+ * ModMatrix.cpp
+ *
+ * Implements the modulation matrix for the Cycloid Machine.
+ *
+ * Everything on the tick is integer: sources are Q15 values (LFO sine from
+ * a quarter-wave table, envelope and revolution counter from Q16.16
+ * accumulators advanced by a per-ms increment), each route adds
+ * source * amount to its destination's Q15 factor with one 16x16 multiply,
+ * and the factors are clamped to [0, 2]. Divisions only happen when a
+ * route, the envelope or the master time changes.
+ */
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "ModMatrix.h"
+#include "Config.h"
+
+#define MOD_FACTOR_UNITY 32768L
+#define MOD_FACTOR_MAX 65536L
+#define MOD_OUTPUT_COUNT (3 * MOTORS_COUNT + 1)   // Speed, rate, depth per wheel + master
+#define MOD_MAX_DELTA 100                         // ms; keeps the accumulators from overflowing
+#define MOD_ENVELOPE_MIN_MS 256
+
+#define ENVELOPE_FULL (32767UL << 16)             // Q16.16 of Q15 full scale
+#define COUNTER_WRAP (1UL << 31)                  // Q16.16 of Q15 1.0
+
+// LFO phase -> 0..255 table index without a division
+#define SINE_INDEX_SCALE (16777216UL / LFO_RESOLUTION)
+
+static_assert(MOD_ROUTE_COUNT <= 8, "Route slots are tracked in a byte mask");
+
+// Quarter-wave sine in Q15, 65 points (0..90 degrees)
+static const int16_t PROGMEM sineQuarter[65] = {
+  0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739, 9512,
+  10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+  18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279,
+  24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268,
+  29621, 29956, 30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137,
+  32285, 32412, 32521, 32609, 32678, 32728, 32757, 32767
+};
+
+// --- Internal State ---
+static ModRoute routes[MOD_ROUTE_COUNT];
+static byte routeOutput[MOD_ROUTE_COUNT];     // Index into modFactors
+static int16_t routeAmount[MOD_ROUTE_COUNT];  // amount in Q8 (100 % = 256)
+static byte routeMask = 0;                    // Bit per slot in use
+static byte sourceMask = 0;                   // Bit per source read by any route
+
+static int32_t modFactors[MOD_OUTPUT_COUNT];  // Q15, 32768 = unmodulated
+
+static unsigned long envelopeLevel = ENVELOPE_FULL;  // Idle envelope holds at full
+static unsigned long envelopeIncrement = 0;
+static unsigned long counterLevel = 0;
+static unsigned long counterIncrement = 0;
+static unsigned long counterMasterTime = 0;          // Master time the increment was made for
+
+static unsigned long peakMicros = 0;          // Slowest evaluation since the routes changed
+
+// --- Forward Declarations for Static Functions ---
+static byte outputIndex(byte destination, byte wheel);
+static void rebuildSourceMask();
+static void resetModFactors();
+static int16_t sineQ15(unsigned int phase);
+static void printSourceName(byte source);
+static void printDestinationName(byte destination, byte wheel);
+
+bool setModRoute(byte slot, const ModRoute& route) {
+  if (slot >= MOD_ROUTE_COUNT || route.source >= MOD_SRC_COUNT) return false;
+  if (route.destination > MOD_DEST_MASTER) return false;
+  if (route.destination != MOD_DEST_MASTER && route.wheel >= MOTORS_COUNT) return false;
+  if (route.amount < -100 || route.amount > 100) return false;
+
+  // The first route makes the factors live before serviceModMatrix() has
+  // run; start them at unity (the array is zeroed at boot)
+  if (routeMask == 0) resetModFactors();
+  routes[slot] = route;
+  routeOutput[slot] = outputIndex(route.destination, route.wheel);
+  routeAmount[slot] = (int16_t)(((long)route.amount * 256) / 100);
+  routeMask |= (1 << slot);
+  rebuildSourceMask();
+  peakMicros = 0;
+  return true;
+}
+
+void clearModRoute(byte slot) {
+  if (slot >= MOD_ROUTE_COUNT) return;
+  routeMask &= ~(1 << slot);
+  rebuildSourceMask();
+  peakMicros = 0;
+  if (routeMask == 0) resetModFactors();
+}
+
+void clearModRoutes() {
+  routeMask = 0;
+  sourceMask = 0;
+  peakMicros = 0;
+  resetModFactors();
+}
+
+bool getModRoute(byte slot, ModRoute& route) {
+  if (slot >= MOD_ROUTE_COUNT || !(routeMask & (1 << slot))) return false;
+  route = routes[slot];
+  return true;
+}
+
+bool isModMatrixActive() {
+  return routeMask != 0;
+}
+
+void triggerModEnvelope(unsigned long lengthMillis) {
+  if (lengthMillis < MOD_ENVELOPE_MIN_MS) lengthMillis = MOD_ENVELOPE_MIN_MS;
+  envelopeIncrement = ENVELOPE_FULL / lengthMillis;
+  envelopeLevel = 0;
+}
+
+// --- Tick Evaluation ---
+
+void serviceModMatrix(unsigned long deltaMillis, const unsigned int* lfoPhases, unsigned long masterTimeMillis) {
+  if (routeMask == 0) return;
+  unsigned long startMicros = micros();
+
+  if (deltaMillis > MOD_MAX_DELTA) deltaMillis = MOD_MAX_DELTA;
+
+  // Envelope: linear attack, then hold
+  if (envelopeLevel < ENVELOPE_FULL) {
+    envelopeLevel += envelopeIncrement * deltaMillis;
+    if (envelopeLevel > ENVELOPE_FULL) envelopeLevel = ENVELOPE_FULL;
+  }
+
+  // Revolution counter: sawtooth over MOD_COUNTER_REVS master revolutions
+  if (masterTimeMillis != counterMasterTime) {
+    counterMasterTime = masterTimeMillis;
+    counterIncrement = COUNTER_WRAP / ((unsigned long)MOD_COUNTER_REVS * masterTimeMillis);
+  }
+  counterLevel = (counterLevel + counterIncrement * deltaMillis) & (COUNTER_WRAP - 1);
+
+  int16_t sources[MOD_SRC_COUNT];
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    if (sourceMask & (1 << i)) sources[MOD_SRC_LFO1 + i] = sineQ15(lfoPhases[i]);
+  }
+  sources[MOD_SRC_ENVELOPE] = (int16_t)(envelopeLevel >> 16);
+  sources[MOD_SRC_REV_COUNTER] = (int16_t)(counterLevel >> 16);
+
+  for (byte o = 0; o < MOD_OUTPUT_COUNT; o++) {
+    modFactors[o] = MOD_FACTOR_UNITY;
+  }
+  for (byte slot = 0; slot < MOD_ROUTE_COUNT; slot++) {
+    if (!(routeMask & (1 << slot))) continue;
+    modFactors[routeOutput[slot]] += ((int32_t)sources[routes[slot].source] * routeAmount[slot]) >> 8;
+  }
+  for (byte o = 0; o < MOD_OUTPUT_COUNT; o++) {
+    if (modFactors[o] < 0) modFactors[o] = 0;
+    else if (modFactors[o] > MOD_FACTOR_MAX) modFactors[o] = MOD_FACTOR_MAX;
+  }
+  // A zero master time would mean infinite speed
+  byte master = outputIndex(MOD_DEST_MASTER, 0);
+  if (modFactors[master] < MOD_MASTER_FACTOR_MIN) modFactors[master] = MOD_MASTER_FACTOR_MIN;
+
+  unsigned long elapsed = micros() - startMicros;
+  if (elapsed > peakMicros) peakMicros = elapsed;
+}
+
+int32_t getModFactor(byte destination, byte wheel) {
+  return modFactors[outputIndex(destination, wheel)];
+}
+
+// --- Text Interface ---
+
+bool parseModSource(const char* name, byte& source) {
+  if (strncmp(name, "lfo", 3) == 0 && name[3] >= '1' && name[3] <= '0' + MOTORS_COUNT && name[4] == '\0') {
+    source = MOD_SRC_LFO1 + (name[3] - '1');
+    return true;
+  }
+  if (strcmp(name, "env") == 0) { source = MOD_SRC_ENVELOPE; return true; }
+  if (strcmp(name, "rev") == 0) { source = MOD_SRC_REV_COUNTER; return true; }
+  return false;
+}
+
+bool parseModDestination(const char* name, byte& destination, byte& wheel) {
+  if (strcmp(name, "master") == 0) {
+    destination = MOD_DEST_MASTER;
+    wheel = 0;
+    return true;
+  }
+
+  byte prefixLength;
+  if (strncmp(name, "speed", 5) == 0) { destination = MOD_DEST_SPEED; prefixLength = 5; }
+  else if (strncmp(name, "rate", 4) == 0) { destination = MOD_DEST_LFO_RATE; prefixLength = 4; }
+  else if (strncmp(name, "depth", 5) == 0) { destination = MOD_DEST_LFO_DEPTH; prefixLength = 5; }
+  else return false;
+
+  char digit = name[prefixLength];
+  if (digit < '1' || digit > '0' + MOTORS_COUNT || name[prefixLength + 1] != '\0') return false;
+  wheel = digit - '1';
+  return true;
+}
+
+void printModMatrix() {
+  Serial.println(F("\n--- Modulation Matrix ---"));
+  if (routeMask == 0) {
+    Serial.println(F("No routes"));
+    return;
+  }
+
+  for (byte slot = 0; slot < MOD_ROUTE_COUNT; slot++) {
+    if (!(routeMask & (1 << slot))) continue;
+    const ModRoute& route = routes[slot];
+    Serial.print(slot + 1); Serial.print(F(": "));
+    printSourceName(route.source);
+    Serial.print(F(" -> "));
+    printDestinationName(route.destination, route.wheel);
+    Serial.print(F(" "));
+    if (route.amount >= 0) Serial.print(F("+"));
+    Serial.print((int)route.amount); Serial.println(F("%"));
+  }
+
+  Serial.print(F("Envelope: ")); Serial.print((envelopeLevel >> 16) * 100 / 32767);
+  Serial.print(F("%  Rev counter: ")); Serial.print((counterLevel >> 16) * 100 / 32767);
+  Serial.println(F("%"));
+  Serial.print(F("Peak: ")); Serial.print(peakMicros);
+  Serial.print(F(" us/tick (budget ")); Serial.print(MOD_TICK_BUDGET_US);
+  Serial.println(peakMicros > MOD_TICK_BUDGET_US ? F(" us) - OVER BUDGET") : F(" us)"));
+}
+
+// --- Internal Helpers ---
+
+static byte outputIndex(byte destination, byte wheel) {
+  if (destination == MOD_DEST_MASTER) return MOD_OUTPUT_COUNT - 1;
+  return destination * MOTORS_COUNT + wheel;
+}
+
+static void rebuildSourceMask() {
+  sourceMask = 0;
+  for (byte slot = 0; slot < MOD_ROUTE_COUNT; slot++) {
+    if (routeMask & (1 << slot)) sourceMask |= (1 << routes[slot].source);
+  }
+}
+
+static void resetModFactors() {
+  for (byte o = 0; o < MOD_OUTPUT_COUNT; o++) {
+    modFactors[o] = MOD_FACTOR_UNITY;
+  }
+}
+
+// Bipolar sine of an LFO phase in Q15, from the quarter-wave table
+static int16_t sineQ15(unsigned int phase) {
+  byte index = (byte)(((unsigned long)phase * SINE_INDEX_SCALE) >> 16);
+  byte offset = index & 63;
+  switch (index >> 6) {
+    case 0: return (int16_t)pgm_read_word(&sineQuarter[offset]);
+    case 1: return (int16_t)pgm_read_word(&sineQuarter[64 - offset]);
+    case 2: return -(int16_t)pgm_read_word(&sineQuarter[offset]);
+    default: return -(int16_t)pgm_read_word(&sineQuarter[64 - offset]);
+  }
+}
+
+static void printSourceName(byte source) {
+  if (source < MOD_SRC_ENVELOPE) {
+    Serial.print(F("lfo")); Serial.print(source - MOD_SRC_LFO1 + 1);
+  } else {
+    Serial.print(source == MOD_SRC_ENVELOPE ? F("env") : F("rev"));
+  }
+}
+
+static void printDestinationName(byte destination, byte wheel) {
+  switch (destination) {
+    case MOD_DEST_SPEED: Serial.print(F("speed")); break;
+    case MOD_DEST_LFO_RATE: Serial.print(F("rate")); break;
+    case MOD_DEST_LFO_DEPTH: Serial.print(F("depth")); break;
+    default: Serial.print(F("master")); return;
+  }
+  Serial.print(wheel + 1);
+}
@@ -0,0 +1,61 @@
+/**
+ * ModMatrix.h
+ *
+ * Modulation matrix routing LFOs, an envelope and the master revolution
+ * counter to wheel speed, LFO rate, LFO depth and master time
+ * for the Cycloid Machine
+ */
+
+#ifndef MOD_MATRIX_H
+#define MOD_MATRIX_H
+
+#include "Config.h"
+
+// Modulation sources (LFOs are read as a bipolar sine, the others ramp 0..1)
+enum ModSource {
+  MOD_SRC_LFO1 = 0,       // MOD_SRC_LFO1 + wheel index
+  MOD_SRC_ENVELOPE = MOTORS_COUNT,
+  MOD_SRC_REV_COUNTER,
+  MOD_SRC_COUNT
+};
+
+// Modulation destinations; all but master time take a wheel index
+enum ModDestination {
+  MOD_DEST_SPEED = 0,
+  MOD_DEST_LFO_RATE,
+  MOD_DEST_LFO_DEPTH,
+  MOD_DEST_MASTER
+};
+
+// One route: destination value is scaled by 1 + source * amount / 100
+struct ModRoute {
+  byte source;        // ModSource
+  byte destination;   // ModDestination
+  byte wheel;         // 0-based, ignored for MOD_DEST_MASTER
+  int8_t amount;      // -100..100 %
+};
+
+// --- Route Table (0-based slot, MOD_ROUTE_COUNT slots) ---
+bool setModRoute(byte slot, const ModRoute& route);
+void clearModRoute(byte slot);
+void clearModRoutes();
+bool getModRoute(byte slot, ModRoute& route);   // False if the slot is empty
+bool isModMatrixActive();                       // True if any route is set
+
+// Restart the envelope; it rises from 0 to 1 over lengthMillis
+void triggerModEnvelope(unsigned long lengthMillis);
+
+// Evaluate every route in fixed point - called from updateMotors() on each
+// LFO tick. lfoPhases are 0..LFO_RESOLUTION-1, masterTimeMillis is the
+// unmodulated master time.
+void serviceModMatrix(unsigned long deltaMillis, const unsigned int* lfoPhases, unsigned long masterTimeMillis);
+
+// Combined factor for a destination in Q15 (32768 = unmodulated)
+int32_t getModFactor(byte destination, byte wheel);
+
+// --- Text Interface ---
+bool parseModSource(const char* name, byte& source);                 // lfo1-4, env, rev
+bool parseModDestination(const char* name, byte& destination, byte& wheel); // speed1-4, rate1-4, depth1-4, master
+void printModMatrix();
+
+#endif // MOD_MATRIX_H
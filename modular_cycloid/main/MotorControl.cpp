@@ -7,7 +7,13 @@
 #include <Arduino.h>
 #include <AccelStepper.h>
 #include <math.h>
+#include <limits.h>
 #include "MotorControl.h"
+#include "SettingsStore.h"
+#include "Sequencer.h"
+#include "PresetMorph.h"
+#include "ModMatrix.h"
+#include "MenuSystem.h"
 #include "Config.h"
 
 // NOTE: Stepper instances (stepperX, stepperY, etc.) and the 
@@ -28,32 +34,122 @@ struct MotorSetting {
   float lfoDepth;    // LFO depth (0-100%)
   float lfoRate;     // LFO rate in Hz
   bool lfoPolarity;  // false = unipolar, true = bipolar
-  unsigned int lfoPhase; // Current phase of the LFO (0-LFO_RESOLUTION-1)
 };
 
-static MotorSetting motorSettings[MOTORS_COUNT];
+// One complete parameter snapshot
+struct MotorParams {
+  MotorSetting motors[MOTORS_COUNT];
+  float masterTime;  // Master time (period) in milliseconds for one rotation at speed 1.0
+};
+
+// Double-buffered parameters. Setters edit the staging buffer freely;
+// commitMotorSettings() asks updateMotors() to swap the pointers at its
+// next tick, so the hot path only ever reads a complete, consistent set.
+static MotorParams paramBuffers[2];
+static MotorParams* activeParams = &paramBuffers[0];  // Read by the step-rate hot path only
+static MotorParams* stagingParams = &paramBuffers[1]; // Written by setters, read by getters
+static bool commitPending = false;
+static void swapParamBuffers();
 
-// Master time (period) in milliseconds for one rotation at speed 1.0
-static float masterTime = DEFAULT_MASTER_TIME;
+// Current phase of each LFO (0-LFO_RESOLUTION-1), runtime state not a setting
+static unsigned int lfoPhase[MOTORS_COUNT];
 
 // Microstepping mode (software value, must match hardware jumpers)
 static byte currentMicrostepMode = DEFAULT_MICROSTEP;
+static byte stagedMicrostepMode = 0;  // Set by setMachineSettings(), applied on commit (0 = none)
+static DriverType driverType = DEFAULT_DRIVER_TYPE; // Selects the DIL switch table
 
 // LFO update timing
 static unsigned long lastMotorUpdateTime = 0;
 
+// Bumped by every commit so SettingsStore can detect unsaved changes
+static unsigned int settingsRevision = 0;
+
+// --- Streamed Motion Segments ---
+#define SEGMENT_FLAG_RAMP 0x01  // Interpolate from the previous rates
+#define SEGMENT_FLAG_END 0x02   // Marker: stream finished, not an underrun
+
+struct MotionSegment {
+  float wheelSpeed[MOTORS_COUNT]; // Target speed ratio per wheel
+  unsigned int durationMs;
+  byte flags;                     // SEGMENT_FLAG_* bits
+};
+
+// Fixed ring filled by the serial parser, drained at the motor update tick
+static MotionSegment segmentQueue[SEGMENT_QUEUE_SIZE];
+static byte segmentHead = 0;    // Next segment to execute
+static byte segmentCount = 0;
+
+static bool streamActive = false;
+static bool segmentRunning = false;  // False while starved between segments
+static MotionSegment currentSegment;
+static unsigned int segmentElapsed = 0;          // ms into currentSegment
+static float segmentStartSpeed[MOTORS_COUNT];    // Ramp origin
+static float streamSpeed[MOTORS_COUNT];          // Speed ratios applied this tick
+static unsigned int streamUnderruns = 0;
+
+static void advanceMotionStream(unsigned long deltaMillis);
+static bool startNextSegment();
+
+// --- Coordinated Pause/Resume ---
+// Pausing and resuming scale every wheel's step rate by the same factor,
+// so the wheels stay in ratio while they stop and start. Timelines (LFO,
+// segments, sequencer, morph) advance by the scaled time, which keeps them
+// locked to distance travelled and frozen while stopped.
+enum MotionState {
+  MOTION_STOPPED,
+  MOTION_RAMP_UP,
+  MOTION_RUNNING,
+  MOTION_RAMP_DOWN
+};
+
+static MotionState motionState = MOTION_STOPPED;
+static float speedScale = 0.0;              // 0 = stopped, 1 = full speed
+static float scaledMillisCarry = 0.0;       // Fraction of a ms not yet passed on
+static long rampOrigin[MOTORS_COUNT];       // Positions when the ramp-down began
+static float rampRate[MOTORS_COUNT];        // Full-scale step rates at that moment
+
+static void beginRampDown();
+static bool updateSpeedScale(unsigned long deltaMillis);
+static unsigned long scaledMillis(unsigned long deltaMillis);
+static void reportStopPhaseError();
+static long rescaleSteps(long steps, byte fromMode, byte toMode);
+static void rescaleStepState(byte fromMode, byte toMode);
+
+// --- Step Rate Budget ---
+static float limitScale = 1.0;            // < 1 while demand exceeds STEP_RATE_BUDGET
+static unsigned long loopPasses = 0;      // updateMotors() calls in the current window
+static unsigned long loopWindowStart = 0;
+static unsigned long loopRate = 0;        // Passes per second, last full window
+
+// --- Auto-Stop ---
+// The pause ramp starts early by the distance it covers, so it ends on target
+static bool autoStopArmed = false;
+static bool autoStopStopping = false;       // Ramp-down triggered by auto-stop
+static byte autoStopWheel = 0;              // Fastest wheel, used as the step reference
+static long autoStopOrigin = 0;             // Its position when armed
+static unsigned long autoStopTarget = 0;    // Steps from origin to the end of the ramp (at most LONG_MAX)
+static unsigned long autoStopTrigger = 0;   // Steps from origin where the ramp begins
+static unsigned long autoStopRampSteps = 0; // Ramp distance at full speed; shrinks with limitScale
+static unsigned long autoStopTravel();
+static void updateAutoStopTrigger();
+
 // Forward declaration for internal reset helper
 static void resetMotorSettings();
 
 // --- Motor Setup ---
 void setupMotors() {
-  // Initialize motor settings to defaults
+  // Initialize motor settings to defaults, then overlay any stored record
   resetMotorSettings();
+  restoreSettings();
+  
+  // Nothing is moving yet, so make the staged settings live immediately
+  swapParamBuffers();
   
   // Apply initial settings to AccelStepper objects
   for (byte i = 0; i < MOTORS_COUNT; i++) {
     // Use the externally defined steppers array
-    steppers[i]->setMaxSpeed(10000.0 * currentMicrostepMode); // Max speed depends on microsteps
+    steppers[i]->setMaxSpeed(STEP_RATE_BUDGET); // No single axis can exceed the aggregate budget
     steppers[i]->setAcceleration(2000.0 * currentMicrostepMode); // Acceleration also scales
     steppers[i]->setSpeed(0); // Start stopped
   }
@@ -70,18 +166,35 @@ void setupMotors() {
 
 // --- Motor Control ---
 void updateMotors(unsigned long currentMillis, bool paused) {
-  // Stop motors immediately if paused
-  if (paused) {
+  // Loop rate bounds the per-axis step rate (one step per runSpeed call)
+  loopPasses++;
+  if (currentMillis - loopWindowStart >= 1000) {
+    loopRate = loopPasses;
+    loopPasses = 0;
+    loopWindowStart = currentMillis;
+  }
+  
+  // Pause and resume ramp all wheels together rather than stopping dead
+  if (paused && (motionState == MOTION_RUNNING || motionState == MOTION_RAMP_UP)) {
+    beginRampDown();
+  } else if (!paused && (motionState == MOTION_STOPPED || motionState == MOTION_RAMP_DOWN)) {
+    motionState = MOTION_RAMP_UP;
+  }
+  
+  // Fully stopped
+  if (motionState == MOTION_STOPPED) {
+    // Nothing is moving, so committed settings can land right away
+    if (commitPending) swapParamBuffers();
+    
+    // Keep the tick clock current so LFOs and segments resume without a jump
+    lastMotorUpdateTime = currentMillis;
+    
     // Ensure motors are stopped if they were moving
     for (byte i = 0; i < MOTORS_COUNT; i++) {
       if (steppers[i]->speed() != 0) {
         steppers[i]->setSpeed(0);
       }
     }
-    // We still need to call runSpeed() to potentially decelerate
-    for (byte i = 0; i < MOTORS_COUNT; i++) {
-        steppers[i]->runSpeed();
-    }
     return; 
   }
   
@@ -89,25 +202,74 @@ void updateMotors(unsigned long currentMillis, bool paused) {
   unsigned long deltaMillis = currentMillis - lastMotorUpdateTime;
   if (deltaMillis >= LFO_UPDATE_INTERVAL) {
     bool speedNeedsUpdate = false; // Flag if any LFO caused a change
+    lastMotorUpdateTime = currentMillis;
     
-    // Update LFO phases first
+    if (!updateSpeedScale(deltaMillis)) {
+      // Ramp-down finished this tick
+      for (byte i = 0; i < MOTORS_COUNT; i++) {
+        steppers[i]->setSpeed(0);
+      }
+      reportStopPhaseError();
+      return;
+    }
+    
+    // Timelines follow the distance travelled, not the wall clock
+    unsigned long timelineMillis = scaledMillis(deltaMillis);
+    
+    // Sequencer and morph edits commit here and land in the swap just below
+    serviceSequencer(timelineMillis);
+    serviceMorph(timelineMillis);
+    
+    // Swap in committed settings before any wheel's speed is recomputed,
+    // so every axis changes within this same tick
+    if (commitPending) swapParamBuffers();
+    
+    // Segment boundaries are resolved on the tick, so timing never drifts
+    if (streamActive) advanceMotionStream(timelineMillis);
+    
+    // Update LFO phases first. With the matrix on, an LFO at zero depth
+    // still runs so it can act purely as a modulation source.
+    bool modActive = isModMatrixActive();
     for (byte i = 0; i < MOTORS_COUNT; i++) {
-      if (motorSettings[i].lfoRate > 0 && motorSettings[i].lfoDepth > 0) {
-        unsigned int phaseIncrement = (unsigned int)((motorSettings[i].lfoRate * deltaMillis * LFO_RESOLUTION) / 1000);
-        motorSettings[i].lfoPhase = (motorSettings[i].lfoPhase + phaseIncrement) % LFO_RESOLUTION;
+      const MotorSetting& motor = activeParams->motors[i];
+      if (motor.lfoRate > 0 && (motor.lfoDepth > 0 || modActive)) {
+        float rate = motor.lfoRate;
+        if (modActive) rate *= getModFactor(MOD_DEST_LFO_RATE, i) * (1.0 / 32768.0);
+        unsigned int phaseIncrement = (unsigned int)((rate * timelineMillis * LFO_RESOLUTION) / 1000);
+        lfoPhase[i] = (lfoPhase[i] + phaseIncrement) % LFO_RESOLUTION;
         speedNeedsUpdate = true; // LFO is active, speed calculation needed
       }
     }
     
+    // Modulation matrix runs on the fresh phases, before any speed is computed
+    if (modActive) serviceModMatrix(timelineMillis, lfoPhase, (unsigned long)activeParams->masterTime);
+    
+    // Auto-stop check: one integer comparison per tick
+    if (autoStopArmed && autoStopTravel() >= autoStopTrigger) {
+      autoStopArmed = false;
+      autoStopStopping = true;
+      Serial.println(F("Auto-stop: ramping down"));
+      setSystemPaused(true); // Ramp-down starts on the next pass
+    }
+    
     // Update motor speeds if LFO is active or if base speed potentially changed
     // For simplicity, we recalculate speeds every interval if not paused.
     // Optimization: could track if settings changed, but interval is small.
+    float stepRates[MOTORS_COUNT];
+    float demand = 0;
     for (byte i = 0; i < MOTORS_COUNT; i++) {
-      float stepsPerSecond = calculateMotorStepRate(i);
-      steppers[i]->setSpeed(stepsPerSecond);
+      stepRates[i] = calculateMotorStepRate(i);
+      demand += fabs(stepRates[i]);
     }
     
-    lastMotorUpdateTime = currentMillis;
+    // Over budget: slow every wheel by the same factor so the drawing keeps
+    // its shape (timelines follow via scaledMillis) instead of dropping steps
+    limitScale = (demand > STEP_RATE_BUDGET) ? STEP_RATE_BUDGET / demand : 1.0;
+    if (autoStopArmed) updateAutoStopTrigger();
+    
+    for (byte i = 0; i < MOTORS_COUNT; i++) {
+      steppers[i]->setSpeed(stepRates[i] * limitScale * speedScale);
+    }
   }
   
   // Run the motors (this needs to be called frequently)
@@ -122,17 +284,30 @@ float calculateMotorStepRate(byte motorIndex) {
   // Speed (Revolutions per Second) = (1 / masterTime_seconds) * wheelSpeed_ratio
   // Steps per Second = Speed (RPS) * stepsPerRev
   // masterTime is in ms, so masterTime_seconds = masterTime / 1000.0
-  // RPS = (1000.0 / masterTime) * motorSettings[motorIndex].wheelSpeed
-  float baseStepsPerSecond = (1000.0 / masterTime) * motorSettings[motorIndex].wheelSpeed * stepsPerRev;
+  // RPS = (1000.0 / masterTime) * wheelSpeed
+  // Reads only the active snapshot - never the staging buffer
+  const MotorSetting& motor = activeParams->motors[motorIndex];
+  float wheelSpeed = streamActive ? streamSpeed[motorIndex] : motor.wheelSpeed;
+  float masterTime = activeParams->masterTime;
+  float lfoDepth = motor.lfoDepth;
+  
+  // Modulation matrix factors (Q15) scale the settings, never replace them
+  if (isModMatrixActive()) {
+    wheelSpeed *= getModFactor(MOD_DEST_SPEED, motorIndex) * (1.0 / 32768.0);
+    masterTime *= getModFactor(MOD_DEST_MASTER, 0) * (1.0 / 32768.0);
+    lfoDepth *= getModFactor(MOD_DEST_LFO_DEPTH, motorIndex) * (1.0 / 32768.0);
+    if (lfoDepth > LFO_DEPTH_MAX) lfoDepth = LFO_DEPTH_MAX;
+  }
+  float baseStepsPerSecond = (1000.0 / masterTime) * wheelSpeed * stepsPerRev;
   
   // Apply LFO if enabled
-  if (motorSettings[motorIndex].lfoDepth > 0) {
-    float sinVal = sin(2.0 * PI * motorSettings[motorIndex].lfoPhase / LFO_RESOLUTION);
+  if (lfoDepth > 0) {
+    float sinVal = sin(2.0 * PI * lfoPhase[motorIndex] / LFO_RESOLUTION);
     float lfoFactor;
-    if (motorSettings[motorIndex].lfoPolarity) { // Bipolar
-      lfoFactor = 1.0 + sinVal * (motorSettings[motorIndex].lfoDepth / 100.0);
+    if (motor.lfoPolarity) { // Bipolar
+      lfoFactor = 1.0 + sinVal * (lfoDepth / 100.0);
     } else { // Unipolar
-      lfoFactor = 1.0 + (sinVal + 1.0) * 0.5 * (motorSettings[motorIndex].lfoDepth / 100.0);
+      lfoFactor = 1.0 + (sinVal + 1.0) * 0.5 * (lfoDepth / 100.0);
     }
     return baseStepsPerSecond * lfoFactor;
   }
@@ -141,11 +316,9 @@ float calculateMotorStepRate(byte motorIndex) {
 }
 
 void stopAllMotors() {
-  for (byte i = 0; i < MOTORS_COUNT; i++) {
-    steppers[i]->stop(); // Use stop() for abrupt stop with deceleration if configured
-    // or steppers[i]->setSpeed(0); for immediate speed change
-  }
-  Serial.println(F("Motors stopped"));
+  // The stop itself is the coordinated ramp in updateMotors() once the
+  // pause flag is seen; stopping each axis here would break the ratios
+  Serial.println(F("Motors stopping"));
 }
 
 void enableAllMotors() {
@@ -177,24 +350,63 @@ bool updateMicrostepMode(byte newMode) {
   
   // Only update if the mode has changed
   if (newMode != currentMicrostepMode) {
+      // Runs between runSpeed() calls, so no step is in flight: convert
+      // every step-based quantity so angle and speed carry straight over
+      rescaleStepState(currentMicrostepMode, newMode);
       currentMicrostepMode = newMode;
+      settingsRevision++;
       
       // Update steps per revolution based on the new mode
       stepsPerRev = 200 * currentMicrostepMode;
       
       // Update AccelStepper parameters (MaxSpeed/Acceleration scale with microsteps)
       for (byte i = 0; i < MOTORS_COUNT; i++) {
-        steppers[i]->setMaxSpeed(10000.0 * currentMicrostepMode);
         steppers[i]->setAcceleration(2000.0 * currentMicrostepMode);
       }
       
       Serial.print(F("Microstep mode set to: "));
       Serial.println(currentMicrostepMode);
+      if (getStepRateHeadroom(currentMicrostepMode) < 0) {
+        Serial.println(F("Warning: settings exceed the step rate budget, wheels will be slowed"));
+      }
   } 
   return true;
   // NOTE: No digitalWrite calls for MS1/MS2/MS3 - jumpers handle this.
 }
 
+// Convert a step count between microstep modes, rounding to the nearest step
+static long rescaleSteps(long steps, byte fromMode, byte toMode) {
+  int64_t scaled = (int64_t)steps * toMode;
+  int64_t half = fromMode / 2;
+  return (long)((scaled >= 0 ? scaled + half : scaled - half) / fromMode);
+}
+
+// Rescale positions, speeds and step-based bookkeeping to a new mode
+static void rescaleStepState(byte fromMode, byte toMode) {
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    // setCurrentPosition() zeroes the speed, so restore it scaled afterwards
+    float speed = steppers[i]->speed();
+    steppers[i]->setCurrentPosition(rescaleSteps(steppers[i]->currentPosition(), fromMode, toMode));
+    steppers[i]->setSpeed(speed * toMode / fromMode);
+    
+    rampOrigin[i] = rescaleSteps(rampOrigin[i], fromMode, toMode);
+    rampRate[i] = rampRate[i] * toMode / fromMode;
+  }
+  
+  autoStopOrigin = rescaleSteps(autoStopOrigin, fromMode, toMode);
+  if (!isAutoStopArmed()) return;
+  // A finer mode can push the target past what a long position holds
+  int64_t target = (int64_t)autoStopTarget * toMode / fromMode;
+  if (target > LONG_MAX) {
+    disarmAutoStop();
+    Serial.println(F("Auto-stop off: target too far at this microstep mode"));
+    return;
+  }
+  autoStopTarget = (unsigned long)target;
+  autoStopRampSteps = (unsigned long)((int64_t)autoStopRampSteps * toMode / fromMode);
+  updateAutoStopTrigger();
+}
+
 unsigned long getStepsPerWheelRev() {
   return stepsPerRev;
 }
@@ -202,32 +414,36 @@ unsigned long getStepsPerWheelRev() {
 // --- Getter Functions ---
 float getWheelSpeed(byte motorIndex) {
   if (motorIndex >= MOTORS_COUNT) return 0.0;
-  return motorSettings[motorIndex].wheelSpeed;
+  return stagingParams->motors[motorIndex].wheelSpeed;
 }
 
 float getLfoDepth(byte motorIndex) {
   if (motorIndex >= MOTORS_COUNT) return 0.0;
-  return motorSettings[motorIndex].lfoDepth;
+  return stagingParams->motors[motorIndex].lfoDepth;
 }
 
 float getLfoRate(byte motorIndex) {
   if (motorIndex >= MOTORS_COUNT) return 0.0;
-  return motorSettings[motorIndex].lfoRate;
+  return stagingParams->motors[motorIndex].lfoRate;
 }
 
 bool getLfoPolarity(byte motorIndex) {
   if (motorIndex >= MOTORS_COUNT) return false;
-  return motorSettings[motorIndex].lfoPolarity;
+  return stagingParams->motors[motorIndex].lfoPolarity;
 }
 
 float getMasterTime() {
-  return masterTime;
+  return stagingParams->masterTime;
 }
 
 byte getCurrentMicrostepMode() {
   return currentMicrostepMode;
 }
 
+unsigned int getSettingsRevision() {
+  return settingsRevision;
+}
+
 float getCurrentActualSpeed(byte motorIndex) {
   // Return the actual calculated speed in steps/sec for diagnostics
   if (motorIndex >= MOTORS_COUNT) return 0.0;
@@ -236,6 +452,367 @@ float getCurrentActualSpeed(byte motorIndex) {
   // To return RPM: (calculateMotorStepRate(motorIndex) / stepsPerRev) * 60.0
 }
 
+// --- Whole-Machine Access ---
+void getMachineSettings(MachineSettings& settings) {
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    settings.wheels[i].wheelSpeed = stagingParams->motors[i].wheelSpeed;
+    settings.wheels[i].lfoDepth = stagingParams->motors[i].lfoDepth;
+    settings.wheels[i].lfoRate = stagingParams->motors[i].lfoRate;
+    settings.wheels[i].lfoPolarity = stagingParams->motors[i].lfoPolarity;
+  }
+  settings.masterTime = stagingParams->masterTime;
+  settings.microstepMode = stagedMicrostepMode ? stagedMicrostepMode : currentMicrostepMode;
+}
+
+void setMachineSettings(const MachineSettings& settings) {
+  // Go through the setters so every value is range-checked
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    setWheelSpeed(i, settings.wheels[i].wheelSpeed);
+    setLfoDepth(i, settings.wheels[i].lfoDepth);
+    setLfoRate(i, settings.wheels[i].lfoRate);
+    setLfoPolarity(i, settings.wheels[i].lfoPolarity);
+  }
+  setMasterTime(settings.masterTime);
+  // Rescaling positions and stepsPerRev is as much a change of settings
+  // as the rest, so it waits for the commit too
+  stagedMicrostepMode = settings.microstepMode;
+}
+
+// --- Snapshot Commit ---
+void commitMotorSettings() {
+  // Step rates are only recomputed at the tick, so the new stepsPerRev
+  // takes effect together with the committed snapshot
+  if (stagedMicrostepMode) {
+    updateMicrostepMode(stagedMicrostepMode);
+    stagedMicrostepMode = 0;
+  }
+  commitPending = true;
+  settingsRevision++;
+}
+
+// Make the staging buffer live (called from updateMotors/setupMotors only)
+static void swapParamBuffers() {
+  MotorParams* committed = stagingParams;
+  stagingParams = activeParams;
+  activeParams = committed;
+  // Further edits continue from the values just committed
+  *stagingParams = *activeParams;
+  commitPending = false;
+}
+
+// --- Streamed Motion Segments ---
+bool queueMotionSegment(const float* wheelSpeeds, unsigned int durationMs, bool ramp) {
+  if (segmentCount >= SEGMENT_QUEUE_SIZE || durationMs == 0) return false;
+  
+  if (!streamActive) {
+    // Ramps in the first segment start from whatever the wheels run at now
+    for (byte i = 0; i < MOTORS_COUNT; i++) {
+      streamSpeed[i] = activeParams->motors[i].wheelSpeed;
+    }
+    streamActive = true;
+    segmentRunning = false;
+  }
+  
+  MotionSegment& segment = segmentQueue[(segmentHead + segmentCount) % SEGMENT_QUEUE_SIZE];
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    float speed = wheelSpeeds[i];
+    if (speed < WHEEL_SPEED_MIN) speed = WHEEL_SPEED_MIN;
+    else if (speed > WHEEL_SPEED_MAX) speed = WHEEL_SPEED_MAX;
+    segment.wheelSpeed[i] = speed;
+  }
+  segment.durationMs = durationMs;
+  segment.flags = ramp ? SEGMENT_FLAG_RAMP : 0;
+  segmentCount++;
+  return true;
+}
+
+bool queueMotionStreamEnd() {
+  if (!streamActive || segmentCount >= SEGMENT_QUEUE_SIZE) return false;
+  MotionSegment& segment = segmentQueue[(segmentHead + segmentCount) % SEGMENT_QUEUE_SIZE];
+  segment.durationMs = 0;
+  segment.flags = SEGMENT_FLAG_END;
+  segmentCount++;
+  return true;
+}
+
+void stopMotionStream() {
+  segmentHead = 0;
+  segmentCount = 0;
+  segmentRunning = false;
+  streamActive = false;
+}
+
+bool isMotionStreamActive() {
+  return streamActive;
+}
+
+byte getSegmentCredits() {
+  return SEGMENT_QUEUE_SIZE - segmentCount;
+}
+
+unsigned int getStreamUnderrunCount() {
+  return streamUnderruns;
+}
+
+// Advance the executing segment by one tick and compute streamSpeed
+static void advanceMotionStream(unsigned long deltaMillis) {
+  if (!segmentRunning) {
+    // Starved (or just started): hold the last rates until data arrives
+    if (!startNextSegment()) return;
+  } else {
+    segmentElapsed += deltaMillis;
+  }
+  
+  // Carry any overshoot into the following segment so there are no gaps
+  while (segmentRunning && segmentElapsed >= currentSegment.durationMs) {
+    unsigned int overshoot = segmentElapsed - currentSegment.durationMs;
+    for (byte i = 0; i < MOTORS_COUNT; i++) {
+      streamSpeed[i] = currentSegment.wheelSpeed[i];
+    }
+    if (!startNextSegment()) {
+      if (streamActive) streamUnderruns++;
+      return;
+    }
+    segmentElapsed = overshoot;
+  }
+  if (!segmentRunning) return;
+  
+  if (currentSegment.flags & SEGMENT_FLAG_RAMP) {
+    float fraction = (float)segmentElapsed / currentSegment.durationMs;
+    for (byte i = 0; i < MOTORS_COUNT; i++) {
+      streamSpeed[i] = segmentStartSpeed[i] + (currentSegment.wheelSpeed[i] - segmentStartSpeed[i]) * fraction;
+    }
+  } else {
+    for (byte i = 0; i < MOTORS_COUNT; i++) {
+      streamSpeed[i] = currentSegment.wheelSpeed[i];
+    }
+  }
+}
+
+// Pop the next queued segment; false if the queue is empty or the stream ended
+static bool startNextSegment() {
+  segmentRunning = false;
+  if (segmentCount == 0) return false;
+  
+  currentSegment = segmentQueue[segmentHead];
+  segmentHead = (segmentHead + 1) % SEGMENT_QUEUE_SIZE;
+  segmentCount--;
+  
+  if (currentSegment.flags & SEGMENT_FLAG_END) {
+    stopMotionStream();
+    return false;
+  }
+  
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    segmentStartSpeed[i] = streamSpeed[i];
+  }
+  segmentElapsed = 0;
+  segmentRunning = true;
+  return true;
+}
+
+// --- Auto-Stop ---
+// Fastest staged wheel ratio, and its index in wheel
+static float fastestWheel(byte& wheel) {
+  float fastest = 0;
+  wheel = 0;
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    if (fabs(stagingParams->motors[i].wheelSpeed) > fastest) {
+      fastest = fabs(stagingParams->motors[i].wheelSpeed);
+      wheel = i;
+    }
+  }
+  return fastest;
+}
+
+float getAutoStopRevsLimit() {
+  byte wheel;
+  float fastest = fastestWheel(wheel);
+  if (fastest == 0) return 0;
+  return (float)LONG_MAX / (fastest * stepsPerRev);
+}
+
+bool armAutoStop(float masterRevs) {
+  // Reference the fastest wheel for the finest step resolution
+  byte wheel;
+  float fastest = fastestWheel(wheel);
+  if (fastest == 0 || masterRevs <= 0) return false;
+  
+  // The reference position is a long, so its travel must fit one
+  float target = masterRevs * fastest * stepsPerRev + 0.5;
+  if (!(target < (float)LONG_MAX)) return false;
+  autoStopWheel = wheel;
+  autoStopTarget = (unsigned long)target;
+  
+  // A linear ramp to zero covers half the distance of full speed
+  float stepsPerSecond = (1000.0 / stagingParams->masterTime) * fastest * stepsPerRev;
+  autoStopRampSteps = (unsigned long)(stepsPerSecond * PAUSE_RAMP_MS / 2000.0);
+  updateAutoStopTrigger();
+  
+  autoStopOrigin = steppers[autoStopWheel]->currentPosition();
+  autoStopStopping = false;
+  autoStopArmed = true;
+  return true;
+}
+
+void disarmAutoStop() {
+  autoStopArmed = false;
+  autoStopStopping = false;
+}
+
+bool isAutoStopArmed() {
+  return autoStopArmed || autoStopStopping;
+}
+
+float getAutoStopRemainingRevs() {
+  if (!isAutoStopArmed()) return 0;
+  long remaining = (long)autoStopTarget - (long)autoStopTravel();
+  if (remaining < 0) remaining = 0;
+  return remaining / (fabs(stagingParams->motors[autoStopWheel].wheelSpeed) * stepsPerRev);
+}
+
+// Steps the reference wheel has moved since arming, either way. Unsigned
+// arithmetic keeps this right when the position wraps past LONG_MAX.
+static unsigned long autoStopTravel() {
+  unsigned long travel = (unsigned long)steppers[autoStopWheel]->currentPosition() - (unsigned long)autoStopOrigin;
+  return (travel > (unsigned long)LONG_MAX) ? 0UL - travel : travel;
+}
+
+// The ramp starts early by the distance it covers at the current speed,
+// which the step rate budget may have scaled down
+static void updateAutoStopTrigger() {
+  unsigned long rampSteps = (unsigned long)(autoStopRampSteps * limitScale);
+  autoStopTrigger = (autoStopTarget > rampSteps) ? autoStopTarget - rampSteps : 0;
+}
+
+// --- Coordinated Pause/Resume ---
+
+// Start the pause ramp from whatever scale the wheels are at now
+static void beginRampDown() {
+  motionState = MOTION_RAMP_DOWN;
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    rampOrigin[i] = steppers[i]->currentPosition();
+    rampRate[i] = calculateMotorStepRate(i);
+  }
+}
+
+// Move speedScale along the active ramp; false once the ramp-down ends
+static bool updateSpeedScale(unsigned long deltaMillis) {
+  float step = (float)deltaMillis / PAUSE_RAMP_MS;
+  
+  if (motionState == MOTION_RAMP_UP) {
+    speedScale += step;
+    if (speedScale >= 1.0) {
+      speedScale = 1.0;
+      motionState = MOTION_RUNNING;
+    }
+  } else if (motionState == MOTION_RAMP_DOWN) {
+    speedScale -= step;
+    if (speedScale <= 0.0) {
+      speedScale = 0.0;
+      motionState = MOTION_STOPPED;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Tick length scaled by the ramp and budget factors (the budget factor is
+// from the previous tick), carrying the fractional ms forward
+static unsigned long scaledMillis(unsigned long deltaMillis) {
+  if (motionState == MOTION_RUNNING && limitScale == 1.0) return deltaMillis;
+  
+  float scaled = deltaMillis * speedScale * limitScale + scaledMillisCarry;
+  unsigned long whole = (unsigned long)scaled;
+  scaledMillisCarry = scaled - whole;
+  return whole;
+}
+
+// Compare each wheel's ramp-down travel with the fastest wheel's, scaled
+// by their step rates; any difference is the ratio error left by the stop
+static void reportStopPhaseError() {
+  byte reference = 0;
+  for (byte i = 1; i < MOTORS_COUNT; i++) {
+    if (fabs(rampRate[i]) > fabs(rampRate[reference])) reference = i;
+  }
+  
+  Serial.print(F("Stopped, phase error (steps):"));
+  long referenceTravel = steppers[reference]->currentPosition() - rampOrigin[reference];
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    long travel = steppers[i]->currentPosition() - rampOrigin[i];
+    long expected = (rampRate[reference] == 0) ? 0 : lround(referenceTravel * rampRate[i] / rampRate[reference]);
+    Serial.print(F(" ")); Serial.print(travel - expected);
+  }
+  Serial.println();
+  
+  if (autoStopStopping) {
+    autoStopStopping = false;
+    long error = (long)autoStopTravel() - (long)autoStopTarget;
+    Serial.print(F("Auto-stop complete, reference wheel off target by "));
+    Serial.print(error); Serial.println(F(" steps"));
+  }
+}
+
+// --- Step Rate Feasibility ---
+float getStepRateDemand(byte microstepMode) {
+  float demand = 0;
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    const MotorSetting& motor = stagingParams->motors[i];
+    // Both LFO polarities peak at 1 + depth
+    float peak = fabs(motor.wheelSpeed) * (1.0 + motor.lfoDepth / 100.0);
+    demand += (1000.0 / stagingParams->masterTime) * peak * 200.0 * microstepMode;
+  }
+  return demand;
+}
+
+int getStepRateHeadroom(byte microstepMode) {
+  float headroom = 100.0 * (1.0 - getStepRateDemand(microstepMode) / STEP_RATE_BUDGET);
+  if (headroom < -9999) headroom = -9999;
+  return (int)headroom;
+}
+
+bool isStepRateLimited() {
+  return limitScale < 1.0;
+}
+
+unsigned long getLoopRate() {
+  return loopRate;
+}
+
+// --- Microstep Advisory ---
+void setDriverType(DriverType driver) {
+  driverType = driver;
+}
+
+DriverType getDriverType() {
+  return driverType;
+}
+
+bool getDilSwitchConfig(byte microstepMode, DriverType driver, bool* switches) {
+  const byte* modes = (driver == DRIVER_TMC2208) ? TMC2208_DIL_MODES : A4988_DIL_MODES;
+  const bool (*configs)[3] = (driver == DRIVER_TMC2208) ? TMC2208_DIL_CONFIGS : A4988_DIL_CONFIGS;
+  byte count = (driver == DRIVER_TMC2208) ? TMC2208_DIL_COUNT : A4988_DIL_COUNT;
+  
+  for (byte i = 0; i < count; i++) {
+    if (modes[i] == microstepMode) {
+      for (byte pole = 0; pole < 3; pole++) switches[pole] = configs[i][pole];
+      return true;
+    }
+  }
+  return false;
+}
+
+byte getAdvisedMicrostepMode(DriverType driver) {
+  const byte* modes = (driver == DRIVER_TMC2208) ? TMC2208_DIL_MODES : A4988_DIL_MODES;
+  byte count = (driver == DRIVER_TMC2208) ? TMC2208_DIL_COUNT : A4988_DIL_COUNT;
+  
+  // Demand scales linearly with the mode, so walk down from the finest
+  for (byte i = count; i > 0; i--) {
+    if (getStepRateHeadroom(modes[i - 1]) >= ADVISE_HEADROOM_MIN) return modes[i - 1];
+  }
+  return 0;
+}
+
 // --- Setter Functions ---
 void setWheelSpeed(byte motorIndex, float speed) {
   if (motorIndex >= MOTORS_COUNT) {
@@ -245,10 +822,10 @@ void setWheelSpeed(byte motorIndex, float speed) {
   }
   
   // Apply constraints - adjust as needed
-  if (speed < -10.0) speed = -10.0;
-  else if (speed > 10.0) speed = 10.0;
+  if (speed < WHEEL_SPEED_MIN) speed = WHEEL_SPEED_MIN;
+  else if (speed > WHEEL_SPEED_MAX) speed = WHEEL_SPEED_MAX;
   
-  motorSettings[motorIndex].wheelSpeed = speed;
+  stagingParams->motors[motorIndex].wheelSpeed = speed;
   // Serial feedback can be added here if desired
 }
 
@@ -259,7 +836,7 @@ void setLfoDepth(byte motorIndex, float depth) {
   if (depth < 0) depth = 0;
   else if (depth > LFO_DEPTH_MAX) depth = LFO_DEPTH_MAX;
   
-  motorSettings[motorIndex].lfoDepth = depth;
+  stagingParams->motors[motorIndex].lfoDepth = depth;
 }
 
 void setLfoRate(byte motorIndex, float rate) {
@@ -269,20 +846,20 @@ void setLfoRate(byte motorIndex, float rate) {
   if (rate < 0) rate = 0;
   else if (rate > LFO_RATE_MAX) rate = LFO_RATE_MAX;
   
-  motorSettings[motorIndex].lfoRate = rate;
+  stagingParams->motors[motorIndex].lfoRate = rate;
 }
 
 void setLfoPolarity(byte motorIndex, bool isBipolar) {
   if (motorIndex >= MOTORS_COUNT) return;
-  motorSettings[motorIndex].lfoPolarity = isBipolar;
+  stagingParams->motors[motorIndex].lfoPolarity = isBipolar;
 }
 
 void setMasterTime(float time) {
   // Apply constraints (e.g., minimum time to prevent excessive speed)
-  if (time < 10.0) time = 10.0; // Min 10 ms period
-  else if (time > 60000.0) time = 60000.0; // Max 1 min period
+  if (time < MASTER_TIME_MIN) time = MASTER_TIME_MIN;
+  else if (time > MASTER_TIME_MAX) time = MASTER_TIME_MAX;
   
-  masterTime = time;
+  stagingParams->masterTime = time;
 }
 
 // --- Reset Function ---
@@ -299,17 +876,18 @@ void resetToDefaults() {
 
 // Internal helper to reset static variables
 static void resetMotorSettings() {
-  masterTime = DEFAULT_MASTER_TIME;
+  stagingParams->masterTime = DEFAULT_MASTER_TIME;
   currentMicrostepMode = DEFAULT_MICROSTEP; // Keep track of the intended mode
   stepsPerRev = 200 * currentMicrostepMode;
   
   for (byte i = 0; i < MOTORS_COUNT; i++) {
-    motorSettings[i].wheelSpeed = DEFAULT_SPEED_RATIO;
-    motorSettings[i].lfoDepth = DEFAULT_LFO_DEPTH;
-    motorSettings[i].lfoRate = DEFAULT_LFO_RATE;
-    motorSettings[i].lfoPolarity = DEFAULT_LFO_POLARITY;
-    motorSettings[i].lfoPhase = 0;
+    stagingParams->motors[i].wheelSpeed = DEFAULT_SPEED_RATIO;
+    stagingParams->motors[i].lfoDepth = DEFAULT_LFO_DEPTH;
+    stagingParams->motors[i].lfoRate = DEFAULT_LFO_RATE;
+    stagingParams->motors[i].lfoPolarity = DEFAULT_LFO_POLARITY;
+    lfoPhase[i] = 0;
   }
+  commitMotorSettings();
 }
 
 // // --- Motor Configuration ---
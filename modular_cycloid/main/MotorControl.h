@@ -9,6 +9,22 @@
 
 #include "Config.h"
 
+// --- Machine Settings ---
+// User-facing parameters of one wheel (what presets and EEPROM store)
+struct WheelSettings {
+  float wheelSpeed;  // Base wheel speed (ratio) before LFO
+  float lfoDepth;    // LFO depth (0-100%)
+  float lfoRate;     // LFO rate in Hz
+  bool lfoPolarity;  // false = unipolar, true = bipolar
+};
+
+// Complete machine state: every wheel plus the shared timing parameters
+struct MachineSettings {
+  WheelSettings wheels[MOTORS_COUNT];
+  float masterTime;
+  byte microstepMode;
+};
+
 // Motor setup functions
 void setupMotors();
 void stopAllMotors();
@@ -29,6 +45,48 @@ bool getLfoPolarity(byte motorIndex);
 float getMasterTime();
 byte getCurrentMicrostepMode();
 float getCurrentActualSpeed(byte motorIndex); // For status display
+unsigned int getSettingsRevision(); // Increments on every commit or microstep change
+
+// --- Whole-Machine Access ---
+void getMachineSettings(MachineSettings& settings);
+void setMachineSettings(const MachineSettings& settings); // Stages all values; commit to apply
+
+// --- Snapshot Commit ---
+// Setters and getters work on a staging copy. Call once after a batch of
+// edits; the whole batch goes live together at the next updateMotors() tick.
+void commitMotorSettings();
+
+// --- Streamed Motion Segments ---
+// The host queues timed segments (per-wheel speed ratio plus duration) that
+// replace the wheel speeds back to back; master time and LFO still apply.
+// A segment marked as a ramp slides linearly from the previous rates.
+bool queueMotionSegment(const float* wheelSpeeds, unsigned int durationMs, bool ramp); // False if full
+bool queueMotionStreamEnd();      // Stream ends cleanly when this marker is reached
+void stopMotionStream();          // Drops queued segments, returns to normal settings
+bool isMotionStreamActive();
+byte getSegmentCredits();         // Free queue slots the host may still fill
+unsigned int getStreamUnderrunCount(); // Times the queue ran dry mid-stream
+
+// --- Auto-Stop ---
+// Run a number of master revolutions, then ramp every wheel down together
+// and pause. Counted in absolute steps of the fastest wheel.
+bool armAutoStop(float masterRevs);  // False if every wheel is stopped or revs is over the limit
+float getAutoStopRevsLimit();        // Most revs the reference wheel's long position can count (0: all stopped)
+void disarmAutoStop();
+bool isAutoStopArmed();
+float getAutoStopRemainingRevs();    // Master revolutions left until the ramp ends
+
+// --- Step Rate Feasibility ---
+float getStepRateDemand(byte microstepMode);  // Peak aggregate steps/s of the staged settings
+int getStepRateHeadroom(byte microstepMode);  // % of STEP_RATE_BUDGET left (negative = over)
+bool isStepRateLimited();                     // True while wheels are being scaled down
+unsigned long getLoopRate();                  // Measured updateMotors() passes per second
+
+// --- Microstep Advisory ---
+void setDriverType(DriverType driver);
+DriverType getDriverType();
+bool getDilSwitchConfig(byte microstepMode, DriverType driver, bool* switches); // False if unsupported
+byte getAdvisedMicrostepMode(DriverType driver); // Highest supported mode within the step budget, 0 if none
 
 // --- Setter Functions ---
 void setWheelSpeed(byte motorIndex, float speed);
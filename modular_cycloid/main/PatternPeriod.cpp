@@ -0,0 +1,198 @@
+/**
+ * PatternPeriod.cpp
+ * 
+ * Implements the pattern period calculator for the Cycloid Machine.
+ * 
+ * Ideal period: each wheel ratio is turned into a fraction p/q. The pen
+ * returns to its start when every wheel has made a whole number of turns,
+ * i.e. after T master revolutions with T * p/q an integer for every wheel:
+ * T = lcm(q) / gcd(p * lcm(q) / q).
+ * 
+ * Quantized period: AccelStepper steps at whole-microsecond intervals, so
+ * each wheel's real revolution takes stepsPerRev * interval microseconds,
+ * an exact integer. The machine repeats after the lcm of those.
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include "PatternPeriod.h"
+#include "MotorControl.h"
+#include "Config.h"
+
+// --- Internal State ---
+static PatternPeriod cachedPeriod;
+static unsigned int cachedRevision = 0;
+static byte cachedMicrostep = 0;
+static bool cacheValid = false;
+
+// --- Forward Declarations for Static Functions ---
+static void computePatternPeriod(PatternPeriod& period);
+static bool approximateRatio(float value, long& numerator, unsigned int& denominator);
+static uint64_t gcd64(uint64_t a, uint64_t b);
+static bool lcm64(uint64_t a, uint64_t b, uint64_t& result);
+
+const PatternPeriod& getPatternPeriod() {
+  if (!cacheValid || cachedRevision != getSettingsRevision() || cachedMicrostep != getCurrentMicrostepMode()) {
+    computePatternPeriod(cachedPeriod);
+    cachedRevision = getSettingsRevision();
+    cachedMicrostep = getCurrentMicrostepMode();
+    cacheValid = true;
+  }
+  return cachedPeriod;
+}
+
+void formatPatternPeriod(char* buffer) {
+  const PatternPeriod& period = getPatternPeriod();
+  const char* prefix = period.closes ? "" : "~";
+  
+  if (period.masterRevs <= 0) {
+    strcpy(buffer, "none");
+  } else if (period.masterRevs < 1000) {
+    char revs[6];
+    dtostrf(period.masterRevs, 1, period.masterRevs < 10 ? 1 : 0, revs);
+    sprintf(buffer, "%s%sr", prefix, revs);
+  } else if (period.masterRevs < 99500) {
+    char revs[6];
+    dtostrf(period.masterRevs / 1000.0, 1, period.masterRevs < 9950 ? 1 : 0, revs);
+    sprintf(buffer, "%s%skr", prefix, revs);
+  } else {
+    strcpy(buffer, ">99kr");
+  }
+}
+
+void printPatternPeriod() {
+  const PatternPeriod& period = getPatternPeriod();
+  
+  Serial.println(F("\n--- Pattern Period ---"));
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    float ratio = getWheelSpeed(i);
+    Serial.print(F("Wheel ")); Serial.print(i + 1); Serial.print(F(": "));
+    Serial.print(ratio, 3);
+    if (period.ratioNumerator[i] == 0) {
+      Serial.println(F(" (stopped)"));
+      continue;
+    }
+    float approx = (float)period.ratioNumerator[i] / period.ratioDenominator[i];
+    Serial.print(fabs(ratio - approx) < PERIOD_RATIO_TOLERANCE ? F(" = ") : F(" ~ "));
+    Serial.print(period.ratioNumerator[i]); Serial.print(F("/")); Serial.println(period.ratioDenominator[i]);
+  }
+  
+  if (period.masterRevs <= 0) {
+    Serial.println(F("All wheels stopped - nothing to close"));
+    return;
+  }
+  
+  Serial.print(period.closes ? F("Closes after ") : F("Does not close; nearest closure after "));
+  Serial.print(period.masterRevs, 2); Serial.print(F(" master revs ("));
+  Serial.print(period.seconds, 1); Serial.println(F(" s)"));
+  
+  Serial.print(F("Step-quantized period: "));
+  if (period.quantizedValid) {
+    Serial.print(period.quantizedSeconds, 3); Serial.println(F(" s"));
+  } else {
+    Serial.println(F("too long to represent"));
+  }
+  
+  if (period.lfoActive) {
+    Serial.println(F("Note: LFO modulation is not included"));
+  }
+}
+
+// --- Internal Helpers ---
+
+static void computePatternPeriod(PatternPeriod& period) {
+  float masterTime = getMasterTime();
+  unsigned long stepsPerRev = getStepsPerWheelRev();
+  
+  period.closes = true;
+  period.lfoActive = false;
+  period.quantizedValid = true;
+  
+  uint32_t denominatorLcm = 1;
+  uint64_t quantizedLcm = 1;
+  bool anyMoving = false;
+  
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    float ratio = getWheelSpeed(i);
+    if (getLfoDepth(i) > 0) period.lfoActive = true;
+    
+    if (!approximateRatio(ratio, period.ratioNumerator[i], period.ratioDenominator[i])) {
+      period.closes = false;
+    }
+    if (period.ratioNumerator[i] == 0) continue;
+    anyMoving = true;
+    
+    denominatorLcm = denominatorLcm / gcd64(denominatorLcm, period.ratioDenominator[i]) * period.ratioDenominator[i];
+    
+    // Same truncation AccelStepper applies in setSpeed()
+    float stepsPerSecond = (1000.0 / masterTime) * ratio * stepsPerRev;
+    uint64_t interval = (unsigned long)fabs(1000000.0 / stepsPerSecond);
+    if (interval == 0 || !lcm64(quantizedLcm, interval * stepsPerRev, quantizedLcm)) {
+      period.quantizedValid = false;
+    }
+  }
+  
+  if (!anyMoving) {
+    period.masterRevs = 0;
+    period.seconds = 0;
+    period.quantizedSeconds = 0;
+    return;
+  }
+  
+  // T = lcm(q) / gcd(|p| * lcm(q) / q)
+  uint64_t turnsGcd = 0;
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    if (period.ratioNumerator[i] == 0) continue;
+    uint64_t turns = (uint64_t)labs(period.ratioNumerator[i]) * (denominatorLcm / period.ratioDenominator[i]);
+    turnsGcd = gcd64(turnsGcd, turns);
+  }
+  
+  period.masterRevs = (float)denominatorLcm / (float)turnsGcd;
+  period.seconds = period.masterRevs * masterTime / 1000.0;
+  period.quantizedSeconds = period.quantizedValid ? quantizedLcm / 1000000.0 : 0;
+}
+
+/**
+ * Best fraction p/q for value with q <= PERIOD_MAX_DENOMINATOR, found with
+ * continued fractions (the last convergent that fits the limit).
+ * @return true if the fraction matches value within PERIOD_RATIO_TOLERANCE
+ */
+static bool approximateRatio(float value, long& numerator, unsigned int& denominator) {
+  long h0 = 0, h1 = 1;   // Convergent numerators
+  long k0 = 1, k1 = 0;   // Convergent denominators
+  float x = fabs(value);
+  
+  for (byte i = 0; i < 16; i++) {
+    long a = (long)x;
+    long h2 = a * h1 + h0;
+    long k2 = a * k1 + k0;
+    if (k2 > PERIOD_MAX_DENOMINATOR) break;
+    h0 = h1; h1 = h2;
+    k0 = k1; k1 = k2;
+    
+    float remainder = x - a;
+    if (remainder < 1e-6) break;
+    x = 1.0 / remainder;
+  }
+  
+  numerator = (value < 0) ? -h1 : h1;
+  denominator = k1;
+  return fabs(fabs(value) - (float)h1 / k1) < PERIOD_RATIO_TOLERANCE;
+}
+
+static uint64_t gcd64(uint64_t a, uint64_t b) {
+  while (b != 0) {
+    uint64_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// lcm with overflow detection; false if the result does not fit
+static bool lcm64(uint64_t a, uint64_t b, uint64_t& result) {
+  uint64_t reduced = a / gcd64(a, b);
+  if (reduced > UINT64_MAX / b) return false;
+  result = reduced * b;
+  return true;
+}
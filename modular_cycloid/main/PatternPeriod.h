@@ -0,0 +1,33 @@
+/**
+ * PatternPeriod.h
+ * 
+ * Computes when the drawn pattern closes for the Cycloid Machine
+ */
+
+#ifndef PATTERN_PERIOD_H
+#define PATTERN_PERIOD_H
+
+#include "Config.h"
+
+// Closure analysis of the current settings
+struct PatternPeriod {
+  bool closes;              // Every ratio is an exact fraction (denominator <= PERIOD_MAX_DENOMINATOR)
+  bool lfoActive;           // Any LFO with depth > 0 - modulation is ignored below
+  long ratioNumerator[MOTORS_COUNT];      // Ratio (or best approximation) as p/q
+  unsigned int ratioDenominator[MOTORS_COUNT];
+  float masterRevs;         // Closure in master revolutions (approximate if !closes)
+  float seconds;            // masterRevs at the current master time
+  bool quantizedValid;      // False if the step-quantized period overflowed 64 bits
+  float quantizedSeconds;   // Closure of the actual integer step intervals
+};
+
+// Analysis of the staged settings; recomputed only when settings change
+const PatternPeriod& getPatternPeriod();
+
+// Compact closure length for the LCD, e.g. "12r", "1.2kr", "~17r" (max 6 chars)
+void formatPatternPeriod(char* buffer);
+
+// Print the full analysis to Serial
+void printPatternPeriod();
+
+#endif // PATTERN_PERIOD_H
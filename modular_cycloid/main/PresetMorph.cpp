@@ -0,0 +1,144 @@
+/**
+ * PresetMorph.cpp
+ * 
+ * Implements preset morphing for the Cycloid Machine.
+ * 
+ * When a morph starts, every parameter's start value and distance to the
+ * target are converted once to fixed point, and the duration is split
+ * into MORPH_SCHEDULE_STEPS equal intervals. The tick then only counts
+ * milliseconds; parameters are recomputed (integer multiply and shift on
+ * an eased progress curve) and committed once per schedule step.
+ */
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "PresetMorph.h"
+#include "MotorControl.h"
+#include "Config.h"
+
+// Fixed-point scales per parameter (same as the sequencer)
+#define MORPH_SPEED_SCALE 1000   // Ratio x1000
+#define MORPH_DEPTH_SCALE 10     // % x10
+#define MORPH_RATE_SCALE 100     // Hz x100
+
+// Smoothstep easing 3t^2 - 2t^3 in Q15, sampled at t = i/16
+static const uint16_t PROGMEM morphEasing[17] = {
+  0, 368, 1408, 3024, 5120, 7600, 10368, 13328, 16384,
+  19440, 22400, 25168, 27648, 29744, 31360, 32400, 32768
+};
+
+// One interpolated parameter: value = start + delta * ease >> 15
+struct MorphChannel {
+  int32_t start;
+  int32_t delta;
+};
+
+// --- Internal State ---
+static bool morphing = false;
+static MorphChannel speedChannels[MOTORS_COUNT];
+static MorphChannel depthChannels[MOTORS_COUNT];
+static MorphChannel rateChannels[MOTORS_COUNT];
+static MorphChannel masterChannel;
+static bool targetPolarity[MOTORS_COUNT];  // Switched at the halfway point
+static unsigned long stepInterval = 0;     // ms per schedule step
+static unsigned long stepAccumulator = 0;  // ms since the last schedule step
+static unsigned int scheduleStep = 0;      // 0..MORPH_SCHEDULE_STEPS
+
+// --- Forward Declarations for Static Functions ---
+static void setupChannel(MorphChannel& channel, float from, float to, int scale);
+static float channelValue(const MorphChannel& channel, uint16_t ease, int scale);
+static uint16_t easedProgress(unsigned int step);
+static void applyMorphStep();
+
+bool startMorph(const MachineSettings& target, float revs) {
+  if (revs <= 0 || revs > MORPH_REVS_MAX) return false;
+  
+  MachineSettings current;
+  getMachineSettings(current);
+  
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    setupChannel(speedChannels[i], current.wheels[i].wheelSpeed, target.wheels[i].wheelSpeed, MORPH_SPEED_SCALE);
+    setupChannel(depthChannels[i], current.wheels[i].lfoDepth, target.wheels[i].lfoDepth, MORPH_DEPTH_SCALE);
+    setupChannel(rateChannels[i], current.wheels[i].lfoRate, target.wheels[i].lfoRate, MORPH_RATE_SCALE);
+    targetPolarity[i] = target.wheels[i].lfoPolarity;
+  }
+  setupChannel(masterChannel, current.masterTime, target.masterTime, 1);
+  
+  // Revolutions are timed at the master time the morph starts with
+  unsigned long duration = (unsigned long)(revs * current.masterTime);
+  stepInterval = duration / MORPH_SCHEDULE_STEPS;
+  if (stepInterval == 0) stepInterval = 1;
+  stepAccumulator = 0;
+  scheduleStep = 0;
+  morphing = true;
+  return true;
+}
+
+void stopMorph() {
+  morphing = false;
+}
+
+bool isMorphing() {
+  return morphing;
+}
+
+byte getMorphProgress() {
+  return (unsigned long)scheduleStep * 100 / MORPH_SCHEDULE_STEPS;
+}
+
+void serviceMorph(unsigned long deltaMillis) {
+  if (!morphing) return;
+  
+  // Between schedule steps the tick only accumulates time
+  stepAccumulator += deltaMillis;
+  if (stepAccumulator < stepInterval) return;
+  
+  while (stepAccumulator >= stepInterval && scheduleStep < MORPH_SCHEDULE_STEPS) {
+    stepAccumulator -= stepInterval;
+    scheduleStep++;
+  }
+  applyMorphStep();
+  
+  if (scheduleStep >= MORPH_SCHEDULE_STEPS) {
+    morphing = false;
+    Serial.println(F("Morph complete"));
+  }
+}
+
+// --- Internal Helpers ---
+
+static void setupChannel(MorphChannel& channel, float from, float to, int scale) {
+  channel.start = lround(from * scale);
+  channel.delta = lround(to * scale) - channel.start;
+}
+
+static float channelValue(const MorphChannel& channel, uint16_t ease, int scale) {
+  // |delta| stays below 2^16 for every channel, so the product fits in 32 bits
+  int32_t value = channel.start + ((channel.delta * (int32_t)ease) >> 15);
+  return (float)value / scale;
+}
+
+// Smoothstep progress (Q15) for a schedule step, interpolated from the table
+static uint16_t easedProgress(unsigned int step) {
+  unsigned int position = (unsigned long)step * 16 * 16 / MORPH_SCHEDULE_STEPS; // 1/16ths of a table entry
+  byte index = position >> 4;
+  if (index >= 16) return pgm_read_word(&morphEasing[16]);
+  
+  uint16_t low = pgm_read_word(&morphEasing[index]);
+  uint16_t high = pgm_read_word(&morphEasing[index + 1]);
+  return low + (((uint32_t)(high - low) * (position & 0x0F)) >> 4);
+}
+
+static void applyMorphStep() {
+  uint16_t ease = easedProgress(scheduleStep);
+  bool pastHalfway = scheduleStep * 2 >= MORPH_SCHEDULE_STEPS;
+  
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    setWheelSpeed(i, channelValue(speedChannels[i], ease, MORPH_SPEED_SCALE));
+    setLfoDepth(i, channelValue(depthChannels[i], ease, MORPH_DEPTH_SCALE));
+    setLfoRate(i, channelValue(rateChannels[i], ease, MORPH_RATE_SCALE));
+    if (pastHalfway) setLfoPolarity(i, targetPolarity[i]);
+  }
+  setMasterTime(channelValue(masterChannel, ease, 1));
+  commitMotorSettings();
+}
@@ -0,0 +1,24 @@
+/**
+ * PresetMorph.h
+ * 
+ * Time-interpolated crossfade from the current settings to a preset
+ * for the Cycloid Machine
+ */
+
+#ifndef PRESET_MORPH_H
+#define PRESET_MORPH_H
+
+#include "Config.h"
+#include "MotorControl.h"
+
+// Morph every wheel's speed and LFO parameters (and master time) to target
+// over revs master revolutions. Microstep mode is never morphed.
+bool startMorph(const MachineSettings& target, float revs);
+void stopMorph();
+bool isMorphing();
+byte getMorphProgress();   // 0-100 %
+
+// Scheduler - called from updateMotors() on every motor update tick
+void serviceMorph(unsigned long deltaMillis);
+
+#endif // PRESET_MORPH_H
@@ -0,0 +1,243 @@
+/**
+ * Sequencer.cpp
+ * 
+ * Implements the on-device pattern sequencer for the Cycloid Machine.
+ * 
+ * Programs are arrays of SequenceInstruction in flash. The scheduler runs
+ * at the motor update tick: while a WAIT or RAMP is in progress it only
+ * subtracts the tick length from a millisecond countdown, so the cost
+ * between events is a compare and a subtract. Revolutions are converted
+ * to milliseconds using the master time at the moment the step starts.
+ */
+
+#include <Arduino.h>
+#include "Sequencer.h"
+#include "MotorControl.h"
+#include "MenuSystem.h"
+#include "Config.h"
+
+// --- Program Storage ---
+// On AVR the programs stay in flash and each instruction is copied out as
+// it is fetched. Elsewhere, including the host check in ../host, they are
+// ordinary constant data.
+#ifdef __AVR__
+  #include <avr/pgmspace.h>
+  #define SEQUENCE_STORAGE PROGMEM
+#else
+  #define SEQUENCE_STORAGE
+#endif
+
+// --- Built-in Programs ---
+// Three-stage spiral: settle, swing wheel 2, then breathe the LFO
+static const SequenceInstruction SEQUENCE_STORAGE sequenceEvolvingSpiral[] = {
+  SEQ_SET_SPEED(0, 1.0), SEQ_SET_SPEED(1, 2.0), SEQ_SET_SPEED(2, 3.0), SEQ_SET_SPEED(3, 4.0),
+  SEQ_SET_DEPTH(1, 0),
+  SEQ_WAIT(20),
+  SEQ_RAMP_SPEED(1, -2.5, 40),
+  SEQ_WAIT(20),
+  SEQ_SET_RATE(1, 0.2),
+  SEQ_RAMP_DEPTH(1, 30, 20),
+  SEQ_WAIT(40),
+  SEQ_RAMP_DEPTH(1, 0, 20),
+  SEQ_END()
+};
+
+// Alternating directions, stepping wheel 4 up each pass (4 passes)
+static const SequenceInstruction SEQUENCE_STORAGE sequenceStepLadder[] = {
+  SEQ_SET_SPEED(0, 1.0), SEQ_SET_SPEED(1, -1.0), SEQ_SET_SPEED(2, 1.0), SEQ_SET_SPEED(3, -1.0),
+  SEQ_WAIT(10),
+  SEQ_RAMP_SPEED(3, -3.0, 10),
+  SEQ_WAIT(10),
+  SEQ_RAMP_SPEED(3, -1.0, 10),
+  SEQ_LOOP(4, 3),
+  SEQ_END()
+};
+
+// Draw one layer, pause for a pen change, then draw a rotated layer
+static const SequenceInstruction SEQUENCE_STORAGE sequenceTwoColour[] = {
+  SEQ_SET_SPEED(0, 1.0), SEQ_SET_SPEED(1, 1.5), SEQ_SET_SPEED(2, 2.25), SEQ_SET_SPEED(3, 3.375),
+  SEQ_WAIT(30),
+  SEQ_PAUSE(),
+  SEQ_SET_SPEED(1, -1.5), SEQ_SET_SPEED(3, -3.375),
+  SEQ_WAIT(30),
+  SEQ_END()
+};
+
+static const SequenceInstruction* const sequencePrograms[] = {
+  sequenceEvolvingSpiral,
+  sequenceStepLadder,
+  sequenceTwoColour
+};
+
+static_assert(sizeof(sequencePrograms) / sizeof(sequencePrograms[0]) == NUM_SEQUENCE_PROGRAMS,
+              "NUM_SEQUENCE_PROGRAMS must match the program table");
+
+// --- Internal State ---
+static bool running = false;
+static byte programIndex = 0;
+static byte pc = 0;                       // Index of the current instruction
+static SequenceInstruction current;       // RAM copy of instruction pc
+static bool stepActive = false;           // WAIT/RAMP in progress
+static unsigned long stepDuration = 0;    // ms
+static unsigned long stepElapsed = 0;     // ms
+static unsigned long stepCarry = 0;       // ms the last step ran past its end, owed to the next
+static float rampStart = 0;
+static int16_t loopRemaining = -1;        // -1 = no loop counting in progress
+
+// --- Forward Declarations for Static Functions ---
+static void fetchInstruction();
+static bool beginInstruction();
+static unsigned long revsToMillis(uint16_t tenthRevs);
+static float readParam(byte param, byte wheel);
+static void writeParam(byte param, byte wheel, float value);
+static float scaledToValue(byte param, int16_t value);
+
+bool startSequence(byte index) {
+  if (index >= NUM_SEQUENCE_PROGRAMS) return false;
+  programIndex = index;
+  pc = 0;
+  stepActive = false;
+  stepCarry = 0;
+  loopRemaining = -1;
+  running = true;
+  return true;
+}
+
+void stopSequence() {
+  running = false;
+  stepActive = false;
+}
+
+bool isSequenceRunning() {
+  return running;
+}
+
+byte getSequenceProgram() {
+  return programIndex;
+}
+
+byte getSequenceStep() {
+  return pc;
+}
+
+void serviceSequencer(unsigned long deltaMillis) {
+  if (!running) return;
+  
+  // Fast path between events: just count down
+  if (stepActive) {
+    stepElapsed += deltaMillis;
+    if (current.opcode == SEQ_OP_RAMP) {
+      float target = scaledToValue(current.param, current.value);
+      if (stepElapsed < stepDuration) {
+        writeParam(current.param, current.wheel,
+                   rampStart + (target - rampStart) * stepElapsed / stepDuration);
+        commitMotorSettings();
+        return;
+      }
+      writeParam(current.param, current.wheel, target);
+      commitMotorSettings();
+    } else if (stepElapsed < stepDuration) {
+      return;
+    }
+    // The tick rarely ends exactly on the step; the rest starts the next
+    // one, so programs keep to the master revolution count however long
+    stepCarry = stepElapsed - stepDuration;
+    stepActive = false;
+    pc++;
+  }
+  
+  // Execute instant instructions until one takes time; the cap keeps a
+  // program without waits from stalling the motor loop
+  for (byte executed = 0; running && executed < SEQUENCER_MAX_STEPS_PER_TICK; executed++) {
+    fetchInstruction();
+    if (!beginInstruction()) return;
+  }
+}
+
+// --- Internal Helpers ---
+
+static void fetchInstruction() {
+  const SequenceInstruction* source = &sequencePrograms[programIndex][pc];
+#ifdef __AVR__
+  memcpy_P(&current, source, sizeof(SequenceInstruction));
+#else
+  current = *source;
+#endif
+}
+
+// Start the instruction at pc; returns false once it needs time to elapse
+static bool beginInstruction() {
+  switch (current.opcode) {
+    case SEQ_OP_WAIT:
+    case SEQ_OP_RAMP:
+      stepDuration = revsToMillis(current.revs);
+      stepElapsed = stepCarry;
+      if (current.opcode == SEQ_OP_RAMP) rampStart = readParam(current.param, current.wheel);
+      stepActive = true;
+      return false;
+      
+    case SEQ_OP_SET:
+      writeParam(current.param, current.wheel, scaledToValue(current.param, current.value));
+      commitMotorSettings();
+      pc++;
+      return true;
+      
+    case SEQ_OP_PAUSE:
+      // Ticks stop while paused, so execution resumes with the next step
+      pc++;
+      setSystemPaused(true);
+      return false;
+      
+    case SEQ_OP_LOOP:
+      if (loopRemaining < 0) loopRemaining = current.value;
+      if (current.value == 0 || loopRemaining > 0) {
+        if (current.value != 0) loopRemaining--;
+        pc = current.wheel;
+      } else {
+        loopRemaining = -1;
+        pc++;
+      }
+      return true;
+      
+    case SEQ_OP_END:
+    default:
+      running = false;
+      Serial.println(F("Sequence finished"));
+      return false;
+  }
+}
+
+static unsigned long revsToMillis(uint16_t tenthRevs) {
+  return (unsigned long)(getMasterTime() * tenthRevs / 10.0 + 0.5);
+}
+
+static float readParam(byte param, byte wheel) {
+  switch (param) {
+    case SEQ_PARAM_SPEED: return getWheelSpeed(wheel);
+    case SEQ_PARAM_DEPTH: return getLfoDepth(wheel);
+    case SEQ_PARAM_RATE: return getLfoRate(wheel);
+    case SEQ_PARAM_POLARITY: return getLfoPolarity(wheel) ? 1 : 0;
+    case SEQ_PARAM_MASTER: return getMasterTime();
+  }
+  return 0;
+}
+
+static void writeParam(byte param, byte wheel, float value) {
+  switch (param) {
+    case SEQ_PARAM_SPEED: setWheelSpeed(wheel, value); break;
+    case SEQ_PARAM_DEPTH: setLfoDepth(wheel, value); break;
+    case SEQ_PARAM_RATE: setLfoRate(wheel, value); break;
+    case SEQ_PARAM_POLARITY: setLfoPolarity(wheel, value >= 0.5); break;
+    case SEQ_PARAM_MASTER: setMasterTime(value); break;
+  }
+}
+
+static float scaledToValue(byte param, int16_t value) {
+  switch (param) {
+    case SEQ_PARAM_SPEED: return value / 1000.0;
+    case SEQ_PARAM_DEPTH: return value / 10.0;
+    case SEQ_PARAM_RATE: return value / 100.0;
+    case SEQ_PARAM_MASTER: return (uint16_t)value;
+  }
+  return value;
+}
@@ -0,0 +1,67 @@
+/**
+ * Sequencer.h
+ * 
+ * On-device pattern sequencer for the Cycloid Machine.
+ * Runs small bytecode programs stored in flash that change parameters
+ * on a timeline measured in master revolutions.
+ */
+
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include "Config.h"
+
+// --- Opcodes ---
+enum SequenceOpcode {
+  SEQ_OP_END,    // Stop the program
+  SEQ_OP_WAIT,   // Wait <revs> master revolutions
+  SEQ_OP_SET,    // Set <param> of <wheel> to <value>
+  SEQ_OP_RAMP,   // Slide <param> of <wheel> to <value> over <revs>
+  SEQ_OP_PAUSE,  // Pause the machine; the program continues on resume
+  SEQ_OP_LOOP    // Jump to instruction <wheel>, <value> more times (0 = forever)
+};
+
+// Parameters addressed by SET and RAMP, with their fixed-point scale
+enum SequenceParam {
+  SEQ_PARAM_SPEED,     // Wheel speed ratio x1000
+  SEQ_PARAM_DEPTH,     // LFO depth % x10
+  SEQ_PARAM_RATE,      // LFO rate Hz x100
+  SEQ_PARAM_POLARITY,  // 0 = unipolar, 1 = bipolar
+  SEQ_PARAM_MASTER     // Master time in ms (unsigned)
+};
+
+// One fixed-size instruction (6 bytes in flash)
+struct SequenceInstruction {
+  byte opcode;     // SequenceOpcode
+  byte param;      // SequenceParam
+  byte wheel;      // Wheel index, or jump target for LOOP
+  int16_t value;   // Scaled value, or repeat count for LOOP
+  uint16_t revs;   // Duration in tenths of a master revolution
+};
+
+// --- Program Construction Helpers ---
+#define SEQ_SCALE(x, scale) ((int16_t)((x) * (scale) + ((x) < 0 ? -0.5 : 0.5)))
+#define SEQ_WAIT(revs)              {SEQ_OP_WAIT, 0, 0, 0, SEQ_SCALE(revs, 10)}
+#define SEQ_SET_SPEED(w, ratio)     {SEQ_OP_SET, SEQ_PARAM_SPEED, w, SEQ_SCALE(ratio, 1000), 0}
+#define SEQ_SET_DEPTH(w, pct)       {SEQ_OP_SET, SEQ_PARAM_DEPTH, w, SEQ_SCALE(pct, 10), 0}
+#define SEQ_SET_RATE(w, hz)         {SEQ_OP_SET, SEQ_PARAM_RATE, w, SEQ_SCALE(hz, 100), 0}
+#define SEQ_SET_POLARITY(w, bi)     {SEQ_OP_SET, SEQ_PARAM_POLARITY, w, bi, 0}
+#define SEQ_SET_MASTER(ms)          {SEQ_OP_SET, SEQ_PARAM_MASTER, 0, (int16_t)(ms), 0}
+#define SEQ_RAMP_SPEED(w, ratio, revs) {SEQ_OP_RAMP, SEQ_PARAM_SPEED, w, SEQ_SCALE(ratio, 1000), SEQ_SCALE(revs, 10)}
+#define SEQ_RAMP_DEPTH(w, pct, revs)   {SEQ_OP_RAMP, SEQ_PARAM_DEPTH, w, SEQ_SCALE(pct, 10), SEQ_SCALE(revs, 10)}
+#define SEQ_RAMP_RATE(w, hz, revs)     {SEQ_OP_RAMP, SEQ_PARAM_RATE, w, SEQ_SCALE(hz, 100), SEQ_SCALE(revs, 10)}
+#define SEQ_PAUSE()                 {SEQ_OP_PAUSE, 0, 0, 0, 0}
+#define SEQ_LOOP(target, count)     {SEQ_OP_LOOP, 0, target, count, 0}
+#define SEQ_END()                   {SEQ_OP_END, 0, 0, 0, 0}
+
+// --- Sequencer Control ---
+bool startSequence(byte programIndex);  // 0-based, NUM_SEQUENCE_PROGRAMS programs
+void stopSequence();
+bool isSequenceRunning();
+byte getSequenceProgram();              // Valid while running
+byte getSequenceStep();                 // Index of the executing instruction
+
+// Scheduler - called from updateMotors() on every motor update tick
+void serviceSequencer(unsigned long deltaMillis);
+
+#endif // SEQUENCER_H
@@ -8,12 +8,30 @@
 #include "SerialInterface.h"
 #include "MotorControl.h"
 #include "MenuSystem.h"
+#include "SettingsStore.h"
+#include "Sequencer.h"
+#include "PresetMorph.h"
+#include "PatternPeriod.h"
+#include "ModMatrix.h"
 #include "Config.h"
 
 // Buffer for incoming serial commands
 char serialBuffer[MAX_BUFFER_SIZE];
 int bufferIndex = 0;
 
+// --- Forward Declarations for Static Functions ---
+static void executeSetCommand(char* args);
+static bool parseSetAssignment(char* token, MachineSettings& settings);
+static bool parseFloatInRange(const char* text, float minValue, float maxValue, float& value);
+static void executeSegmentCommand(char* args);
+static void reportSegmentCredits();
+static void executeMorphCommand(char* args);
+static void executeModCommand(byte slot, char* args);
+static void printDilSwitches(byte microstepMode, DriverType driver);
+
+// Credits last announced to the host while streaming
+static byte reportedCredits = SEGMENT_QUEUE_SIZE;
+
 // Initialize serial communication
 void setupSerialCommands() {
   Serial.begin(SERIAL_BAUD);
@@ -23,6 +41,8 @@ void setupSerialCommands() {
 
 // Process any available serial commands
 void processSerialCommands() {
+  reportSegmentCredits();
+  
   if (Serial.available() > 0) {
     char incomingChar = Serial.read();
     
@@ -63,6 +83,72 @@ void executeCommand(char* command) {
   if (strcmp(command, "status") == 0) {
     printSystemStatus(); return;
   }
+  // Microstep advisory command
+  if (strcmp(command, "advise") == 0) {
+    Serial.print(F("Current: ")); Serial.print(getCurrentMicrostepMode());
+    Serial.print(F("x (")); Serial.print(getStepRateHeadroom(getCurrentMicrostepMode()));
+    Serial.println(F("% headroom)"));
+    for (byte d = 0; d < 2; d++) {
+      DriverType driver = (d == 0) ? DRIVER_A4988 : DRIVER_TMC2208;
+      byte advised = getAdvisedMicrostepMode(driver);
+      Serial.print(driver == DRIVER_A4988 ? F("A4988:   ") : F("TMC2208: "));
+      if (advised == 0) {
+        Serial.println(F("no mode fits - lower speeds or raise master time"));
+        continue;
+      }
+      Serial.print(advised); Serial.print(F("x (")); Serial.print(getStepRateHeadroom(advised));
+      Serial.print(F("% headroom) "));
+      printDilSwitches(advised, driver);
+    }
+    return;
+  }
+  // Driver type command: driver=a4988 or driver=tmc2208
+  if (strcmp(command, "driver=a4988") == 0 || strcmp(command, "driver=tmc2208") == 0) {
+    setDriverType(command[7] == 'a' ? DRIVER_A4988 : DRIVER_TMC2208);
+    Serial.print(F("Driver type set to: "));
+    Serial.println(getDriverType() == DRIVER_A4988 ? F("A4988") : F("TMC2208"));
+    return;
+  }
+  // Pattern period command
+  if (strcmp(command, "period") == 0) {
+    printPatternPeriod(); return;
+  }
+  // Auto-stop command format: stopafter=<revs>, stopafter=closure or stopafter=off
+  if (strncmp(command, "stopafter=", 10) == 0) {
+    const char* arg = command + 10;
+    float revs;
+    if (strcmp(arg, "off") == 0) {
+      disarmAutoStop();
+      Serial.println(F("Auto-stop off"));
+      return;
+    }
+    if (strcmp(arg, "closure") == 0) {
+      const PatternPeriod& period = getPatternPeriod();
+      if (!period.closes) {
+        Serial.print(F("Error: Pattern does not close (nearest ~"));
+        Serial.print(period.masterRevs, 0);
+        Serial.println(F(" revs) - use stopafter=<revs>"));
+        return;
+      }
+      revs = period.masterRevs;
+    } else if (!parseFloatInRange(arg, 0.1, STOP_AFTER_REVS_MAX, revs)) {
+      Serial.println(F("Error: Use stopafter=<revs>, stopafter=closure or stopafter=off"));
+      return;
+    }
+    float revsLimit = getAutoStopRevsLimit();
+    if (revsLimit > 0 && revs >= revsLimit) {
+      Serial.print(F("Error: At most ")); Serial.print(revsLimit, 0);
+      Serial.println(F(" revs at these speeds and microstep mode"));
+      return;
+    }
+    if (armAutoStop(revs)) {
+      Serial.print(F("Auto-stop after ")); Serial.print(revs, 2); Serial.println(F(" master revs"));
+      if (getPatternPeriod().lfoActive) Serial.println(F("Note: LFO makes the stop point approximate"));
+    } else {
+      Serial.println(F("Error: All wheels are stopped"));
+    }
+    return;
+  }
   // Pause command
   if (strcmp(command, "pause") == 0) {
     setSystemPaused(true); return; // Feedback is in setSystemPaused
@@ -86,10 +172,90 @@ void executeCommand(char* command) {
   if (strcmp(command, "disable") == 0) {
     disableAllMotors(); return;
   }
+  // Batched set command: set key=value [key=value ...]
+  if (strncmp(command, "set ", 4) == 0) {
+    executeSetCommand(command + 4); return;
+  }
+  // Streamed segment command: seg=<ms>,<w1>,<w2>,<w3>,<w4>[,r] or seg=end
+  if (strncmp(command, "seg=", 4) == 0) {
+    executeSegmentCommand(command + 4); return;
+  }
+  // Stream control: stream (status) or stream=stop
+  if (strcmp(command, "stream") == 0) {
+    Serial.print(F("stream ")); Serial.print(isMotionStreamActive() ? F("on") : F("off"));
+    Serial.print(F(" credit ")); Serial.print(getSegmentCredits());
+    Serial.print(F(" underruns ")); Serial.println(getStreamUnderrunCount());
+    return;
+  }
+  if (strcmp(command, "stream=stop") == 0) {
+    stopMotionStream();
+    reportedCredits = getSegmentCredits();
+    Serial.println(F("stream off"));
+    return;
+  }
+  // Sequencer command: seq (status), seq=<n> (run program n), seq=stop
+  if (strcmp(command, "seq") == 0) {
+    if (isSequenceRunning()) {
+      Serial.print(F("Sequence ")); Serial.print(getSequenceProgram() + 1);
+      Serial.print(F(" at step ")); Serial.println(getSequenceStep());
+    } else {
+      Serial.println(F("Sequencer idle"));
+    }
+    return;
+  }
+  if (strcmp(command, "seq=stop") == 0) {
+    stopSequence();
+    Serial.println(F("Sequence stopped"));
+    return;
+  }
+  if (strncmp(command, "seq=", 4) == 0) {
+    int programIndex = atoi(command + 4) - 1; // Convert to 0-based index
+    if (programIndex >= 0 && startSequence(programIndex)) {
+      Serial.print(F("Running sequence: ")); Serial.println(programIndex + 1);
+    } else {
+      Serial.print(F("Error: Invalid sequence number (1-"));
+      Serial.print(NUM_SEQUENCE_PROGRAMS);
+      Serial.println(F(")"));
+    }
+    return;
+  }
+  // Modulation matrix: mod (list), mod=clear, mod<n>=<src>,<dst>,<amount>, mod<n>=off
+  if (strcmp(command, "mod") == 0) {
+    printModMatrix(); return;
+  }
+  if (strcmp(command, "mod=clear") == 0) {
+    clearModRoutes();
+    Serial.println(F("Modulation routes cleared"));
+    return;
+  }
+  if (strncmp(command, "mod", 3) == 0 && command[3] >= '1' && command[3] <= '0' + MOD_ROUTE_COUNT && command[4] == '=') {
+    executeModCommand(command[3] - '1', command + 5); return;
+  }
+  // Envelope trigger: modenv or modenv=<revs>
+  if (strcmp(command, "modenv") == 0 || strncmp(command, "modenv=", 7) == 0) {
+    float revs = MOD_ENVELOPE_DEFAULT_REVS;
+    if (command[6] == '=' && !parseFloatInRange(command + 7, 0.1, MOD_ENVELOPE_REVS_MAX, revs)) {
+      Serial.println(F("Error: Use modenv=<revs>"));
+      return;
+    }
+    triggerModEnvelope((unsigned long)(revs * getMasterTime()));
+    Serial.print(F("Envelope rising over ")); Serial.print(revs); Serial.println(F(" master revs"));
+    return;
+  }
+  // Morph command format: morph=<n>,<revs> or morph=u<n>,<revs>; morph=stop
+  if (strcmp(command, "morph=stop") == 0) {
+    stopMorph();
+    Serial.println(F("Morph stopped"));
+    return;
+  }
+  if (strncmp(command, "morph=", 6) == 0) {
+    executeMorphCommand(command + 6); return;
+  }
   // Master time command: master=<value>
   if (strncmp(command, "master=", 7) == 0) {
     float time = atof(command + 7);
     setMasterTime(time); // Setter handles validation
+    commitMotorSettings();
     Serial.print(F("Master time set to: ")); Serial.println(getMasterTime());
     return;
   }
@@ -98,6 +264,7 @@ void executeCommand(char* command) {
     int motorIndex = command[5] - '1'; 
     float speed = atof(command + 7);
     setWheelSpeed(motorIndex, speed); // Setter handles validation
+    commitMotorSettings();
     Serial.print(F("Wheel ")); Serial.print(motorIndex + 1);
     Serial.print(F(" speed set to: ")); Serial.println(getWheelSpeed(motorIndex));
     return;
@@ -107,6 +274,7 @@ void executeCommand(char* command) {
     int motorIndex = command[5] - '1';
     float depth = atof(command + 7);
     setLfoDepth(motorIndex, depth); // Setter handles validation
+    commitMotorSettings();
     Serial.print(F("Wheel ")); Serial.print(motorIndex + 1);
     Serial.print(F(" LFO depth set to: ")); Serial.println(getLfoDepth(motorIndex));
     return;
@@ -116,6 +284,7 @@ void executeCommand(char* command) {
     int motorIndex = command[4] - '1';
     float rate = atof(command + 6);
     setLfoRate(motorIndex, rate); // Setter handles validation
+    commitMotorSettings();
     Serial.print(F("Wheel ")); Serial.print(motorIndex + 1);
     Serial.print(F(" LFO rate set to: ")); Serial.println(getLfoRate(motorIndex));
     return;
@@ -125,6 +294,7 @@ void executeCommand(char* command) {
     int motorIndex = command[8] - '1';
     int polarity = atoi(command + 10);
     setLfoPolarity(motorIndex, (polarity == 1)); // Setter handles validation
+    commitMotorSettings();
     Serial.print(F("Wheel ")); Serial.print(motorIndex + 1);
     Serial.print(F(" LFO polarity set to: ")); Serial.println(getLfoPolarity(motorIndex) ? F("Bipolar") : F("Unipolar"));
     return;
@@ -143,11 +313,12 @@ void executeCommand(char* command) {
   if (strncmp(command, "preset=", 7) == 0) {
     int presetIndex = atoi(command + 7) - 1; // Convert to 0-based index
     if (presetIndex >= 0 && presetIndex < NUM_RATIO_PRESETS) {
-      // Apply preset by calling individual setters
+      // Stage every wheel, then commit once so they change together
       Serial.print(F("Applying ratio preset: ")); Serial.println(presetIndex + 1);
       for (byte i = 0; i < MOTORS_COUNT; i++) {
           setWheelSpeed(i, RATIO_PRESETS[presetIndex][i]);
       }
+      commitMotorSettings();
     } else {
       // Split Serial.println for F() string and String()
       Serial.print(F("Error: Invalid preset number (1-"));
@@ -156,17 +327,275 @@ void executeCommand(char* command) {
     }
     return;
   }
+  // Save user preset command format: save=<n> (n=1-PRESET_SLOT_COUNT)
+  if (strncmp(command, "save=", 5) == 0) {
+    int slot = atoi(command + 5) - 1; // Convert to 0-based index
+    if (slot >= 0 && slot < PRESET_SLOT_COUNT && savePreset(slot)) {
+      Serial.print(F("Saving user preset: ")); Serial.println(slot + 1);
+    } else {
+      Serial.print(F("Error: Invalid user preset number (1-"));
+      Serial.print(PRESET_SLOT_COUNT);
+      Serial.println(F(")"));
+    }
+    return;
+  }
+  // Load user preset command format: load=<n> (n=1-PRESET_SLOT_COUNT)
+  if (strncmp(command, "load=", 5) == 0) {
+    int slot = atoi(command + 5) - 1; // Convert to 0-based index
+    if (slot < 0 || slot >= PRESET_SLOT_COUNT) {
+      Serial.print(F("Error: Invalid user preset number (1-"));
+      Serial.print(PRESET_SLOT_COUNT);
+      Serial.println(F(")"));
+    } else if (loadPreset(slot)) { // Applied at the next motor update tick
+      Serial.print(F("Loaded user preset: ")); Serial.println(slot + 1);
+    } else {
+      Serial.print(F("Error: User preset ")); Serial.print(slot + 1); Serial.println(F(" is empty"));
+    }
+    return;
+  }
   
   // Unknown command
   Serial.print(F("Unknown command: ")); Serial.println(command);
   Serial.println(F("Type 'help' for available commands"));
 }
 
+/**
+ * Batched parameter update for host scripts.
+ * Every key=value pair is validated against a copy of the current settings
+ * first; only if all are valid is the copy staged and committed, so the
+ * whole batch goes live at one motor tick. Replies with a single line:
+ * "ok <count>" or "err <first bad pair>".
+ * @param args Space-separated key=value pairs (already lowercased)
+ */
+static void executeSetCommand(char* args) {
+  MachineSettings settings;
+  getMachineSettings(settings);
+  
+  byte count = 0;
+  for (char* token = strtok(args, " "); token != NULL; token = strtok(NULL, " ")) {
+    if (!parseSetAssignment(token, settings)) {
+      Serial.print(F("err ")); Serial.println(token);
+      return;
+    }
+    count++;
+  }
+  
+  if (count == 0) {
+    Serial.println(F("err empty"));
+    return;
+  }
+  
+  setMachineSettings(settings);
+  commitMotorSettings();
+  Serial.print(F("ok ")); Serial.println(count);
+}
+
+/**
+ * Parse one key=value pair of a set command into settings.
+ * Keys: master, wheel<n>, depth<n>, rate<n>, polarity<n> (n=1-4).
+ * @param token The pair to parse
+ * @param settings Settings copy to update
+ * @return false for unknown keys, malformed numbers or out-of-range values
+ */
+static bool parseSetAssignment(char* token, MachineSettings& settings) {
+  char* equals = strchr(token, '=');
+  if (equals == NULL) return false;
+  *equals = '\0';
+  const char* key = token;
+  const char* value = equals + 1;
+  bool ok = false;
+  
+  if (strcmp(key, "master") == 0) {
+    ok = parseFloatInRange(value, MASTER_TIME_MIN, MASTER_TIME_MAX, settings.masterTime);
+  } else {
+    // Per-wheel keys end in a single wheel digit
+    size_t keyLength = strlen(key);
+    char wheelChar = (keyLength > 1) ? key[--keyLength] : '\0';
+    if (wheelChar >= '1' && wheelChar <= '0' + MOTORS_COUNT) {
+      WheelSettings& wheel = settings.wheels[wheelChar - '1'];
+      
+      if (keyLength == 5 && strncmp(key, "wheel", 5) == 0) {
+        ok = parseFloatInRange(value, WHEEL_SPEED_MIN, WHEEL_SPEED_MAX, wheel.wheelSpeed);
+      } else if (keyLength == 5 && strncmp(key, "depth", 5) == 0) {
+        ok = parseFloatInRange(value, 0, LFO_DEPTH_MAX, wheel.lfoDepth);
+      } else if (keyLength == 4 && strncmp(key, "rate", 4) == 0) {
+        ok = parseFloatInRange(value, 0, LFO_RATE_MAX, wheel.lfoRate);
+      } else if (keyLength == 8 && strncmp(key, "polarity", 8) == 0) {
+        if ((value[0] == '0' || value[0] == '1') && value[1] == '\0') {
+          wheel.lfoPolarity = (value[0] == '1');
+          ok = true;
+        }
+      }
+    }
+  }
+  
+  *equals = '='; // Restore the token for error reporting
+  return ok;
+}
+
+/**
+ * Queue one streamed motion segment.
+ * Format: <ms>,<w1>,<w2>,<w3>,<w4>[,r] where w are wheel speed ratios and a
+ * trailing r ramps linearly from the previous rates; "end" queues the
+ * end-of-stream marker. Replies "credit <free slots>" or "err <reason>".
+ * @param args Text after "seg="
+ */
+static void executeSegmentCommand(char* args) {
+  bool queued;
+  
+  if (strcmp(args, "end") == 0) {
+    queued = queueMotionStreamEnd();
+  } else {
+    float wheelSpeeds[MOTORS_COUNT];
+    float duration;
+    bool ramp = false;
+    byte fields = 0;
+    bool ok = true;
+    
+    for (char* token = strtok(args, ","); token != NULL && ok; token = strtok(NULL, ",")) {
+      if (fields == 0) {
+        ok = parseFloatInRange(token, 1, SEGMENT_DURATION_MAX, duration);
+      } else if (fields <= MOTORS_COUNT) {
+        ok = parseFloatInRange(token, WHEEL_SPEED_MIN, WHEEL_SPEED_MAX, wheelSpeeds[fields - 1]);
+      } else if (fields == MOTORS_COUNT + 1 && strcmp(token, "r") == 0) {
+        ramp = true;
+      } else {
+        ok = false;
+      }
+      fields++;
+    }
+    
+    if (!ok || fields < MOTORS_COUNT + 1) {
+      Serial.println(F("err format"));
+      return;
+    }
+    queued = queueMotionSegment(wheelSpeeds, (unsigned int)duration, ramp);
+  }
+  
+  if (!queued) {
+    Serial.println(F("err full"));
+    return;
+  }
+  reportedCredits = getSegmentCredits();
+  Serial.print(F("credit ")); Serial.println(reportedCredits);
+}
+
+/**
+ * Start a morph from the current settings to a preset.
+ * Format: <n>,<revs> for ratio preset n, or u<n>,<revs> for user preset n.
+ * Built-in presets only carry ratios, so the LFO settings stay as they are.
+ * @param args Text after "morph="
+ */
+static void executeMorphCommand(char* args) {
+  char* comma = strchr(args, ',');
+  float revs;
+  if (comma == NULL || !parseFloatInRange(comma + 1, 0.1, MORPH_REVS_MAX, revs)) {
+    Serial.println(F("Error: Use morph=<preset>,<revs> (e.g., morph=4,20 or morph=u2,20)"));
+    return;
+  }
+  *comma = '\0';
+  
+  MachineSettings target;
+  bool userPreset = (args[0] == 'u');
+  int presetIndex = atoi(args + (userPreset ? 1 : 0)) - 1; // Convert to 0-based index
+  
+  if (userPreset) {
+    if (presetIndex < 0 || presetIndex >= PRESET_SLOT_COUNT || !readPreset(presetIndex, target)) {
+      Serial.println(F("Error: User preset missing or empty"));
+      return;
+    }
+  } else {
+    if (presetIndex < 0 || presetIndex >= NUM_RATIO_PRESETS) {
+      Serial.print(F("Error: Invalid preset number (1-"));
+      Serial.print(NUM_RATIO_PRESETS);
+      Serial.println(F(")"));
+      return;
+    }
+    getMachineSettings(target);
+    for (byte i = 0; i < MOTORS_COUNT; i++) {
+      target.wheels[i].wheelSpeed = RATIO_PRESETS[presetIndex][i];
+    }
+  }
+  
+  startMorph(target, revs);
+  Serial.print(F("Morphing to ")); Serial.print(userPreset ? F("user preset ") : F("preset "));
+  Serial.print(presetIndex + 1); Serial.print(F(" over ")); Serial.print(revs);
+  Serial.println(F(" revolutions"));
+}
+
+/**
+ * Set or clear one modulation route.
+ * @param slot 0-based route slot
+ * @param args "<source>,<destination>,<amount %>" or "off"
+ */
+static void executeModCommand(byte slot, char* args) {
+  if (strcmp(args, "off") == 0) {
+    clearModRoute(slot);
+    Serial.print(F("Route ")); Serial.print(slot + 1); Serial.println(F(" off"));
+    return;
+  }
+  
+  ModRoute route;
+  char* destination = strchr(args, ',');
+  char* amount = destination ? strchr(destination + 1, ',') : NULL;
+  float value;
+  if (amount != NULL) {
+    *destination++ = '\0';
+    *amount++ = '\0';
+  }
+  if (amount == NULL || !parseModSource(args, route.source) ||
+      !parseModDestination(destination, route.destination, route.wheel) ||
+      !parseFloatInRange(amount, -100, 100, value)) {
+    Serial.println(F("Error: Use mod<n>=<lfo1-4|env|rev>,<speedN|rateN|depthN|master>,<-100..100>"));
+    return;
+  }
+  route.amount = (int8_t)value;
+  setModRoute(slot, route);
+  Serial.print(F("Route ")); Serial.print(slot + 1); Serial.println(F(" set"));
+}
+
+// Print "DIL: [ON OFF ON]" for MS1-MS3, or a note if the driver lacks the mode
+static void printDilSwitches(byte microstepMode, DriverType driver) {
+  bool switches[3];
+  if (!getDilSwitchConfig(microstepMode, driver, switches)) {
+    Serial.println(F("DIL: not supported by this driver"));
+    return;
+  }
+  Serial.print(F("DIL: ["));
+  for (byte pole = 0; pole < 3; pole++) {
+    if (pole > 0) Serial.print(F(" "));
+    Serial.print(switches[pole] ? F("ON") : F("OFF"));
+  }
+  Serial.println(F("]"));
+}
+
+// Announce freed queue slots as the motor tick consumes segments
+static void reportSegmentCredits() {
+  byte credits = getSegmentCredits();
+  if (credits == reportedCredits) return;
+  reportedCredits = credits;
+  Serial.print(F("credit ")); Serial.println(credits);
+}
+
+// Parse a whole-string float and check it against [minValue, maxValue];
+// written so that "nan" (which strtod accepts) fails the range test too
+static bool parseFloatInRange(const char* text, float minValue, float maxValue, float& value) {
+  char* end;
+  double parsed = strtod(text, &end);
+  if (end == text || *end != '\0') return false;
+  if (!(parsed >= minValue && parsed <= maxValue)) return false;
+  value = parsed;
+  return true;
+}
+
 // Print help information
 void printHelp() {
   Serial.println(F("\n--- Cycloid Machine Commands ---"));
   Serial.println(F("status                   - Display system status"));
   Serial.println(F("help                     - Show this help message"));
+  Serial.println(F("period                   - Show when the current pattern closes"));
+  Serial.println(F("stopafter=<revs>         - Ramp down and pause after revs master revolutions"));
+  Serial.println(F("                           (stopafter=closure for one pattern, stopafter=off)"));
   Serial.println(F("pause                    - Pause the system"));
   Serial.println(F("resume                   - Resume the system"));
   Serial.println(F("reset                    - Reset all motor settings to defaults"));
@@ -178,10 +607,32 @@ void printHelp() {
   Serial.println(F("rate<n>=<value>          - Set LFO rate 0-10Hz (n=1-4, e.g., rate3=2.5)"));
   Serial.println(F("polarity<n>=<0/1>        - Set LFO polarity: 0=uni, 1=bi (n=1-4, e.g., polarity4=1)"));
   Serial.println(F("microstep=<value>        - Set microstepping (1,2,4,8,16,32,64,128)"));
+  Serial.println(F("advise                   - Suggest the finest microstep mode within the step budget"));
+  Serial.println(F("driver=<a4988|tmc2208>   - Select driver type for the STEP menu DIL display"));
+  Serial.println(F("set <k>=<v> [<k>=<v>...] - Apply several of master/wheel/depth/rate/polarity"));
+  Serial.println(F("                           at one motor tick (e.g., set wheel1=1 master=1500)"));
+  Serial.println(F("seg=<ms>,<w1>,..,<w4>[,r] - Queue a streamed segment (r = ramp); seg=end finishes"));
+  Serial.println(F("stream / stream=stop     - Show queue credits and underruns / abort the stream"));
+  Serial.print(F("seq=<n> / seq=stop / seq   - Run built-in sequence (1-"));
+  Serial.print(NUM_SEQUENCE_PROGRAMS);
+  Serial.println(F(") / stop it / show progress"));
   // Split Serial.println for F() string and String()
   Serial.print(F("preset=<value>           - Apply ratio preset (1-"));
   Serial.print(NUM_RATIO_PRESETS);
   Serial.println(F(")"));
+  Serial.println(F("morph=<n>,<revs>         - Crossfade to ratio preset n (u<n> = user preset) over revs"));
+  Serial.println(F("                           master revolutions (e.g., morph=5,20); morph=stop"));
+  Serial.println(F("mod                      - List modulation routes and tick cost"));
+  Serial.println(F("mod<n>=<src>,<dst>,<amt> - Route src (lfo1-4, env, rev) to dst (speed1-4, rate1-4,"));
+  Serial.println(F("                           depth1-4, master) by amt % (e.g., mod1=lfo1,rate2,50);"));
+  Serial.println(F("                           mod<n>=off, mod=clear"));
+  Serial.println(F("modenv=<revs>            - Restart the envelope, rising over revs master revolutions"));
+  Serial.print(F("save=<n>                 - Save all settings to user preset (1-"));
+  Serial.print(PRESET_SLOT_COUNT);
+  Serial.println(F(")"));
+  Serial.print(F("load=<n>                 - Load user preset (1-"));
+  Serial.print(PRESET_SLOT_COUNT);
+  Serial.println(F(")"));
 }
 
 // Print system status
@@ -193,6 +644,24 @@ void printSystemStatus() {
   Serial.print(F("Master time: ")); Serial.print(masterT); Serial.println(F(" ms"));
   byte microstep = getCurrentMicrostepMode(); // Get microstep mode
   Serial.print(F("Microstepping: ")); Serial.print(microstep); Serial.println(F("x"));
+  Serial.print(F("Step rate: ")); Serial.print(getStepRateDemand(microstep), 0);
+  Serial.print(F(" of ")); Serial.print(STEP_RATE_BUDGET);
+  Serial.print(F(" steps/s peak (")); Serial.print(getStepRateHeadroom(microstep));
+  Serial.println(isStepRateLimited() ? F("% headroom) - LIMITED, wheels slowed") : F("% headroom)"));
+  Serial.print(F("Loop rate: ")); Serial.print(getLoopRate()); Serial.println(F(" passes/s"));
+  if (isAutoStopArmed()) {
+    Serial.print(F("Auto-stop in: ")); Serial.print(getAutoStopRemainingRevs(), 2); Serial.println(F(" master revs"));
+  }
+  if (isModMatrixActive()) {
+    Serial.println(F("Modulation: on (see 'mod')"));
+  }
+  if (isMorphing()) {
+    Serial.print(F("Morph: ")); Serial.print(getMorphProgress()); Serial.println(F("%"));
+  }
+  if (isMotionStreamActive()) {
+    Serial.print(F("Stream: ")); Serial.print(SEGMENT_QUEUE_SIZE - getSegmentCredits());
+    Serial.print(F(" queued, ")); Serial.print(getStreamUnderrunCount()); Serial.println(F(" underruns"));
+  }
   
   Serial.println(F("\n--- Wheel Settings ---"));
   Serial.println(F("Wheel | Ratio | LFO Dep | LFO Rate | LFO Pol | Actual Speed (Steps/s)"));
@@ -0,0 +1,257 @@
+/**
+ * SettingsStore.cpp
+ *
+ * Implements EEPROM persistence of motor settings for the Cycloid Machine.
+ *
+ * Each save goes to the next of SETTINGS_SLOT_COUNT slots (wear leveling),
+ * tagged with an increasing sequence number and a CRC16. On boot the valid
+ * slot with the newest sequence wins; a torn write simply fails its CRC and
+ * the previous slot is used instead.
+ *
+ * While a sequencer program runs it commits settings at every step, so
+ * the deferred save waits until the program stops and then stores what it
+ * left behind; a looping program would otherwise write EEPROM every few
+ * seconds for as long as it runs.
+ *
+ * User presets use the same record layout in a separate bank of
+ * PRESET_SLOT_COUNT fixed slots above the settings ring.
+ */
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <EEPROM.h>
+#include <util/crc16.h>
+#include "SettingsStore.h"
+#include "MotorControl.h"
+#include "Sequencer.h"
+#include "Config.h"
+
+#define SETTINGS_MAGIC 0xC5
+
+// lfoFlags bit layout. Only the sine LFO exists today, so the waveform
+// bits are always written as 0 and ignored on load.
+#define LFO_FLAG_BIPOLAR 0x01
+#define LFO_FLAG_WAVEFORM_MASK 0xF0
+
+// --- Stored Record Layout ---
+struct __attribute__((packed)) StoredMotorSetting {
+  float wheelSpeed;
+  float lfoDepth;
+  float lfoRate;
+  byte lfoFlags;          // LFO_FLAG_* bits
+};
+
+struct __attribute__((packed)) SettingsRecord {
+  byte magic;
+  byte version;
+  uint16_t sequence;      // Increments on every save, wraps
+  StoredMotorSetting motors[MOTORS_COUNT];
+  float masterTime;
+  byte microstepMode;
+  uint16_t crc;           // CRC16 over all preceding bytes
+};
+
+static_assert(sizeof(SettingsRecord) <= SETTINGS_SLOT_SIZE, "SettingsRecord exceeds EEPROM slot size");
+
+// --- Internal State ---
+static byte currentSlot = SETTINGS_SLOT_COUNT - 1; // Slot holding the newest record
+static unsigned int currentSequence = 0;
+
+static unsigned int savedRevision = 0;       // Settings revision last written
+static unsigned int observedRevision = 0;    // Revision seen on the previous service pass
+static unsigned long lastRevisionChangeTime = 0;
+
+// Background writer: one byte per service call once the EEPROM is ready
+static SettingsRecord pendingRecord;
+static bool writeInProgress = false;
+static bool writeIsPreset = false;   // Preset writes don't advance the settings ring
+static int writeAddress = 0;
+static byte writeIndex = 0;
+static byte writeSlot = 0;
+
+// Preset save waiting for the writer to become free
+static byte queuedPresetSlot = 0;
+static bool presetSaveQueued = false;
+
+// --- Forward Declarations for Static Functions ---
+static unsigned int computeRecordCrc(const SettingsRecord& record);
+static int slotAddress(byte slot);
+static int presetAddress(byte presetIndex);
+static bool readRecord(int address, SettingsRecord& record);
+static void buildRecord(SettingsRecord& record, unsigned int sequence);
+static void recordToSettings(const SettingsRecord& record, MachineSettings& settings);
+static void startWrite(int address);
+
+bool restoreSettings() {
+  SettingsRecord record;
+  SettingsRecord newest;
+  bool found = false;
+
+  // Scan every slot; sequence comparison is wrap-safe
+  for (byte slot = 0; slot < SETTINGS_SLOT_COUNT; slot++) {
+    if (!readRecord(slotAddress(slot), record)) continue;
+    if (!found || (int16_t)(record.sequence - newest.sequence) > 0) {
+      newest = record;
+      currentSlot = slot;
+      found = true;
+    }
+  }
+
+  if (!found) {
+    Serial.println(F("No stored settings - using defaults"));
+    savedRevision = observedRevision = getSettingsRevision();
+    return false;
+  }
+
+  currentSequence = newest.sequence;
+  MachineSettings settings;
+  recordToSettings(newest, settings);
+  setMachineSettings(settings);
+  commitMotorSettings();
+
+  // Restored values are already on EEPROM, don't write them back
+  savedRevision = observedRevision = getSettingsRevision();
+
+  Serial.print(F("Settings restored from slot "));
+  Serial.println(currentSlot);
+  return true;
+}
+
+void serviceSettingsStore(unsigned long currentMillis) {
+  if (writeInProgress) {
+    if (!eeprom_is_ready()) return; // Previous byte still programming
+
+    const byte* bytes = (const byte*)&pendingRecord;
+    EEPROM.update(writeAddress + writeIndex, bytes[writeIndex]);
+    writeIndex++;
+
+    if (writeIndex >= sizeof(SettingsRecord)) {
+      writeInProgress = false;
+      if (writeIsPreset) {
+        Serial.print(F("Preset ")); Serial.print(writeSlot + 1); Serial.println(F(" saved"));
+      } else {
+        currentSlot = writeSlot;
+        currentSequence = pendingRecord.sequence;
+      }
+    }
+    return;
+  }
+
+  // Explicit preset saves take priority over the deferred settings save
+  if (presetSaveQueued) {
+    presetSaveQueued = false;
+    buildRecord(pendingRecord, 0);
+    writeIsPreset = true;
+    writeSlot = queuedPresetSlot;
+    startWrite(presetAddress(queuedPresetSlot));
+    return;
+  }
+
+  // Coalesce bursts of edits: wait until the revision has been stable
+  unsigned int revision = getSettingsRevision();
+  if (revision != observedRevision) {
+    observedRevision = revision;
+    lastRevisionChangeTime = currentMillis;
+  }
+
+  if (revision == savedRevision) return;
+  if (isSequenceRunning()) return;
+  if (currentMillis - lastRevisionChangeTime < SETTINGS_SAVE_DELAY) return;
+
+  savedRevision = revision;
+  buildRecord(pendingRecord, currentSequence + 1);
+  writeIsPreset = false;
+  writeSlot = (currentSlot + 1) % SETTINGS_SLOT_COUNT;
+  startWrite(slotAddress(writeSlot));
+}
+
+// --- User Preset Bank ---
+
+bool savePreset(byte presetIndex) {
+  if (presetIndex >= PRESET_SLOT_COUNT) return false;
+  // Snapshot is taken when the writer picks the job up (at most one record later)
+  queuedPresetSlot = presetIndex;
+  presetSaveQueued = true;
+  return true;
+}
+
+bool readPreset(byte presetIndex, MachineSettings& settings) {
+  if (presetIndex >= PRESET_SLOT_COUNT) return false;
+  SettingsRecord record;
+  if (!readRecord(presetAddress(presetIndex), record)) return false;
+  recordToSettings(record, settings);
+  return true;
+}
+
+bool loadPreset(byte presetIndex) {
+  MachineSettings settings;
+  if (!readPreset(presetIndex, settings)) return false;
+  // Goes live at the next updateMotors tick so all axes change together
+  setMachineSettings(settings);
+  commitMotorSettings();
+  return true;
+}
+
+// --- Internal Helpers ---
+
+static unsigned int computeRecordCrc(const SettingsRecord& record) {
+  const byte* bytes = (const byte*)&record;
+  unsigned int crc = 0xFFFF;
+  for (byte i = 0; i < offsetof(SettingsRecord, crc); i++) {
+    crc = _crc16_update(crc, bytes[i]);
+  }
+  return crc;
+}
+
+static int slotAddress(byte slot) {
+  return SETTINGS_EEPROM_BASE + slot * SETTINGS_SLOT_SIZE;
+}
+
+static int presetAddress(byte presetIndex) {
+  return PRESET_EEPROM_BASE + presetIndex * SETTINGS_SLOT_SIZE;
+}
+
+static bool readRecord(int address, SettingsRecord& record) {
+  byte* bytes = (byte*)&record;
+  for (byte i = 0; i < sizeof(SettingsRecord); i++) {
+    bytes[i] = EEPROM.read(address + i);
+  }
+
+  if (record.magic != SETTINGS_MAGIC || record.version != SETTINGS_VERSION) return false;
+  return record.crc == computeRecordCrc(record);
+}
+
+static void buildRecord(SettingsRecord& record, unsigned int sequence) {
+  MachineSettings settings;
+  getMachineSettings(settings);
+
+  record.magic = SETTINGS_MAGIC;
+  record.version = SETTINGS_VERSION;
+  record.sequence = sequence;
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    record.motors[i].wheelSpeed = settings.wheels[i].wheelSpeed;
+    record.motors[i].lfoDepth = settings.wheels[i].lfoDepth;
+    record.motors[i].lfoRate = settings.wheels[i].lfoRate;
+    record.motors[i].lfoFlags = settings.wheels[i].lfoPolarity ? LFO_FLAG_BIPOLAR : 0;
+  }
+  record.masterTime = settings.masterTime;
+  record.microstepMode = settings.microstepMode;
+  record.crc = computeRecordCrc(record);
+}
+
+static void recordToSettings(const SettingsRecord& record, MachineSettings& settings) {
+  for (byte i = 0; i < MOTORS_COUNT; i++) {
+    settings.wheels[i].wheelSpeed = record.motors[i].wheelSpeed;
+    settings.wheels[i].lfoDepth = record.motors[i].lfoDepth;
+    settings.wheels[i].lfoRate = record.motors[i].lfoRate;
+    settings.wheels[i].lfoPolarity = (record.motors[i].lfoFlags & LFO_FLAG_BIPOLAR) != 0;
+  }
+  settings.masterTime = record.masterTime;
+  settings.microstepMode = record.microstepMode;
+}
+
+static void startWrite(int address) {
+  writeAddress = address;
+  writeIndex = 0;
+  writeInProgress = true;
+}
@@ -0,0 +1,24 @@
+/**
+ * SettingsStore.h
+ *
+ * Persists motor settings to EEPROM for the Cycloid Machine
+ */
+
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include "Config.h"
+#include "MotorControl.h"
+
+// Restore the newest valid record from EEPROM (called from setupMotors)
+bool restoreSettings();
+
+// Deferred writer - call every loop pass; saves once settings have settled
+void serviceSettingsStore(unsigned long currentMillis);
+
+// --- User Preset Bank (0-based index, PRESET_SLOT_COUNT slots) ---
+bool savePreset(byte presetIndex);   // Queues the current settings for a background write
+bool loadPreset(byte presetIndex);   // Schedules the preset for the next motor update tick
+bool readPreset(byte presetIndex, MachineSettings& settings); // False if the slot is empty
+
+#endif // SETTINGS_STORE_H
@@ -15,6 +15,7 @@
 #include "MenuSystem.h"
 #include "InputHandling.h"
 #include "SerialInterface.h"
+#include "SettingsStore.h"
 
 // Debug flags - uncomment to enable specific debug output
 // #define DEBUG_TIMING
@@ -83,6 +84,9 @@ void loop() {
   // Update motor positions/speeds based on current settings and pause state
   updateMotors(currentMillis, paused);
   
+  // Persist settled setting changes to EEPROM (one byte per pass, non-blocking)
+  serviceSettingsStore(currentMillis);
+  
   // Update the LCD display (reflects changes from input/motors)
   // updateDisplay(); // Called within handleMenuNavigation/Selection/Return now
 
@@ -0,0 +1,203 @@
+/**
+ * BatchEvaluator.cpp
+ *
+ * Implements batch evaluation of compiled linkage programs. The operations
+ * mirror CompiledLinkage::runProgram() line for line on Batch values.
+ */
+
+#include "BatchEvaluator.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace cycloid {
+
+BatchEvaluator::BatchEvaluator(const CompiledLinkage& linkage) : linkage(linkage), machine(linkage.machineModel()) {
+  for (const CompiledLinkage::Op& op : linkage.operations()) {
+    if (op.code == CompiledLinkage::OP_NEWTON) closedForm = false;
+  }
+  // The rotation recurrence needs constant wheel speeds
+  if (hasVaryingWheelSpeed(machine)) closedForm = false;
+  minSpan = COMPILED_MIN_SPAN * linkage.lengthUnit();
+  failureBound = COMPILED_FAILURE_BOUND * linkage.lengthUnit();
+
+  double canvasRate = 0;
+  if (machine.canvasWheel >= 0) {
+    canvasRate = wheelAngularRate(machine, machine.canvasWheel);
+    canvasX = machine.wheels[machine.canvasWheel].centerX;
+    canvasY = machine.wheels[machine.canvasWheel].centerY;
+  }
+  angleRates.push_back(canvasRate);
+  for (size_t i = 0; i < machine.wheels.size(); i++) {
+    angleRates.push_back((int)i == machine.canvasWheel ? canvasRate : canvasRate + wheelAngularRate(machine, i));
+  }
+  angleCos.resize(angleRates.size());
+  angleSin.resize(angleRates.size());
+  stepCos.resize(angleRates.size());
+  stepSin.resize(angleRates.size());
+
+  jointX.resize(linkage.jointCount());
+  jointY.resize(linkage.jointCount());
+  rodX.resize(machine.rods.size());
+  rodY.resize(machine.rods.size());
+  rodC.resize(machine.rods.size());
+  rodS.resize(machine.rods.size());
+}
+
+void BatchEvaluator::evaluate(double dt, size_t first, size_t count, double* x, double* y) {
+  double laneX[BATCH_SAMPLES], laneY[BATCH_SAMPLES], laneMiss[BATCH_SAMPLES];
+  const Rod& penRod = machine.rods[machine.penRod];
+  const Batch penDistance = Batch::set(penRod.penDistance);
+
+  for (size_t done = 0, batch = 0; done < count; done += BATCH_SAMPLES, batch++) {
+    if (batch % BATCH_REANCHOR == 0) {
+      anchorAngles(dt, first + done);
+    } else {
+      advanceAngles();
+    }
+
+    Batch miss = runProgram();
+    Batch penX = rodX[machine.penRod] + penDistance * rodC[machine.penRod];
+    Batch penY = rodY[machine.penRod] + penDistance * rodS[machine.penRod];
+
+    size_t lanes = std::min((size_t)BATCH_SAMPLES, count - done);
+    if (lanes == BATCH_SAMPLES) {
+      penX.store(x + done);
+      penY.store(y + done);
+    } else {
+      penX.store(laneX);
+      penY.store(laneY);
+      std::copy(laneX, laneX + lanes, x + done);
+      std::copy(laneY, laneY + lanes, y + done);
+    }
+
+    solverStats.samples += lanes;
+    // Lane by lane only when some miss is a failure or a new maximum
+    if (!batchAnyNotLess(miss, std::min(failureBound, solverStats.maxResidual))) continue;
+    miss.store(laneMiss);
+    for (size_t i = 0; i < lanes; i++) {
+      if (!(laneMiss[i] < failureBound)) solverStats.failures++;
+      solverStats.maxResidual = std::max(solverStats.maxResidual, laneMiss[i]);
+    }
+  }
+}
+
+// --- Internal Helpers ---
+
+// Exact angles for the batch starting at sample index first, same expression as computeWheelPoses()
+void BatchEvaluator::anchorAngles(double dt, size_t first) {
+  double laneCos[BATCH_SAMPLES], laneSin[BATCH_SAMPLES];
+  for (size_t slot = 0; slot < angleRates.size(); slot++) {
+    int wheel = (int)slot - 1;
+    double wheelRate = (wheel >= 0 && wheel != machine.canvasWheel) ? wheelAngularRate(machine, wheel) : 0;
+    for (int lane = 0; lane < BATCH_SAMPLES; lane++) {
+      double t = dt * (double)(first + lane);
+      double angle = angleRates[0] * t + wheelRate * t;
+      laneCos[lane] = std::cos(angle);
+      laneSin[lane] = std::sin(angle);
+    }
+    angleCos[slot] = Batch::load(laneCos);
+    angleSin[slot] = Batch::load(laneSin);
+    stepCos[slot] = std::cos(angleRates[slot] * dt * BATCH_SAMPLES);
+    stepSin[slot] = std::sin(angleRates[slot] * dt * BATCH_SAMPLES);
+  }
+}
+
+void BatchEvaluator::advanceAngles() {
+  for (size_t slot = 0; slot < angleRates.size(); slot++) {
+    Batch c = Batch::set(stepCos[slot]), s = Batch::set(stepSin[slot]);
+    Batch nextCos = angleCos[slot] * c - angleSin[slot] * s;
+    angleSin[slot] = angleSin[slot] * c + angleCos[slot] * s;
+    angleCos[slot] = nextCos;
+  }
+}
+
+// Runs every operation on the current batch; returns the circle miss per lane
+Batch BatchEvaluator::runProgram() {
+  const Batch zero = Batch::set(0), span = Batch::set(minSpan), spanSquared = Batch::set(minSpan * minSpan);
+  const Batch smallest = Batch::set(DBL_MIN);
+  Batch miss = zero;
+
+  for (const CompiledLinkage::Op& op : linkage.operations()) {
+    switch (op.code) {
+      case CompiledLinkage::OP_WHEEL_POINT: {
+        const Wheel& wheel = machine.wheels[op.a];
+        Batch centerX, centerY;
+        if (op.a == machine.canvasWheel) {
+          centerX = Batch::set(canvasX);
+          centerY = Batch::set(canvasY);
+        } else {
+          // Center is fixed in the canvas frame
+          Batch dx = Batch::set(wheel.centerX - canvasX), dy = Batch::set(wheel.centerY - canvasY);
+          centerX = Batch::set(canvasX) + angleCos[0] * dx - angleSin[0] * dy;
+          centerY = Batch::set(canvasY) + angleSin[0] * dx + angleCos[0] * dy;
+        }
+        Batch radius = Batch::set(op.da);
+        jointX[op.out] = centerX + radius * angleCos[1 + op.a];
+        jointY[op.out] = centerY + radius * angleSin[1 + op.a];
+        break;
+      }
+
+      case CompiledLinkage::OP_ROD_POINT: {
+        Batch distance = Batch::set(op.da);
+        jointX[op.out] = rodX[op.a] + distance * rodC[op.a];
+        jointY[op.out] = rodY[op.a] + distance * rodS[op.a];
+        break;
+      }
+
+      case CompiledLinkage::OP_ROD_TWO_POINTS:
+      case CompiledLinkage::OP_ROD_SLIDER: {
+        Batch dx = jointX[op.b] - jointX[op.a];
+        Batch dy = jointY[op.b] - jointY[op.a];
+        // Lengths come from one reciprocal square root: 1 / max(length, span) and length = length^2 times that
+        Batch lengthSquared = dx * dx + dy * dy;
+        Batch inverse = batchRsqrt(batchMax(lengthSquared, spanSquared));
+        Batch length = lengthSquared * inverse;
+        Batch scale = Batch::set(op.sign) * inverse;
+        Batch distance = Batch::set(op.da);
+        rodC[op.out] = dx * scale;
+        rodS[op.out] = dy * scale;
+        rodX[op.out] = jointX[op.a] - distance * rodC[op.out];
+        rodY[op.out] = jointY[op.a] - distance * rodS[op.out];
+        if (op.code == CompiledLinkage::OP_ROD_TWO_POINTS) {
+          miss = batchMax(miss, batchAbs(length - Batch::set(std::fabs(op.db - op.da))));
+        }
+        break;
+      }
+
+      case CompiledLinkage::OP_ROD_SPAN: {
+        Batch scale = Batch::set(op.sign / std::fabs(op.db - op.da));
+        Batch distance = Batch::set(op.da);
+        rodC[op.out] = (jointX[op.b] - jointX[op.a]) * scale;
+        rodS[op.out] = (jointY[op.b] - jointY[op.a]) * scale;
+        rodX[op.out] = jointX[op.a] - distance * rodC[op.out];
+        rodY[op.out] = jointY[op.a] - distance * rodS[op.out];
+        break;
+      }
+
+      case CompiledLinkage::OP_CIRCLES: {
+        Batch dx = jointX[op.b] - jointX[op.a];
+        Batch dy = jointY[op.b] - jointY[op.a];
+        Batch distanceSquared = dx * dx + dy * dy;
+        Batch inverse = batchRsqrt(batchMax(distanceSquared, spanSquared));
+        Batch d = batchMax(distanceSquared * inverse, span);
+        Batch ex = dx * inverse, ey = dy * inverse;
+        Batch along = (d * d + Batch::set(op.da * op.da - op.db * op.db)) * inverse * Batch::set(0.5);
+        Batch heightSquared = batchMax(Batch::set(op.da * op.da) - along * along, zero);
+        Batch h = Batch::set(op.sign) * heightSquared * batchRsqrt(batchMax(heightSquared, smallest));
+        jointX[op.out] = jointX[op.a] + along * ex - h * ey;
+        jointY[op.out] = jointY[op.a] + along * ey + h * ex;
+        miss = batchMax(miss, batchMax(d - Batch::set(op.da + op.db), Batch::set(std::fabs(op.da - op.db)) - d));
+        break;
+      }
+
+      case CompiledLinkage::OP_NEWTON:
+        // Not reached: supported() is false for programs with Newton blocks
+        break;
+    }
+  }
+  return miss;
+}
+
+} // namespace cycloid
@@ -0,0 +1,71 @@
+/**
+ * BatchEvaluator.h
+ *
+ * Runs a compiled linkage program on BATCH_SAMPLES evenly spaced samples
+ * at once. Every joint and rod is stored as a structure of arrays (one
+ * Batch per coordinate), so each operation is a handful of SIMD
+ * instructions shared by the whole batch, and pen positions go straight
+ * into the caller's x/y buffers.
+ *
+ * Wheel angles advance by a fixed rotation from one batch to the next
+ * instead of calling sin/cos per sample, and are recomputed exactly every
+ * BATCH_REANCHOR batches so rounding cannot build up.
+ *
+ * Samples are independent only when the program is closed form; a machine
+ * with Newton blocks (warm-started from the previous sample) is not
+ * supported and must go through CompiledLinkage::solve(), as must a machine
+ * whose wheels have an LFO (their speed is not constant).
+ */
+
+#ifndef BATCH_EVALUATOR_H
+#define BATCH_EVALUATOR_H
+
+#include <cstddef>
+#include <vector>
+
+#include "CompiledLinkage.h"
+#include "SimdBatch.h"
+
+namespace cycloid {
+
+#define BATCH_REANCHOR 64   // Batches between exact sin/cos evaluations
+
+class BatchEvaluator {
+ public:
+  explicit BatchEvaluator(const CompiledLinkage& linkage);
+
+  bool supported() const { return closedForm; }
+
+  // Pen positions at t = dt * (first + i) for i < count, as the samples
+  // of generatePath(); only call when supported()
+  void evaluate(double dt, size_t first, size_t count, double* x, double* y);
+
+  // Every sample counts as one with no iterations, as in CompiledLinkage
+  const SolverStats& stats() const { return solverStats; }
+
+  static const char* instructionSet() { return SIMD_INSTRUCTION_SET; }
+
+ private:
+  void anchorAngles(double dt, size_t first);
+  void advanceAngles();
+  Batch runProgram();
+
+  const CompiledLinkage& linkage;
+  const Machine& machine;
+  bool closedForm = true;
+  double minSpan = 0, failureBound = 0;
+
+  // Angle slot 0 is the canvas, slot 1 + i wheel i
+  std::vector<double> angleRates;
+  std::vector<Batch> angleCos, angleSin;
+  std::vector<double> stepCos, stepSin;     // Rotation from one batch to the next
+  double canvasX = 0, canvasY = 0;
+
+  std::vector<Batch> jointX, jointY;
+  std::vector<Batch> rodX, rodY, rodC, rodS;
+  SolverStats solverStats;
+};
+
+} // namespace cycloid
+
+#endif // BATCH_EVALUATOR_H
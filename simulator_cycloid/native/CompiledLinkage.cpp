@@ -0,0 +1,572 @@
+/**
+ * CompiledLinkage.cpp
+ *
+ * Orders the rod network into closed-form operations. Rod points pinned
+ * together (directly or through a chain of connections) form one joint;
+ * joints on a wheel are known from the wheel pose. From there the compiler
+ * repeatedly places any rod with two known joints (or one and a slider
+ * target) and intersects circles at joints shared by two rods that each
+ * hang from one known joint. When neither applies, what is left of that
+ * group of rods becomes a Newton block: a closed loop when it has as many
+ * constraints as unknowns, a free degree of freedom when it has fewer.
+ *
+ * A constraint the program never uses is a redundant one, which closes a
+ * loop through rods already placed; the whole group is then recompiled as
+ * a single Newton block so the solution still satisfies it.
+ */
+
+#include "CompiledLinkage.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace cycloid {
+
+// --- Forward Declarations for Static Functions ---
+static RodPose assemblyPose(const Rod& rod);
+static int findRoot(std::vector<int>& parent, int i);
+
+CompiledLinkage::CompiledLinkage(const Machine& machine) : machine(machine) {
+  buildNetwork();
+  compile();
+
+  for (const std::vector<int>& rods : blockRods) blocks.emplace_back(new LinkageSolver(machine, rods));
+  wheelPoses.resize(machine.wheels.size());
+  jointX.resize(jointNodes.size());
+  jointY.resize(jointNodes.size());
+  poses.resize(machine.rods.size());
+  reset();
+}
+
+void CompiledLinkage::reset() {
+  for (size_t r = 0; r < machine.rods.size(); r++) poses[r] = assemblyPose(machine.rods[r]);
+  jointX = assemblyX;
+  jointY = assemblyY;
+  for (auto& block : blocks) block->reset();
+  hasPrevious = false;
+  solverStats = SolverStats();
+}
+
+bool CompiledLinkage::solve(double t) {
+  unsigned int iterations = 0;
+  double residual;
+  bool slow = false;
+  bool ok = runProgram(t, iterations, residual, slow);
+  bool substeps = slow && hasPrevious && t != previousTime;
+
+  // A Newton block struggled: walk up from the last sample in finer steps, as LinkageSolver::solve()
+  double previousResidual = residual;
+  for (unsigned int count = 2; substeps && count <= SOLVER_MAX_SUBSTEPS; count *= 2) {
+    for (auto& block : blocks) block->rewind();
+    slow = false;
+    for (unsigned int i = 1; i <= count; i++) {
+      ok = runProgram(previousTime + (t - previousTime) * i / count, iterations, residual, slow);
+    }
+    if (!slow || residual >= 0.5 * previousResidual) break;
+    previousResidual = residual;
+  }
+
+  for (auto& block : blocks) block->accept();
+  previousTime = t;
+  hasPrevious = true;
+  solverStats.record(iterations, substeps, ok, residual);
+  return ok;
+}
+
+bool CompiledLinkage::runProgram(double t, unsigned int& iterations, double& residual, bool& slow) {
+  computeWheelPoses(machine, t, wheelPoses.data());
+
+  const double minSpan = COMPILED_MIN_SPAN * lengthScale;
+  double miss = 0;
+  bool converged = true;
+  for (const Op& op : program) {
+    switch (op.code) {
+      case OP_WHEEL_POINT:
+        wheelPointPosition(wheelPoses[op.a], op.da, jointX[op.out], jointY[op.out]);
+        break;
+
+      case OP_ROD_POINT:
+        rodPointPosition(poses[op.a], op.da, jointX[op.out], jointY[op.out]);
+        break;
+
+      case OP_ROD_TWO_POINTS:
+      case OP_ROD_SLIDER: {
+        double dx = jointX[op.b] - jointX[op.a];
+        double dy = jointY[op.b] - jointY[op.a];
+        double span = std::sqrt(dx * dx + dy * dy);
+        double scale = op.sign / std::max(span, minSpan);
+        RodPose& pose = poses[op.out];
+        pose.c = dx * scale;
+        pose.s = dy * scale;
+        pose.x = jointX[op.a] - op.da * pose.c;
+        pose.y = jointY[op.a] - op.da * pose.s;
+        // A rigid rod between two independently placed points must fit
+        if (op.code == OP_ROD_TWO_POINTS) miss = std::max(miss, std::fabs(span - std::fabs(op.db - op.da)));
+        break;
+      }
+
+      case OP_ROD_SPAN: {
+        // The circle intersection already put the joints one rod span apart (or counted the miss)
+        double scale = op.sign / std::fabs(op.db - op.da);
+        RodPose& pose = poses[op.out];
+        pose.c = (jointX[op.b] - jointX[op.a]) * scale;
+        pose.s = (jointY[op.b] - jointY[op.a]) * scale;
+        pose.x = jointX[op.a] - op.da * pose.c;
+        pose.y = jointY[op.a] - op.da * pose.s;
+        break;
+      }
+
+      case OP_CIRCLES: {
+        double dx = jointX[op.b] - jointX[op.a];
+        double dy = jointY[op.b] - jointY[op.a];
+        double d = std::max(std::sqrt(dx * dx + dy * dy), minSpan);
+        double ex = dx / d, ey = dy / d;
+        double along = (d * d + op.da * op.da - op.db * op.db) / (2 * d);
+        // Out of reach: take the nearest point and record how far off it is
+        double h = op.sign * std::sqrt(std::max(op.da * op.da - along * along, 0.0));
+        jointX[op.out] = jointX[op.a] + along * ex - h * ey;
+        jointY[op.out] = jointY[op.a] + along * ey + h * ex;
+        miss = std::max(miss, std::max(d - (op.da + op.db), std::fabs(op.da - op.db) - d));
+        break;
+      }
+
+      case OP_NEWTON: {
+        LinkageSolver& block = *blocks[op.a];
+        converged = block.solveBlock(wheelPoses.data(), poses.data()) && converged;
+        iterations += block.lastIterations();
+        miss = std::max(miss, block.lastResidual());
+        slow = slow || block.degraded();
+        break;
+      }
+    }
+  }
+
+  residual = miss;
+  return converged && miss < COMPILED_FAILURE_BOUND * lengthScale;
+}
+
+void CompiledLinkage::penPosition(double& x, double& y) const {
+  rodPointPosition(poses[machine.penRod], machine.rods[machine.penRod].penDistance, x, y);
+}
+
+std::string CompiledLinkage::listing() const {
+  std::string text;
+  char line[256];
+  snprintf(line, sizeof(line), "%zu operations, %zu Newton blocks\n", program.size(), blocks.size());
+  text += line;
+
+  for (const Op& op : program) {
+    switch (op.code) {
+      case OP_WHEEL_POINT:
+        snprintf(line, sizeof(line), "  %-16s = wheel %d point at r=%g\n", jointName(op.out).c_str(),
+                 machine.wheels[op.a].id, op.da);
+        break;
+      case OP_ROD_POINT:
+        snprintf(line, sizeof(line), "  %-16s = rod %d at %g\n", jointName(op.out).c_str(), machine.rods[op.a].id, op.da);
+        break;
+      case OP_ROD_TWO_POINTS:
+        snprintf(line, sizeof(line), "  rod %-12d through %s and %s\n", machine.rods[op.out].id, jointName(op.a).c_str(),
+                 jointName(op.b).c_str());
+        break;
+      case OP_ROD_SPAN:
+        snprintf(line, sizeof(line), "  rod %-12d through %s and %s, %g apart\n", machine.rods[op.out].id,
+                 jointName(op.a).c_str(), jointName(op.b).c_str(), std::fabs(op.db - op.da));
+        break;
+      case OP_ROD_SLIDER:
+        snprintf(line, sizeof(line), "  rod %-12d from %s, sliding through %s\n", machine.rods[op.out].id,
+                 jointName(op.a).c_str(), jointName(op.b).c_str());
+        break;
+      case OP_CIRCLES:
+        snprintf(line, sizeof(line), "  %-16s = circles %s r=%g, %s r=%g, branch %c\n", jointName(op.out).c_str(),
+                 jointName(op.a).c_str(), op.da, jointName(op.b).c_str(), op.db, op.sign > 0 ? '+' : '-');
+        break;
+      case OP_NEWTON: {
+        std::string rods;
+        for (int r : blockRods[op.a]) rods += " " + std::to_string(machine.rods[r].id);
+        snprintf(line, sizeof(line), "  Newton block %d, rods%s\n", op.a, rods.c_str());
+        break;
+      }
+    }
+    text += line;
+  }
+  return text;
+}
+
+// --- Compilation ---
+
+void CompiledLinkage::buildNetwork() {
+  const size_t rodCount = machine.rods.size();
+  std::vector<int> rodPointNode(3 * rodCount, -1);
+  std::vector<int> parent;
+
+  auto rodNode = [&](int rod, RodPointKind point) {
+    int& node = rodPointNode[3 * rod + point];
+    if (node < 0) {
+      node = (int)nodes.size();
+      nodes.push_back({ rod, point, -1, machine.rods[rod].pointDistance(point) });
+      parent.push_back(node);
+    }
+    return node;
+  };
+  // Points are keyed by radius: every point of a wheel starts on its +x axis
+  auto wheelNode = [&](int wheel, double radius) {
+    for (size_t n = 0; n < nodes.size(); n++) {
+      if (nodes[n].rod < 0 && nodes[n].wheel == wheel && nodes[n].distance == radius) return (int)n;
+    }
+    nodes.push_back({ -1, ROD_START, wheel, radius });
+    parent.push_back((int)parent.size());
+    return (int)nodes.size() - 1;
+  };
+
+  for (size_t r = 0; r < rodCount; r++) {
+    const Rod& rod = machine.rods[r];
+    for (int p = ROD_START; p <= ROD_END; p++) {
+      RodPointKind point = (RodPointKind)p;
+      const JointTarget& target = rod.target(point);
+      if (target.kind == JointTarget::NONE) continue;
+      int targetNode = (target.kind == JointTarget::WHEEL_POINT) ? wheelNode(target.index, target.radius)
+                                                                 : rodNode(target.index, target.rodPoint);
+      if (point == ROD_MID && !rod.fixedLength) {
+        sliders.push_back({ (int)r, targetNode });
+      } else {
+        parent[findRoot(parent, rodNode((int)r, point))] = findRoot(parent, targetNode);
+      }
+    }
+  }
+
+  // Joints in node order
+  std::vector<int> rootJoint(nodes.size(), -1);
+  nodeJoint.resize(nodes.size());
+  rodNodes.resize(rodCount);
+  for (size_t n = 0; n < nodes.size(); n++) {
+    int root = findRoot(parent, (int)n);
+    if (rootJoint[root] < 0) {
+      rootJoint[root] = (int)jointNodes.size();
+      jointNodes.emplace_back();
+    }
+    nodeJoint[n] = rootJoint[root];
+    jointNodes[nodeJoint[n]].push_back((int)n);
+    if (nodes[n].rod >= 0) rodNodes[nodes[n].rod].push_back((int)n);
+  }
+
+  // Groups of rods coupled through joints that no wheel pins down
+  std::vector<int> rodParent(rodCount);
+  for (size_t r = 0; r < rodCount; r++) rodParent[r] = (int)r;
+  auto hasWheel = [&](int joint) {
+    for (int n : jointNodes[joint]) {
+      if (nodes[n].rod < 0) return true;
+    }
+    return false;
+  };
+  auto joinJointRods = [&](int joint, int rod) {
+    for (int n : jointNodes[joint]) {
+      if (nodes[n].rod >= 0) rodParent[findRoot(rodParent, nodes[n].rod)] = findRoot(rodParent, rod);
+    }
+  };
+  for (size_t j = 0; j < jointNodes.size(); j++) {
+    int first = nodes[jointNodes[j][0]].rod;
+    if (!hasWheel((int)j) && first >= 0) joinJointRods((int)j, first);
+  }
+  for (const Slider& slider : sliders) {
+    if (!hasWheel(nodeJoint[slider.node])) joinJointRods(nodeJoint[slider.node], slider.rod);
+  }
+  std::vector<int> rootComponent(rodCount, -1);
+  int componentCount = 0;
+  rodComponent.resize(rodCount);
+  for (size_t r = 0; r < rodCount; r++) {
+    int root = findRoot(rodParent, (int)r);
+    if (rootComponent[root] < 0) rootComponent[root] = componentCount++;
+    rodComponent[r] = rootComponent[root];
+  }
+
+  // Joint positions in the assembly pose decide branches and directions
+  std::vector<WheelPose> startPoses(machine.wheels.size());
+  computeWheelPoses(machine, 0, startPoses.data());
+  assemblyX.assign(jointNodes.size(), 0);
+  assemblyY.assign(jointNodes.size(), 0);
+  for (size_t j = 0; j < jointNodes.size(); j++) {
+    int rodPoints = 0;
+    for (int n : jointNodes[j]) {
+      if (nodes[n].rod < 0) continue;
+      double x, y;
+      rodPointPosition(assemblyPose(machine.rods[nodes[n].rod]), nodes[n].distance, x, y);
+      assemblyX[j] += x;
+      assemblyY[j] += y;
+      rodPoints++;
+    }
+    if (rodPoints > 0) {
+      assemblyX[j] /= rodPoints;
+      assemblyY[j] /= rodPoints;
+    } else {
+      const Node& node = nodes[jointNodes[j][0]];
+      wheelPointPosition(startPoses[node.wheel], node.distance, assemblyX[j], assemblyY[j]);
+    }
+  }
+
+  for (const Rod& rod : machine.rods) lengthScale = std::max(lengthScale, rod.length);
+}
+
+void CompiledLinkage::compile() {
+  int componentCount = 0;
+  for (int component : rodComponent) componentCount = std::max(componentCount, component + 1);
+  std::vector<bool> forcedNewton(componentCount, false);
+
+  // A joint on two different wheel points can only be met in the least-squares sense
+  for (const std::vector<int>& joint : jointNodes) {
+    int wheel = -1;
+    bool conflict = false;
+    for (int n : joint) {
+      if (nodes[n].rod >= 0) continue;
+      conflict = conflict || wheel >= 0;
+      wheel = n;
+    }
+    if (!conflict) continue;
+    for (int n : joint) {
+      if (nodes[n].rod >= 0) forcedNewton[rodComponent[nodes[n].rod]] = true;
+    }
+  }
+
+  for (;;) {
+    int redundant = compileAttempt(forcedNewton);
+    if (redundant < 0 || forcedNewton[redundant]) break;
+    forcedNewton[redundant] = true;
+  }
+}
+
+// Returns the first group with an unused (redundant) constraint, or -1
+int CompiledLinkage::compileAttempt(const std::vector<bool>& forcedNewton) {
+  program.clear();
+  blockRods.clear();
+
+  const size_t rodCount = machine.rods.size(), jointCount = jointNodes.size();
+  const double minSpan = COMPILED_MIN_SPAN * lengthScale;
+  std::vector<bool> jointKnown(jointCount, false), rodKnown(rodCount, false);
+  std::vector<bool> nodeUsed(nodes.size(), false), sliderUsed(sliders.size(), false);
+  // Per joint placed by circles: each rod used and the joint it hangs from
+  std::vector<std::vector<std::pair<int, int>>> circleRods(jointCount);
+
+  // Rod placed: every joint on it that is still open follows from it
+  auto placeRod = [&](int rod) {
+    rodKnown[rod] = true;
+    for (int n : rodNodes[rod]) {
+      int joint = nodeJoint[n];
+      if (jointKnown[joint]) continue;
+      Op op;
+      op.code = OP_ROD_POINT;
+      op.out = joint;
+      op.a = rod;
+      op.da = nodes[n].distance;
+      program.push_back(op);
+      jointKnown[joint] = true;
+      nodeUsed[n] = true;
+    }
+  };
+  auto placeBlock = [&](const std::vector<int>& rods) {
+    Op op;
+    op.code = OP_NEWTON;
+    op.a = (int)blockRods.size();
+    program.push_back(op);
+    blockRods.push_back(rods);
+
+    std::vector<bool> inBlock(rodCount, false);
+    for (int r : rods) inBlock[r] = true;
+    for (int r : rods) {
+      for (int n : rodNodes[r]) nodeUsed[n] = true;
+    }
+    for (size_t s = 0; s < sliders.size(); s++) {
+      int targetRod = nodes[sliders[s].node].rod;
+      if (inBlock[sliders[s].rod] || (targetRod >= 0 && inBlock[targetRod])) sliderUsed[s] = true;
+    }
+    for (int r : rods) placeRod(r);
+  };
+  auto firstKnownNode = [&](int rod) {
+    for (int n : rodNodes[rod]) {
+      if (jointKnown[nodeJoint[n]]) return n;
+    }
+    return -1;
+  };
+
+  for (size_t j = 0; j < jointCount; j++) {
+    for (int n : jointNodes[j]) {
+      if (nodes[n].rod >= 0 || jointKnown[j]) continue;
+      Op op;
+      op.code = OP_WHEEL_POINT;
+      op.out = (int)j;
+      op.a = nodes[n].wheel;
+      op.da = nodes[n].distance;
+      program.push_back(op);
+      jointKnown[j] = true;
+    }
+  }
+
+  for (size_t c = 0; c < forcedNewton.size(); c++) {
+    if (!forcedNewton[c]) continue;
+    std::vector<int> rods;
+    for (size_t r = 0; r < rodCount; r++) {
+      if (rodComponent[r] == (int)c) rods.push_back((int)r);
+    }
+    placeBlock(rods);
+  }
+
+  for (;;) {
+    bool progress = false;
+
+    // Rods with two known points, or one and a known slider target
+    for (size_t r = 0; r < rodCount && !progress; r++) {
+      if (rodKnown[r]) continue;
+      const std::vector<int>& rodPoints = rodNodes[r];
+      int bestA = -1, bestB = -1;
+      double bestSpan = minSpan;
+      for (size_t i = 0; i < rodPoints.size(); i++) {
+        for (size_t k = i + 1; k < rodPoints.size(); k++) {
+          int a = rodPoints[i], b = rodPoints[k];
+          if (!jointKnown[nodeJoint[a]] || !jointKnown[nodeJoint[b]] || nodeJoint[a] == nodeJoint[b]) continue;
+          double span = std::fabs(nodes[b].distance - nodes[a].distance);
+          if (span > bestSpan) {
+            bestSpan = span;
+            bestA = a;
+            bestB = b;
+          }
+        }
+      }
+      if (bestA >= 0) {
+        Op op;
+        op.code = OP_ROD_TWO_POINTS;
+        op.out = (int)r;
+        op.a = nodeJoint[bestA];
+        op.b = nodeJoint[bestB];
+        op.da = nodes[bestA].distance;
+        op.db = nodes[bestB].distance;
+        op.sign = (op.db > op.da) ? 1 : -1;
+        // The rod hung one of its joints from the other in a circle intersection: no need to measure it
+        for (const auto& used : circleRods[op.b]) {
+          if (used.first == (int)r && used.second == op.a) op.code = OP_ROD_SPAN;
+        }
+        for (const auto& used : circleRods[op.a]) {
+          if (used.first == (int)r && used.second == op.b) op.code = OP_ROD_SPAN;
+        }
+        program.push_back(op);
+        nodeUsed[bestA] = nodeUsed[bestB] = true;
+        placeRod((int)r);
+        progress = true;
+        break;
+      }
+
+      int known = firstKnownNode((int)r);
+      if (known < 0) continue;
+      for (size_t s = 0; s < sliders.size(); s++) {
+        int target = nodeJoint[sliders[s].node];
+        if (sliderUsed[s] || sliders[s].rod != (int)r || !jointKnown[target] || target == nodeJoint[known]) continue;
+        Op op;
+        op.code = OP_ROD_SLIDER;
+        op.out = (int)r;
+        op.a = nodeJoint[known];
+        op.b = target;
+        op.da = nodes[known].distance;
+        // The rod runs from its known point towards the target or away from it, as assembled
+        RodPose pose = assemblyPose(machine.rods[r]);
+        double along = (assemblyX[op.b] - assemblyX[op.a]) * pose.c + (assemblyY[op.b] - assemblyY[op.a]) * pose.s;
+        op.sign = (along >= 0) ? 1 : -1;
+        program.push_back(op);
+        nodeUsed[known] = true;
+        sliderUsed[s] = true;
+        placeRod((int)r);
+        progress = true;
+        break;
+      }
+    }
+    if (progress) continue;
+
+    // A joint shared by two rods that each hang from one known point
+    for (size_t j = 0; j < jointCount && !progress; j++) {
+      if (jointKnown[j]) continue;
+      std::vector<int> rods;
+      Op op;
+      op.code = OP_CIRCLES;
+      op.out = (int)j;
+      for (int n : jointNodes[j]) {
+        int rod = nodes[n].rod;
+        if (rod < 0 || rodKnown[rod] || std::find(rods.begin(), rods.end(), rod) != rods.end()) continue;
+        int anchor = -1, anchorCount = 0;
+        for (int k : rodNodes[rod]) {
+          if (!jointKnown[nodeJoint[k]]) continue;
+          if (anchor < 0 || nodeJoint[k] != nodeJoint[anchor]) anchorCount++;
+          if (anchor < 0) anchor = k;
+        }
+        double radius = (anchor >= 0) ? std::fabs(nodes[n].distance - nodes[anchor].distance) : 0;
+        if (anchorCount != 1 || radius <= minSpan) continue;
+        if (rods.empty()) {
+          op.a = nodeJoint[anchor];
+          op.da = radius;
+        } else {
+          op.b = nodeJoint[anchor];
+          op.db = radius;
+        }
+        rods.push_back(rod);
+        if (rods.size() == 2) break;
+      }
+      if (rods.size() < 2 || op.a == op.b) continue;
+
+      // Keep the side of the line between the anchors that the XML was drawn on
+      double cross = (assemblyX[op.b] - assemblyX[op.a]) * (assemblyY[j] - assemblyY[op.a]) -
+                     (assemblyY[op.b] - assemblyY[op.a]) * (assemblyX[j] - assemblyX[op.a]);
+      op.sign = (cross >= 0) ? 1 : -1;
+      program.push_back(op);
+      jointKnown[j] = true;
+      circleRods[j] = { { rods[0], op.a }, { rods[1], op.b } };
+      progress = true;
+    }
+    if (progress) continue;
+
+    // Stuck: the rest of the first group with an unplaced rod is a closed loop or has a
+    // free degree of freedom. Either way the block solves it; the damping floor makes the
+    // step from the previous sample minimum-norm, so free rods move only as far as needed.
+    int first = -1;
+    for (size_t r = 0; r < rodCount && first < 0; r++) {
+      if (!rodKnown[r]) first = (int)r;
+    }
+    if (first < 0) break;
+    std::vector<int> openRods;
+    for (size_t r = 0; r < rodCount; r++) {
+      if (!rodKnown[r] && rodComponent[r] == rodComponent[first]) openRods.push_back((int)r);
+    }
+    placeBlock(openRods);
+  }
+
+  for (size_t n = 0; n < nodes.size(); n++) {
+    if (nodes[n].rod >= 0 && !nodeUsed[n]) return rodComponent[nodes[n].rod];
+  }
+  for (size_t s = 0; s < sliders.size(); s++) {
+    if (!sliderUsed[s]) return rodComponent[sliders[s].rod];
+  }
+  return -1;
+}
+
+std::string CompiledLinkage::jointName(int joint) const {
+  static const char* pointNames[] = { "start", "mid", "end" };
+  for (int n : jointNodes[joint]) {
+    if (nodes[n].rod >= 0) return "rod_" + std::to_string(machine.rods[nodes[n].rod].id) + "_" + pointNames[nodes[n].point];
+  }
+  const Node& node = nodes[jointNodes[joint][0]];
+  char name[64];
+  snprintf(name, sizeof(name), "wheel_%d r=%g", machine.wheels[node.wheel].id, node.distance);
+  return name;
+}
+
+// --- Internal Helpers ---
+
+static RodPose assemblyPose(const Rod& rod) {
+  double angle = std::atan2(rod.endY - rod.startY, rod.endX - rod.startX);
+  return { rod.startX, rod.startY, std::cos(angle), std::sin(angle) };
+}
+
+static int findRoot(std::vector<int>& parent, int i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+} // namespace cycloid
@@ -0,0 +1,126 @@
+/**
+ * CompiledLinkage.h
+ *
+ * Closed-form evaluation of a machine's rod network. At load time the
+ * connections are ordered into a flat program that places each joint and
+ * rod once per sample: wheel points first, then rods from two known points
+ * or from a known point and a slider target, and joints shared by two
+ * half-placed rods as circle-circle intersections. A group of rods that
+ * cannot be ordered this way becomes a Newton block, solved by
+ * LinkageSolver with its neighbours already in place: either a closed
+ * loop, with as many constraints as unknowns, or a free degree of freedom,
+ * with fewer.
+ *
+ * Circle intersections take the branch the XML assembly pose is drawn in
+ * and keep it for every sample, so the linkage never flips. A free degree
+ * of freedom is not pinned by holding one rod at a fixed angle, which can
+ * leave the rest of the group out of reach; its block takes the
+ * minimum-norm step from the previous sample, as the whole-machine solver
+ * does.
+ */
+
+#ifndef COMPILED_LINKAGE_H
+#define COMPILED_LINKAGE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Kinematics.h"
+#include "LinkageSolver.h"
+#include "MachineModel.h"
+
+namespace cycloid {
+
+#define COMPILED_MIN_SPAN 1e-9       // Relative to the longest rod; shorter spans cannot orient a rod
+#define COMPILED_FAILURE_BOUND 1e-6  // Relative circle miss counted as a failure, as SOLVER_FAILURE_BOUND
+
+class CompiledLinkage {
+ public:
+  enum OpCode {
+    OP_WHEEL_POINT,     // joint <- wheel a at radius da
+    OP_ROD_POINT,       // joint <- point of rod a at distance da
+    OP_ROD_TWO_POINTS,  // rod <- joints a, b at distances da, db
+    OP_ROD_SPAN,        // As OP_ROD_TWO_POINTS, with b placed by a circle of radius |db - da| around a
+    OP_ROD_SLIDER,      // rod <- joint a at distance da, line through joint b
+    OP_CIRCLES,         // joint <- circles around joints a, b with radii da, db
+    OP_NEWTON           // rods of block a
+  };
+
+  struct Op {
+    OpCode code;
+    int out = -1;       // Joint or rod written
+    int a = -1, b = -1;
+    double da = 0, db = 0;
+    double sign = 1;    // Branch or direction, fixed from the assembly pose
+  };
+
+  explicit CompiledLinkage(const Machine& machine);
+
+  // Run the program at time t (seconds); false if a circle intersection
+  // had no solution (the nearest point is used) or a Newton block failed
+  bool solve(double t);
+
+  // Back to the assembly pose, including the Newton blocks' warm start
+  void reset();
+
+  void penPosition(double& x, double& y) const;
+  const RodPose& rodPose(size_t rodIndex) const { return poses[rodIndex]; }
+  // Closed-form samples count no iterations; Newton blocks add theirs
+  const SolverStats& stats() const { return solverStats; }
+
+  // One line per operation, as printed by `cycloid_sim compile`
+  std::string listing() const;
+  size_t operationCount() const { return program.size(); }
+  size_t newtonBlockCount() const { return blocks.size(); }
+
+  // The program itself, for evaluators that run it on several samples at once
+  const Machine& machineModel() const { return machine; }
+  const std::vector<Op>& operations() const { return program; }
+  size_t jointCount() const { return jointNodes.size(); }
+  double lengthUnit() const { return lengthScale; }   // Longest rod; scales the bounds above
+
+ private:
+  struct Node {
+    int rod;            // -1 for a wheel point
+    RodPointKind point;
+    int wheel;
+    double distance;    // Along the rod, or the wheel point radius
+  };
+
+  struct Slider {
+    int rod;
+    int node;           // Target node
+  };
+
+  bool runProgram(double t, unsigned int& iterations, double& residual, bool& slow);
+  void buildNetwork();
+  void compile();
+  int compileAttempt(const std::vector<bool>& forcedNewton);
+  std::string jointName(int joint) const;
+
+  const Machine& machine;
+  std::vector<Node> nodes;
+  std::vector<int> nodeJoint;
+  std::vector<std::vector<int>> jointNodes;
+  std::vector<std::vector<int>> rodNodes;
+  std::vector<Slider> sliders;
+  std::vector<int> rodComponent;
+  std::vector<double> assemblyX, assemblyY;   // Joint positions in the XML pose
+  double lengthScale = 1.0;
+
+  std::vector<Op> program;
+  std::vector<std::vector<int>> blockRods;
+  std::vector<std::unique_ptr<LinkageSolver>> blocks;
+
+  std::vector<WheelPose> wheelPoses;
+  std::vector<double> jointX, jointY;
+  std::vector<RodPose> poses;
+  double previousTime = 0;
+  bool hasPrevious = false;
+  SolverStats solverStats;
+};
+
+} // namespace cycloid
+
+#endif // COMPILED_LINKAGE_H
@@ -0,0 +1,40 @@
+/**
+ * Kinematics.cpp
+ *
+ * Implements wheel poses for the native simulator
+ */
+
+#include "Kinematics.h"
+
+#include <cmath>
+
+namespace cycloid {
+
+void computeWheelPoses(const Machine& machine, double t, WheelPose* poses) {
+  double canvasAngle = 0, canvasX = 0, canvasY = 0;
+  if (machine.canvasWheel >= 0) {
+    const Wheel& canvas = machine.wheels[machine.canvasWheel];
+    canvasAngle = wheelRotation(machine, machine.canvasWheel, t);
+    canvasX = canvas.centerX;
+    canvasY = canvas.centerY;
+  }
+  double c = std::cos(canvasAngle), s = std::sin(canvasAngle);
+
+  for (size_t i = 0; i < machine.wheels.size(); i++) {
+    const Wheel& wheel = machine.wheels[i];
+    WheelPose& pose = poses[i];
+    if ((int)i == machine.canvasWheel) {
+      pose.centerX = canvasX;
+      pose.centerY = canvasY;
+      pose.angle = canvasAngle;
+      continue;
+    }
+    // Center is fixed in the canvas frame
+    double dx = wheel.centerX - canvasX, dy = wheel.centerY - canvasY;
+    pose.centerX = canvasX + c * dx - s * dy;
+    pose.centerY = canvasY + s * dx + c * dy;
+    pose.angle = canvasAngle + wheelRotation(machine, i, t);
+  }
+}
+
+} // namespace cycloid
@@ -0,0 +1,35 @@
+/**
+ * Kinematics.h
+ *
+ * Wheel motion for the native simulator, matching sympy_solver.py: the
+ * canvas wheel turns about its fixed center, every other wheel is carried
+ * by the canvas frame and turns relative to it, and a connection point at
+ * radius r sits at angle 0 (+x) when t = 0. Wheel angles come from
+ * wheelRotation(), so a wheel LFO bends the speed as on the machine.
+ */
+
+#ifndef KINEMATICS_H
+#define KINEMATICS_H
+
+#include <cmath>
+
+#include "MachineModel.h"
+
+namespace cycloid {
+
+struct WheelPose {
+  double centerX, centerY;   // World frame
+  double angle;              // World frame, radians
+};
+
+// Pose of every wheel at time t (seconds); poses has machine.wheels.size() entries
+void computeWheelPoses(const Machine& machine, double t, WheelPose* poses);
+
+inline void wheelPointPosition(const WheelPose& pose, double radius, double& x, double& y) {
+  x = pose.centerX + radius * std::cos(pose.angle);
+  y = pose.centerY + radius * std::sin(pose.angle);
+}
+
+} // namespace cycloid
+
+#endif // KINEMATICS_H
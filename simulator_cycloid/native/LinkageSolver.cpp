@@ -0,0 +1,337 @@
+/**
+ * LinkageSolver.cpp
+ *
+ * Levenberg-Marquardt on the pin and slider constraints with analytic
+ * Jacobians, warm-started from the previous sample. The damping never
+ * drops below a small floor, which gives the minimum-norm step when a
+ * machine is under-constrained (a rod hanging from a single pin keeps its
+ * angle instead of wandering), like scipy's 'lm' method. It grows when a
+ * step would increase the residual, so the iteration cannot run off to
+ * another branch.
+ */
+
+#include "LinkageSolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace cycloid {
+
+#define SOLVER_MAX_ITERATIONS 50
+#define SOLVER_TOLERANCE 1e-9        // Relative to the longest rod
+#define SOLVER_FAILURE_BOUND 1e-6    // Relative residual counted as a failure
+#define SOLVER_DAMPING 1e-10         // Damping floor, relative to the largest normal-matrix diagonal
+#define SOLVER_DAMPING_MAX 1e6       // Give up on a sample when the damping has to grow past this
+#define SOLVER_STALL 1e-6            // Relative drop in squared residual below which an infeasible sample stops
+
+// --- Forward Declarations for Static Functions ---
+static bool choleskySolve(double* a, double* b, size_t n);
+
+LinkageSolver::LinkageSolver(const Machine& machine) : machine(machine) {
+  for (size_t r = 0; r < machine.rods.size(); r++) blockRods.push_back((int)r);
+  buildPins();
+}
+
+LinkageSolver::LinkageSolver(const Machine& machine, const std::vector<int>& blockRods)
+    : machine(machine), blockRods(blockRods) {
+  buildPins();
+}
+
+void LinkageSolver::buildPins() {
+  localIndex.assign(machine.rods.size(), -1);
+  for (size_t i = 0; i < blockRods.size(); i++) localIndex[blockRods[i]] = (int)i;
+
+  double longest = 1.0;
+  for (size_t r = 0; r < machine.rods.size(); r++) {
+    const Rod& rod = machine.rods[r];
+    if (localIndex[r] >= 0) longest = std::max(longest, rod.length);
+
+    for (int p = ROD_START; p <= ROD_END; p++) {
+      RodPointKind point = (RodPointKind)p;
+      const JointTarget& target = rod.target(point);
+      if (target.kind == JointTarget::NONE) continue;
+
+      // Only constraints touching the block; the rest are someone else's problem
+      bool touchesBlock = localIndex[r] >= 0 || (target.kind == JointTarget::ROD_POINT && localIndex[target.index] >= 0);
+      if (!touchesBlock) continue;
+
+      // Both rods usually name each other; keep one copy of the joint
+      if (target.kind == JointTarget::ROD_POINT && (size_t)target.index < r) {
+        const JointTarget& back = machine.rods[target.index].target(target.rodPoint);
+        if (back.kind == JointTarget::ROD_POINT && (size_t)back.index == r && back.rodPoint == point) continue;
+      }
+
+      Pin pin;
+      pin.rod = (int)r;
+      pin.distance = rod.pointDistance(point);
+      pin.kind = target.kind;
+      pin.target = target.index;
+      pin.targetValue = (target.kind == JointTarget::WHEEL_POINT) ? target.radius
+                                                                  : machine.rods[target.index].pointDistance(target.rodPoint);
+      pin.slider = (point == ROD_MID && !rod.fixedLength);
+      pins.push_back(pin);
+    }
+  }
+
+  unknownCount = 3 * blockRods.size();
+  equationCount = 0;
+  for (const Pin& pin : pins) equationCount += pin.slider ? 1 : 2;
+  tolerance = SOLVER_TOLERANCE * longest;
+
+  wheelPoses.resize(machine.wheels.size());
+  poses.resize(machine.rods.size());
+  residuals.resize(equationCount);
+  trial.resize(equationCount);
+  jacobian.resize(equationCount * unknownCount);
+  normal.resize(unknownCount * unknownCount);
+  gradient.resize(unknownCount);
+  step.resize(unknownCount);
+  qTrial.resize(unknownCount);
+  blockPoses.resize(blockRods.size());
+  reset();
+}
+
+void LinkageSolver::reset() {
+  q.assign(unknownCount, 0.0);
+  for (size_t r = 0; r < machine.rods.size(); r++) {
+    const Rod& rod = machine.rods[r];
+    double angle = std::atan2(rod.endY - rod.startY, rod.endX - rod.startX);
+    poses[r] = { rod.startX, rod.startY, std::cos(angle), std::sin(angle) };
+    int local = localIndex[r];
+    if (local < 0) continue;
+    q[3 * local] = rod.startX;
+    q[3 * local + 1] = rod.startY;
+    q[3 * local + 2] = angle;
+  }
+  accepted = q;
+  hasAccepted = false;
+  solverStats = SolverStats();
+}
+
+bool LinkageSolver::solve(double t) {
+  bool ok = solveAt(t);
+  unsigned int iterations = iterationsUsed;
+  bool substeps = degraded() && hasAccepted && t != acceptedTime;
+
+  // Walk up from the last good sample in finer steps until each one converges quickly
+  double previousError = residualLeft;
+  for (unsigned int count = 2; substeps && count <= SOLVER_MAX_SUBSTEPS; count *= 2) {
+    rewind();
+    bool slow = false;
+    for (unsigned int i = 1; i <= count; i++) {
+      ok = solveAt(acceptedTime + (t - acceptedTime) * i / count);
+      iterations += iterationsUsed;
+      slow = slow || degraded();
+    }
+    // An infeasible pose stays infeasible however finely it is approached
+    if (!slow || residualLeft >= 0.5 * previousError) break;
+    previousError = residualLeft;
+  }
+
+  accept();
+  acceptedTime = t;
+  hasAccepted = true;
+  solverStats.record(iterations, substeps, ok, residualLeft);
+  return ok;
+}
+
+bool LinkageSolver::solveAt(double t) {
+  computeWheelPoses(machine, t, wheelPoses.data());
+  return solveBlock(wheelPoses.data(), poses.data());
+}
+
+bool LinkageSolver::solveBlock(const WheelPose* wheels, RodPose* fixed) {
+  const size_t n = unknownCount, m = equationCount;
+
+  computeResiduals(q.data(), wheels, fixed, residuals.data(), nullptr);
+  double cost = sumSquares(residuals.data());
+  double error = maxAbsResidual(residuals.data());
+  double damping = SOLVER_DAMPING;
+
+  unsigned int iteration = 0;
+  while (error >= tolerance && iteration < SOLVER_MAX_ITERATIONS) {
+    iteration++;
+    computeResiduals(q.data(), wheels, fixed, residuals.data(), jacobian.data());
+
+    // Normal equations J^T J and gradient J^T r
+    double largestDiagonal = 0;
+    for (size_t a = 0; a < n; a++) {
+      for (size_t b = 0; b <= a; b++) {
+        double sum = 0;
+        for (size_t i = 0; i < m; i++) sum += jacobian[i * n + a] * jacobian[i * n + b];
+        normal[a * n + b] = normal[b * n + a] = sum;
+      }
+      largestDiagonal = std::max(largestDiagonal, normal[a * n + a]);
+      double sum = 0;
+      for (size_t i = 0; i < m; i++) sum += jacobian[i * n + a] * residuals[i];
+      gradient[a] = sum;
+    }
+
+    // (J^T J + mu I) step = -J^T r, raising mu until the step lowers the residual
+    double previousCost = cost;
+    bool improved = false;
+    double largestStep = 0;
+    while (!improved && damping <= SOLVER_DAMPING_MAX) {
+      factor = normal;
+      for (size_t a = 0; a < n; a++) {
+        factor[a * n + a] += damping * (1.0 + largestDiagonal);
+        step[a] = -gradient[a];
+      }
+      if (choleskySolve(factor.data(), step.data(), n)) {
+        largestStep = 0;
+        for (size_t a = 0; a < n; a++) {
+          qTrial[a] = q[a] + step[a];
+          largestStep = std::max(largestStep, std::fabs(step[a]));
+        }
+        computeResiduals(qTrial.data(), wheels, fixed, trial.data(), nullptr);
+        double trialCost = sumSquares(trial.data());
+        improved = trialCost <= cost;
+        if (improved) {
+          q.swap(qTrial);
+          residuals.swap(trial);
+          cost = trialCost;
+        }
+      }
+      damping = improved ? std::max(damping / 3, SOLVER_DAMPING) : damping * 4;
+    }
+    if (!improved) break;
+    error = maxAbsResidual(residuals.data());
+    // Stalled on an infeasible configuration: best fit is as good as it gets
+    if (error >= tolerance && previousCost - cost <= SOLVER_STALL * previousCost) break;
+    if (largestStep < 1e-12 * tolerance / SOLVER_TOLERANCE) break;
+  }
+
+  for (size_t i = 0; i < blockRods.size(); i++) {
+    const double* rod = &q[3 * i];
+    fixed[blockRods[i]] = { rod[0], rod[1], std::cos(rod[2]), std::sin(rod[2]) };
+  }
+
+  iterationsUsed = iteration;
+  residualLeft = error;
+  converged = error < SOLVER_FAILURE_BOUND / SOLVER_TOLERANCE * tolerance;
+  return converged;
+}
+
+void LinkageSolver::penPosition(double& x, double& y) const {
+  rodPointPosition(poses[machine.penRod], machine.rods[machine.penRod].penDistance, x, y);
+}
+
+void SolverStats::record(unsigned int sampleIterations, bool substeps, bool ok, double residual) {
+  samples++;
+  iterations += sampleIterations;
+  maxIterations = std::max(maxIterations, sampleIterations);
+  if (substeps) substepped++;
+  if (!ok) failures++;
+  maxResidual = std::max(maxResidual, residual);
+}
+
+// --- Internal Helpers ---
+
+void LinkageSolver::computeResiduals(const double* pose, const WheelPose* wheels, const RodPose* fixed, double* out,
+                                     double* jacobianOut) {
+  const size_t n = unknownCount;
+  for (size_t i = 0; i < blockRods.size(); i++) {
+    const double* rod = &pose[3 * i];
+    blockPoses[i] = { rod[0], rod[1], std::cos(rod[2]), std::sin(rod[2]) };
+  }
+  // Block rods come from the unknowns, everything else is already placed
+  auto rodAt = [&](int rodIndex) -> const RodPose& {
+    int local = localIndex[rodIndex];
+    return (local < 0) ? fixed[rodIndex] : blockPoses[local];
+  };
+  if (jacobianOut) std::fill(jacobianOut, jacobianOut + equationCount * n, 0.0);
+
+  double* row = jacobianOut;
+  for (const Pin& pin : pins) {
+    const RodPose& rod = rodAt(pin.rod);
+    int rodColumn = 3 * localIndex[pin.rod];
+    int targetColumn = (pin.kind == JointTarget::ROD_POINT) ? 3 * localIndex[pin.target] : -3;
+
+    double targetX, targetY;
+    const RodPose* target = nullptr;
+    if (pin.kind == JointTarget::WHEEL_POINT) {
+      wheelPointPosition(wheels[pin.target], pin.targetValue, targetX, targetY);
+    } else {
+      target = &rodAt(pin.target);
+      rodPointPosition(*target, pin.targetValue, targetX, targetY);
+    }
+
+    if (pin.slider) {
+      // Perpendicular offset of the target from the rod line
+      double dx = targetX - rod.x, dy = targetY - rod.y;
+      *out++ = rod.c * dy - rod.s * dx;
+      if (!row) continue;
+      if (rodColumn >= 0) {
+        row[rodColumn] = rod.s;
+        row[rodColumn + 1] = -rod.c;
+        row[rodColumn + 2] = -rod.s * dy - rod.c * dx;
+      }
+      if (targetColumn >= 0) {
+        row[targetColumn] -= rod.s;
+        row[targetColumn + 1] += rod.c;
+        row[targetColumn + 2] += pin.targetValue * (rod.s * target->s + rod.c * target->c);
+      }
+      row += n;
+    } else {
+      *out++ = rod.x + pin.distance * rod.c - targetX;
+      *out++ = rod.y + pin.distance * rod.s - targetY;
+      if (!row) continue;
+      // d(point)/d(x, y, angle) = (1, 0, -d sin), (0, 1, d cos) for the rod, negated for the target
+      if (rodColumn >= 0) {
+        row[rodColumn] = 1;
+        row[rodColumn + 2] = -pin.distance * rod.s;
+        row[n + rodColumn + 1] = 1;
+        row[n + rodColumn + 2] = pin.distance * rod.c;
+      }
+      if (targetColumn >= 0) {
+        row[targetColumn] -= 1;
+        row[targetColumn + 2] += pin.targetValue * target->s;
+        row[n + targetColumn + 1] -= 1;
+        row[n + targetColumn + 2] -= pin.targetValue * target->c;
+      }
+      row += 2 * n;
+    }
+  }
+}
+
+double LinkageSolver::maxAbsResidual(const double* values) const {
+  double largest = 0;
+  for (size_t i = 0; i < equationCount; i++) largest = std::max(largest, std::fabs(values[i]));
+  return largest;
+}
+
+double LinkageSolver::sumSquares(const double* values) const {
+  double sum = 0;
+  for (size_t i = 0; i < equationCount; i++) sum += values[i] * values[i];
+  return sum;
+}
+
+// Solve a * x = b for symmetric positive definite a (row-major n x n);
+// a is overwritten with its Cholesky factor, b with x
+static bool choleskySolve(double* a, double* b, size_t n) {
+  for (size_t j = 0; j < n; j++) {
+    double diagonal = a[j * n + j];
+    for (size_t k = 0; k < j; k++) diagonal -= a[j * n + k] * a[j * n + k];
+    if (diagonal <= 0) return false;
+    diagonal = std::sqrt(diagonal);
+    a[j * n + j] = diagonal;
+    for (size_t i = j + 1; i < n; i++) {
+      double value = a[i * n + j];
+      for (size_t k = 0; k < j; k++) value -= a[i * n + k] * a[j * n + k];
+      a[i * n + j] = value / diagonal;
+    }
+  }
+  for (size_t i = 0; i < n; i++) {
+    double value = b[i];
+    for (size_t k = 0; k < i; k++) value -= a[i * n + k] * b[k];
+    b[i] = value / a[i * n + i];
+  }
+  for (size_t i = n; i-- > 0;) {
+    double value = b[i];
+    for (size_t k = i + 1; k < n; k++) value -= a[k * n + i] * b[k];
+    b[i] = value / a[i * n + i];
+  }
+  return true;
+}
+
+} // namespace cycloid
@@ -0,0 +1,130 @@
+/**
+ * LinkageSolver.h
+ *
+ * Iterative solver for rod poses. Each rod has three unknowns (start x,
+ * start y, angle); every connection adds a pin constraint (two equations)
+ * or, for a mid point on a rod that is not fixed length, a slider
+ * constraint (the rod passes through the target). This is the same
+ * system sympy_solver.py hands to scipy's root finder.
+ *
+ * A solver can own every rod of the machine, or just a block of rods
+ * whose neighbours are already placed (the compiled linkage uses blocks
+ * for closed loops and free degrees of freedom it cannot solve in closed
+ * form).
+ *
+ * Each sample starts from the previous solution, which keeps the linkage
+ * on the branch it was assembled in. A sample that takes too many
+ * iterations (or fails) is re-solved in substeps from the last good one.
+ */
+
+#ifndef LINKAGE_SOLVER_H
+#define LINKAGE_SOLVER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Kinematics.h"
+#include "MachineModel.h"
+
+namespace cycloid {
+
+#define SOLVER_SUBSTEP_ITERATIONS 8  // More iterations than this and a sample is re-solved in substeps
+#define SOLVER_MAX_SUBSTEPS 8        // Finest subdivision of one sample interval
+
+// Placed rod: start point and unit direction towards the end
+struct RodPose {
+  double x, y;
+  double c, s;
+};
+
+inline void rodPointPosition(const RodPose& pose, double distance, double& x, double& y) {
+  x = pose.x + distance * pose.c;
+  y = pose.y + distance * pose.s;
+}
+
+struct SolverStats {
+  uint64_t samples = 0;
+  uint64_t iterations = 0;     // Including substeps
+  unsigned int maxIterations = 0; // Most spent on one sample
+  uint64_t substepped = 0;     // Samples re-solved in substeps
+  uint64_t failures = 0;       // Samples left with a residual above the failure bound
+  double maxResidual = 0;      // Largest final residual seen (machine units)
+
+  // Account for one sample
+  void record(unsigned int sampleIterations, bool substeps, bool ok, double residual);
+};
+
+class LinkageSolver {
+ public:
+  // Solve every rod of the machine
+  explicit LinkageSolver(const Machine& machine);
+  // Solve only blockRods (machine rod indices); the rest are read from the poses passed to solveBlock()
+  LinkageSolver(const Machine& machine, const std::vector<int>& blockRods);
+
+  // Whole-machine solve at time t (seconds), warm-started from the previous solution;
+  // false if the constraints could not be met
+  bool solve(double t);
+
+  // Solve the block given wheel poses and every rod outside the block;
+  // writes the block rods into poses (one entry per machine rod). Only
+  // lastIterations()/lastResidual() are updated; the caller keeps the stats.
+  bool solveBlock(const WheelPose* wheels, RodPose* poses);
+  unsigned int lastIterations() const { return iterationsUsed; }
+  double lastResidual() const { return residualLeft; }
+  // True when the last solve failed or was slow enough to deserve substeps
+  bool degraded() const { return !converged || iterationsUsed > SOLVER_SUBSTEP_ITERATIONS; }
+
+  // Keep the current solution as the warm start to return to, or go back to it
+  void accept() { accepted = q; }
+  void rewind() { q = accepted; }
+
+  // Back to the assembly pose from the XML start/end positions
+  void reset();
+
+  void penPosition(double& x, double& y) const;
+  const RodPose& rodPose(size_t rodIndex) const { return poses[rodIndex]; }
+  const SolverStats& stats() const { return solverStats; }
+
+ private:
+  struct Pin {
+    int rod;                   // Pinned rod point, or the slider rod
+    double distance;
+    JointTarget::Kind kind;
+    int target;                // Wheel or rod index
+    double targetValue;        // Wheel point radius or rod point distance
+    bool slider;               // One equation: rod line passes through the target
+  };
+
+  void buildPins();
+  bool solveAt(double t);
+  // Residuals at q, plus the analytic Jacobian (row-major, equations x unknowns) when jacobian is non-null
+  void computeResiduals(const double* q, const WheelPose* wheels, const RodPose* fixed, double* residuals, double* jacobian);
+  double maxAbsResidual(const double* residuals) const;
+  double sumSquares(const double* residuals) const;
+
+  const Machine& machine;
+  std::vector<int> blockRods;
+  std::vector<int> localIndex;   // Per machine rod: slot in q, or -1 if outside the block
+  std::vector<Pin> pins;
+  size_t unknownCount = 0;
+  size_t equationCount = 0;
+  double tolerance = 0;          // Converged when every residual is below this
+  std::vector<double> q;         // Block unknowns: startX, startY, angle per rod
+  std::vector<double> accepted;  // Warm start that rewind() returns to
+  std::vector<double> residuals, trial, jacobian, normal, factor, gradient, step, qTrial;
+  std::vector<RodPose> blockPoses;    // Block rods at the q being evaluated
+  unsigned int iterationsUsed = 0;
+  double residualLeft = 0;
+  bool converged = true;
+
+  // Whole-machine mode only
+  std::vector<WheelPose> wheelPoses;
+  std::vector<RodPose> poses;         // Latest solution, one entry per machine rod
+  double acceptedTime = 0;
+  bool hasAccepted = false;
+  SolverStats solverStats;
+};
+
+} // namespace cycloid
+
+#endif // LINKAGE_SOLVER_H
@@ -0,0 +1,382 @@
+/**
+ * MachineImage.cpp
+ *
+ * Implements machine image encoding, mapping and validation
+ */
+
+#include "MachineImage.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cycloid {
+
+// --- Forward Declarations for Static Functions ---
+static uint64_t fnv1a(const uint8_t* data, size_t size);
+static void encodeJoint(const JointTarget& target, JointRecord& record);
+static JointTarget decodeJoint(const JointRecord& record);
+static bool validJoint(const JointRecord& record, const ImageHeader& header);
+
+void encodeMachineImage(const Machine& machine, std::vector<uint8_t>& bytes) {
+  std::vector<WheelRecord> wheels;
+  std::vector<PointRecord> points;
+  std::vector<RodRecord> rods;
+  std::string strings;
+
+  for (const Wheel& wheel : machine.wheels) {
+    WheelRecord record = WheelRecord();
+    record.centerX = wheel.centerX;
+    record.centerY = wheel.centerY;
+    record.diameter = wheel.diameter;
+    record.baseRatio = wheel.baseRatio;
+    record.rotationRate = wheel.rotationRate;
+    record.lfoDepth = wheel.lfoDepth;
+    record.lfoRate = wheel.lfoRate;
+    record.id = wheel.id;
+    record.firstPoint = (uint32_t)points.size();
+    record.pointCount = (uint32_t)wheel.points.size();
+    record.isCanvas = wheel.isCanvas;
+    record.lfoBipolar = wheel.lfoBipolar;
+    wheels.push_back(record);
+    for (const ConnectionPoint& point : wheel.points) {
+      PointRecord pointRecord = PointRecord();
+      pointRecord.radius = point.radius;
+      pointRecord.nameOffset = (uint32_t)strings.size();
+      pointRecord.nameLength = (uint32_t)point.id.size();
+      strings += point.id;
+      points.push_back(pointRecord);
+    }
+  }
+  for (const Rod& rod : machine.rods) {
+    RodRecord record = RodRecord();
+    record.length = rod.length;
+    record.startX = rod.startX;
+    record.startY = rod.startY;
+    record.endX = rod.endX;
+    record.endY = rod.endY;
+    record.midDistance = rod.midDistance;
+    record.penDistance = rod.penDistance;
+    encodeJoint(rod.start, record.start);
+    encodeJoint(rod.mid, record.mid);
+    encodeJoint(rod.end, record.end);
+    record.id = rod.id;
+    record.fixedLength = rod.fixedLength;
+    record.hasMid = rod.hasMid;
+    record.hasPen = rod.hasPen;
+    rods.push_back(record);
+  }
+  // Pad the string table so the next image in a buffer stays aligned
+  while (strings.size() % 8) strings += '\0';
+
+  ImageHeader header = ImageHeader();
+  memcpy(header.magic, MACHINE_IMAGE_MAGIC, sizeof(header.magic));
+  header.version = MACHINE_IMAGE_VERSION;
+  header.byteOrder = MACHINE_IMAGE_BYTE_ORDER;
+  header.wheelCount = (uint32_t)wheels.size();
+  header.pointCount = (uint32_t)points.size();
+  header.rodCount = (uint32_t)rods.size();
+  header.canvasWheel = machine.canvasWheel;
+  header.penRod = machine.penRod;
+  header.stringBytes = (uint32_t)strings.size();
+  header.masterSpeed = machine.masterSpeed;
+
+  bytes.clear();
+  bytes.resize(sizeof(ImageHeader));
+  auto append = [&](const void* data, size_t size) {
+    const uint8_t* begin = static_cast<const uint8_t*>(data);
+    bytes.insert(bytes.end(), begin, begin + size);
+  };
+  append(wheels.data(), wheels.size() * sizeof(WheelRecord));
+  append(points.data(), points.size() * sizeof(PointRecord));
+  append(rods.data(), rods.size() * sizeof(RodRecord));
+  append(strings.data(), strings.size());
+  header.fileBytes = bytes.size();
+  header.checksum = fnv1a(bytes.data() + sizeof(ImageHeader), bytes.size() - sizeof(ImageHeader));
+  memcpy(bytes.data(), &header, sizeof(ImageHeader));
+}
+
+bool saveMachineImage(const Machine& machine, const std::string& path, std::string& error) {
+  std::vector<uint8_t> bytes;
+  encodeMachineImage(machine, bytes);
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file) {
+    error = "cannot write " + path + ": " + strerror(errno);
+    return false;
+  }
+  bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  ok = (fclose(file) == 0) && ok;
+  if (!ok) error = "error writing " + path;
+  return ok;
+}
+
+bool isMachineImage(const std::string& path) {
+  char magic[sizeof(ImageHeader::magic)];
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) return false;
+  bool match = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, MACHINE_IMAGE_MAGIC, sizeof(magic)) == 0;
+  fclose(file);
+  return match;
+}
+
+MachineImage::~MachineImage() {
+  close();
+}
+
+bool MachineImage::openFile(const std::string& path, std::string& error) {
+  close();
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error = "cannot open " + path + ": " + strerror(errno);
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(ImageHeader)) {
+    ::close(fd);
+    error = path + ": too short for a machine image";
+    return false;
+  }
+  void* mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    error = "cannot map " + path + ": " + strerror(errno);
+    return false;
+  }
+  mapping = mapped;
+  data = static_cast<const uint8_t*>(mapped);
+  size = (size_t)info.st_size;
+  if (!validate(path, error)) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool MachineImage::openBuffer(const uint8_t* buffer, size_t length, std::string& error) {
+  close();
+  data = buffer;
+  size = length;
+  if (!validate("buffer", error)) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void MachineImage::toMachine(Machine& machine) const {
+  const ImageHeader& head = header();
+  machine = Machine();
+  machine.masterSpeed = head.masterSpeed;
+  machine.canvasWheel = head.canvasWheel;
+  machine.penRod = head.penRod;
+
+  machine.wheels.resize(head.wheelCount);
+  for (uint32_t i = 0; i < head.wheelCount; i++) {
+    const WheelRecord& record = wheels()[i];
+    Wheel& wheel = machine.wheels[i];
+    wheel.id = record.id;
+    wheel.isCanvas = record.isCanvas != 0;
+    wheel.centerX = record.centerX;
+    wheel.centerY = record.centerY;
+    wheel.diameter = record.diameter;
+    wheel.baseRatio = record.baseRatio;
+    wheel.rotationRate = record.rotationRate;
+    wheel.lfoDepth = record.lfoDepth;
+    wheel.lfoRate = record.lfoRate;
+    wheel.lfoBipolar = record.lfoBipolar != 0;
+    wheel.points.resize(record.pointCount);
+    for (uint32_t p = 0; p < record.pointCount; p++) {
+      const PointRecord& point = points()[record.firstPoint + p];
+      wheel.points[p].id.assign(strings() + point.nameOffset, point.nameLength);
+      wheel.points[p].radius = point.radius;
+    }
+  }
+
+  machine.rods.resize(head.rodCount);
+  for (uint32_t i = 0; i < head.rodCount; i++) {
+    const RodRecord& record = rods()[i];
+    Rod& rod = machine.rods[i];
+    rod.id = record.id;
+    rod.length = record.length;
+    rod.fixedLength = record.fixedLength != 0;
+    rod.startX = record.startX;
+    rod.startY = record.startY;
+    rod.endX = record.endX;
+    rod.endY = record.endY;
+    rod.hasMid = record.hasMid != 0;
+    rod.midDistance = record.midDistance;
+    rod.start = decodeJoint(record.start);
+    rod.mid = decodeJoint(record.mid);
+    rod.end = decodeJoint(record.end);
+    rod.hasPen = record.hasPen != 0;
+    rod.penDistance = record.penDistance;
+  }
+}
+
+bool loadMachineImage(const std::string& path, Machine& machine, std::string& error) {
+  MachineImage image;
+  if (!image.openFile(path, error)) return false;
+  image.toMachine(machine);
+  return true;
+}
+
+bool compareMachines(const Machine& expected, const Machine& actual, std::string& error) {
+  auto differs = [&](const std::string& what) {
+    error = what + " differs";
+    return false;
+  };
+  auto sameJoint = [](const JointTarget& a, const JointTarget& b) {
+    return a.kind == b.kind && a.index == b.index && a.radius == b.radius && a.rodPoint == b.rodPoint;
+  };
+  if (expected.masterSpeed != actual.masterSpeed) return differs("master speed");
+  if (expected.canvasWheel != actual.canvasWheel) return differs("canvas wheel");
+  if (expected.penRod != actual.penRod) return differs("pen rod");
+  if (expected.wheels.size() != actual.wheels.size()) return differs("wheel count");
+  if (expected.rods.size() != actual.rods.size()) return differs("rod count");
+
+  for (size_t i = 0; i < expected.wheels.size(); i++) {
+    const Wheel& a = expected.wheels[i];
+    const Wheel& b = actual.wheels[i];
+    std::string where = "wheel " + std::to_string(a.id) + " ";
+    if (a.id != b.id || a.isCanvas != b.isCanvas) return differs(where + "id or canvas flag");
+    if (a.centerX != b.centerX || a.centerY != b.centerY || a.diameter != b.diameter) return differs(where + "geometry");
+    if (a.baseRatio != b.baseRatio || a.rotationRate != b.rotationRate) return differs(where + "speed");
+    if (a.lfoDepth != b.lfoDepth || a.lfoRate != b.lfoRate || a.lfoBipolar != b.lfoBipolar) return differs(where + "LFO");
+    if (a.points.size() != b.points.size()) return differs(where + "point count");
+    for (size_t p = 0; p < a.points.size(); p++) {
+      if (a.points[p].id != b.points[p].id || a.points[p].radius != b.points[p].radius) {
+        return differs(where + "point " + a.points[p].id);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < expected.rods.size(); i++) {
+    const Rod& a = expected.rods[i];
+    const Rod& b = actual.rods[i];
+    std::string where = "rod " + std::to_string(a.id) + " ";
+    if (a.id != b.id || a.length != b.length || a.fixedLength != b.fixedLength) return differs(where + "length");
+    if (a.startX != b.startX || a.startY != b.startY || a.endX != b.endX || a.endY != b.endY) {
+      return differs(where + "assembly pose");
+    }
+    if (a.hasMid != b.hasMid || a.midDistance != b.midDistance) return differs(where + "mid point");
+    if (a.hasPen != b.hasPen || a.penDistance != b.penDistance) return differs(where + "pen");
+    if (!sameJoint(a.start, b.start) || !sameJoint(a.mid, b.mid) || !sameJoint(a.end, b.end)) {
+      return differs(where + "connections");
+    }
+  }
+  return true;
+}
+
+// --- Internal Helpers ---
+
+// Everything the solver indexes is checked, so a damaged or hostile image
+// is refused here rather than read out of bounds later
+bool MachineImage::validate(const std::string& where, std::string& error) const {
+  if (size < sizeof(ImageHeader) || memcmp(data, MACHINE_IMAGE_MAGIC, sizeof(ImageHeader::magic)) != 0) {
+    error = where + ": not a machine image";
+    return false;
+  }
+  if (reinterpret_cast<uintptr_t>(data) % alignof(double) != 0) {
+    error = where + ": image is not 8-byte aligned";
+    return false;
+  }
+  const ImageHeader& head = header();
+  if (head.byteOrder != MACHINE_IMAGE_BYTE_ORDER) {
+    error = where + ": machine image has the other byte order";
+    return false;
+  }
+  if (head.version != MACHINE_IMAGE_VERSION) {
+    error = where + ": machine image version " + std::to_string(head.version) + ", this build reads version " +
+            std::to_string(MACHINE_IMAGE_VERSION) + "; convert the XML again";
+    return false;
+  }
+  uint64_t expected = sizeof(ImageHeader) + (uint64_t)head.wheelCount * sizeof(WheelRecord) +
+                      (uint64_t)head.pointCount * sizeof(PointRecord) + (uint64_t)head.rodCount * sizeof(RodRecord) +
+                      head.stringBytes;
+  if (head.fileBytes != size || expected != size) {
+    error = where + ": machine image is truncated or has trailing data";
+    return false;
+  }
+  if (fnv1a(data + sizeof(ImageHeader), size - sizeof(ImageHeader)) != head.checksum) {
+    error = where + ": machine image checksum mismatch";
+    return false;
+  }
+
+  if (head.canvasWheel < -1 || head.canvasWheel >= (int64_t)head.wheelCount || head.penRod < 0 ||
+      head.penRod >= (int64_t)head.rodCount) {
+    error = where + ": canvas wheel or pen rod out of range";
+    return false;
+  }
+  for (uint32_t i = 0; i < head.wheelCount; i++) {
+    const WheelRecord& wheel = wheels()[i];
+    if ((uint64_t)wheel.firstPoint + wheel.pointCount > head.pointCount) {
+      error = where + ": wheel " + std::to_string(wheel.id) + " points out of range";
+      return false;
+    }
+  }
+  for (uint32_t i = 0; i < head.pointCount; i++) {
+    const PointRecord& point = points()[i];
+    if ((uint64_t)point.nameOffset + point.nameLength > head.stringBytes) {
+      error = where + ": connection point name out of range";
+      return false;
+    }
+  }
+  for (uint32_t i = 0; i < head.rodCount; i++) {
+    const RodRecord& rod = rods()[i];
+    if (!validJoint(rod.start, head) || !validJoint(rod.mid, head) || !validJoint(rod.end, head)) {
+      error = where + ": rod " + std::to_string(rod.id) + " connection out of range";
+      return false;
+    }
+  }
+  return true;
+}
+
+void MachineImage::close() {
+  if (mapping) munmap(mapping, size);
+  mapping = nullptr;
+  data = nullptr;
+  size = 0;
+}
+
+static uint64_t fnv1a(const uint8_t* data, size_t size) {
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+static void encodeJoint(const JointTarget& target, JointRecord& record) {
+  record = JointRecord();
+  record.radius = target.radius;
+  record.index = target.index;
+  record.kind = (uint8_t)target.kind;
+  record.rodPoint = (uint8_t)target.rodPoint;
+}
+
+static JointTarget decodeJoint(const JointRecord& record) {
+  JointTarget target;
+  target.kind = (JointTarget::Kind)record.kind;
+  target.index = record.index;
+  target.radius = record.radius;
+  target.rodPoint = (RodPointKind)record.rodPoint;
+  return target;
+}
+
+static bool validJoint(const JointRecord& record, const ImageHeader& header) {
+  if (record.rodPoint > ROD_END) return false;
+  switch (record.kind) {
+    case JointTarget::NONE: return true;
+    case JointTarget::WHEEL_POINT: return record.index >= 0 && (uint32_t)record.index < header.wheelCount;
+    case JointTarget::ROD_POINT: return record.index >= 0 && (uint32_t)record.index < header.rodCount;
+    default: return false;
+  }
+}
+
+} // namespace cycloid
@@ -0,0 +1,139 @@
+/**
+ * MachineImage.h
+ *
+ * Compiled binary form of a Machine, for tools that load the same machine
+ * over and over (sweep jobs, batch renders). The converter writes the
+ * resolved model from loadMachineXml(): fixed-size wheel, connection point
+ * and rod records with every connection already an index, and the pen rod.
+ * Loading maps the file and reads the records in place; nothing is parsed
+ * or resolved.
+ *
+ * Layout, native byte order, every record 8-byte aligned:
+ *
+ *   ImageHeader
+ *   WheelRecord[wheelCount]
+ *   PointRecord[pointCount]      Connection points of all wheels, in wheel order
+ *   RodRecord[rodCount]
+ *   char[stringBytes]            Connection point ids, not terminated
+ *
+ * The header carries MACHINE_IMAGE_VERSION, a byte order mark and a
+ * checksum of everything after it. Any change to a record bumps the
+ * version; older or newer images are refused, not guessed at.
+ */
+
+#ifndef MACHINE_IMAGE_H
+#define MACHINE_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MachineModel.h"
+
+namespace cycloid {
+
+#define MACHINE_IMAGE_MAGIC "CYCMACH"          // 7 characters and a NUL fill the magic field
+#define MACHINE_IMAGE_VERSION 1
+#define MACHINE_IMAGE_BYTE_ORDER 0x01020304u   // Reads back swapped on a foreign-endian host
+
+struct ImageHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t wheelCount, pointCount, rodCount;
+  int32_t canvasWheel, penRod;
+  uint32_t stringBytes;
+  double masterSpeed;
+  uint64_t fileBytes;
+  uint64_t checksum;        // FNV-1a of everything after the header
+};
+
+struct WheelRecord {
+  double centerX, centerY;
+  double diameter;
+  double baseRatio;
+  double rotationRate;
+  double lfoDepth, lfoRate;
+  int32_t id;
+  uint32_t firstPoint, pointCount;
+  uint8_t isCanvas, lfoBipolar;
+  uint8_t reserved[2];
+};
+
+struct PointRecord {
+  double radius;
+  uint32_t nameOffset, nameLength;   // Into the string table
+};
+
+struct JointRecord {
+  double radius;
+  int32_t index;
+  uint8_t kind;             // JointTarget::Kind
+  uint8_t rodPoint;         // RodPointKind
+  uint8_t reserved[2];
+};
+
+struct RodRecord {
+  double length;
+  double startX, startY, endX, endY;
+  double midDistance;
+  double penDistance;
+  JointRecord start, mid, end;
+  int32_t id;
+  uint8_t fixedLength, hasMid, hasPen;
+  uint8_t reserved;
+};
+
+static_assert(sizeof(ImageHeader) == 64 && sizeof(WheelRecord) == 72 && sizeof(PointRecord) == 16 &&
+                  sizeof(JointRecord) == 16 && sizeof(RodRecord) == 112,
+              "machine image records must keep their on-disk size");
+
+// Serialize machine into bytes
+void encodeMachineImage(const Machine& machine, std::vector<uint8_t>& bytes);
+
+// Write the image of machine to path; false with a message on failure
+bool saveMachineImage(const Machine& machine, const std::string& path, std::string& error);
+
+// True if the file at path starts with the image magic (any version)
+bool isMachineImage(const std::string& path);
+
+// A validated image, either memory-mapped from a file or viewing a buffer
+// the caller keeps alive. Records are read in place.
+class MachineImage {
+ public:
+  MachineImage() {}
+  ~MachineImage();
+  MachineImage(const MachineImage&) = delete;
+  MachineImage& operator=(const MachineImage&) = delete;
+
+  bool openFile(const std::string& path, std::string& error);
+  bool openBuffer(const uint8_t* data, size_t size, std::string& error);
+
+  const ImageHeader& header() const { return *reinterpret_cast<const ImageHeader*>(data); }
+  const WheelRecord* wheels() const { return reinterpret_cast<const WheelRecord*>(data + sizeof(ImageHeader)); }
+  const PointRecord* points() const { return reinterpret_cast<const PointRecord*>(wheels() + header().wheelCount); }
+  const RodRecord* rods() const { return reinterpret_cast<const RodRecord*>(points() + header().pointCount); }
+  const char* strings() const { return reinterpret_cast<const char*>(rods() + header().rodCount); }
+
+  // Build the Machine the records describe
+  void toMachine(Machine& machine) const;
+
+ private:
+  bool validate(const std::string& where, std::string& error) const;
+  void close();
+
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+  void* mapping = nullptr;  // Set when data is an mmap of a file
+};
+
+// Open an image file and build its Machine
+bool loadMachineImage(const std::string& path, Machine& machine, std::string& error);
+
+// Field-by-field comparison; false with the first difference in error
+bool compareMachines(const Machine& expected, const Machine& actual, std::string& error);
+
+} // namespace cycloid
+
+#endif // MACHINE_IMAGE_H
@@ -0,0 +1,310 @@
+/**
+ * MachineModel.cpp
+ *
+ * Loads <machine_configuration> XML into a Machine. Defaults and target
+ * string formats follow config_loader.py; unlike the Python loader, a
+ * connection that names a missing wheel, point or rod is an error rather
+ * than a warning, since the solver would otherwise drop the constraint.
+ */
+
+#include "MachineModel.h"
+#include "StepTrace.h"
+#include "XmlDocument.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace cycloid {
+
+namespace {
+
+// A rod connection as written in the XML, resolved once every rod is known
+struct PendingTarget {
+  size_t rod;
+  RodPointKind point;
+  std::string text;
+};
+
+bool parseNumber(const std::string& text, double& value) {
+  if (text.empty()) return false;
+  char* end;
+  value = strtod(text.c_str(), &end);
+  while (*end && isspace((unsigned char)*end)) end++;
+  return *end == '\0' && std::isfinite(value);
+}
+
+// Numeric child text or attribute with a default, as config_loader.py does
+bool readNumber(const std::string& text, double fallback, double& value, const std::string& what, std::string& error) {
+  if (text.empty()) {
+    value = fallback;
+    return true;
+  }
+  if (parseNumber(text, value)) return true;
+  error = "invalid number '" + text + "' for " + what;
+  return false;
+}
+
+bool readPosition(const XmlNode* node, double& x, double& y, const std::string& what, std::string& error) {
+  if (!node) return true;
+  return readNumber(node->attribute("x"), 0, x, what + " x", error) &&
+         readNumber(node->attribute("y"), 0, y, what + " y", error);
+}
+
+bool isDigits(const std::string& text) {
+  if (text.empty()) return false;
+  for (char c : text) {
+    if (!isdigit((unsigned char)c)) return false;
+  }
+  return true;
+}
+
+bool resolveTarget(Machine& machine, const PendingTarget& pending, std::string& error) {
+  Rod& rod = machine.rods[pending.rod];
+  JointTarget target;
+  // A mid connection without distance_from_start has no point to pin
+  if (pending.point == ROD_MID && !rod.hasMid) return true;
+  const std::string& text = pending.text;
+  const std::string where = "rod " + std::to_string(rod.id) + ": ";
+
+  // wheel_<id>_point_<pointId>
+  size_t pointTag = text.find("_point_");
+  if (text.compare(0, 6, "wheel_") == 0 && pointTag != std::string::npos && isDigits(text.substr(6, pointTag - 6))) {
+    int wheelId = atoi(text.c_str() + 6);
+    std::string pointId = text.substr(pointTag + 7);
+    int wheelIndex = findWheel(machine, wheelId);
+    if (wheelIndex < 0) {
+      error = where + "connection to missing wheel " + std::to_string(wheelId);
+      return false;
+    }
+    const Wheel& wheel = machine.wheels[wheelIndex];
+    bool found = false;
+    for (const ConnectionPoint& point : wheel.points) {
+      if (point.id == pointId) {
+        target.radius = point.radius;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      error = where + "wheel " + std::to_string(wheelId) + " has no connection point '" + pointId + "'";
+      return false;
+    }
+    target.kind = JointTarget::WHEEL_POINT;
+    target.index = wheelIndex;
+  } else {
+    // rod_<id>_start|mid|end
+    size_t lastUnderscore = text.rfind('_');
+    if (text.compare(0, 4, "rod_") != 0 || lastUnderscore == std::string::npos || lastUnderscore <= 4 ||
+        !isDigits(text.substr(4, lastUnderscore - 4))) {
+      error = where + "cannot parse connection target '" + text + "'";
+      return false;
+    }
+    std::string which = text.substr(lastUnderscore + 1);
+    if (which == "start") target.rodPoint = ROD_START;
+    else if (which == "mid") target.rodPoint = ROD_MID;
+    else if (which == "end") target.rodPoint = ROD_END;
+    else {
+      error = where + "cannot parse connection target '" + text + "'";
+      return false;
+    }
+    int otherId = atoi(text.c_str() + 4);
+    int otherIndex = findRod(machine, otherId);
+    if (otherIndex < 0) {
+      error = where + "connection to missing rod " + std::to_string(otherId);
+      return false;
+    }
+    if (target.rodPoint == ROD_MID && !machine.rods[otherIndex].hasMid) {
+      error = where + "rod " + std::to_string(otherId) + " has no mid point";
+      return false;
+    }
+    // A point pinned to itself (written by the editor for free ends) is no constraint
+    if ((size_t)otherIndex == pending.rod && target.rodPoint == pending.point) return true;
+    target.kind = JointTarget::ROD_POINT;
+    target.index = otherIndex;
+  }
+
+  if (pending.point == ROD_START) rod.start = target;
+  else if (pending.point == ROD_MID) rod.mid = target;
+  else rod.end = target;
+  return true;
+}
+
+bool loadWheel(const XmlNode& node, Wheel& wheel, std::string& error) {
+  wheel.isCanvas = node.attribute("is_canvas", "false") == "true" || node.attribute("is_canvas") == "True";
+  const std::string what = "wheel " + std::to_string(wheel.id);
+  if (!readPosition(node.child("center_position"), wheel.centerX, wheel.centerY, what + " center", error)) return false;
+  if (!readNumber(node.childText("diameter"), 50, wheel.diameter, what + " diameter", error)) return false;
+
+  if (const XmlNode* speed = node.child("speed_control")) {
+    if (!readNumber(speed->childText("base_ratio"), 1.0, wheel.baseRatio, what + " base_ratio", error)) return false;
+    if (!readNumber(speed->childText("rotation_rate"), 0.0, wheel.rotationRate, what + " rotation_rate", error)) return false;
+  }
+
+  if (const XmlNode* points = node.child("connection_points")) {
+    for (const XmlNode* pointNode : points->childrenNamed("point")) {
+      ConnectionPoint point;
+      point.id = pointNode->attribute("id");
+      if (point.id.empty()) continue; // config_loader.py skips these too
+      if (!readNumber(pointNode->attribute("radius"), 0, point.radius, what + " point " + point.id, error)) return false;
+      wheel.points.push_back(point);
+    }
+  }
+  return true;
+}
+
+bool loadRod(const XmlNode& node, size_t rodIndex, Rod& rod, std::vector<PendingTarget>& pending, std::string& error) {
+  const std::string what = "rod " + std::to_string(rod.id);
+  if (!readNumber(node.childText("length"), 100, rod.length, what + " length", error)) return false;
+  rod.fixedLength = node.attribute("fixed_length", "true") != "false";
+  rod.endX = rod.length;
+  if (!readPosition(node.child("start_position"), rod.startX, rod.startY, what + " start_position", error)) return false;
+  if (!readPosition(node.child("end_position"), rod.endX, rod.endY, what + " end_position", error)) return false;
+
+  if (const XmlNode* pen = node.child("pen_position")) {
+    if (pen->hasAttribute("distance_from_start")) {
+      if (!readNumber(pen->attribute("distance_from_start"), 0, rod.penDistance, what + " pen_position", error)) return false;
+      rod.hasPen = true;
+    }
+  }
+
+  const XmlNode* connections = node.child("connections");
+  if (!connections) return true;
+
+  static const char* const pointNames[3] = { "start_point", "mid_point", "end_point" };
+  for (int p = ROD_START; p <= ROD_END; p++) {
+    const XmlNode* pointNode = connections->child(pointNames[p]);
+    if (!pointNode) continue;
+    if (p == ROD_MID && pointNode->hasAttribute("distance_from_start")) {
+      if (!readNumber(pointNode->attribute("distance_from_start"), 0, rod.midDistance, what + " mid_point", error)) return false;
+      rod.hasMid = true;
+    }
+    std::string target = pointNode->attribute("connected_to");
+    if (!target.empty()) pending.push_back({ rodIndex, (RodPointKind)p, target });
+  }
+  return true;
+}
+
+} // namespace
+
+bool loadMachineXml(const std::string& path, Machine& machine, std::string& error) {
+  XmlNode root;
+  if (!parseXmlFile(path, root, error)) return false;
+  if (root.name != "machine_configuration") {
+    error = path + ": root element is <" + root.name + ">, expected <machine_configuration>";
+    return false;
+  }
+
+  machine = Machine();
+  if (const XmlNode* global = root.child("global_settings")) {
+    if (!readNumber(global->childText("master_speed"), 1.0, machine.masterSpeed, "master_speed", error)) return false;
+  }
+  if (!root.child("canvas")) {
+    error = path + ": configuration missing <canvas> element";
+    return false;
+  }
+
+  if (const XmlNode* wheels = root.child("drive_wheels")) {
+    for (const XmlNode* node : wheels->childrenNamed("wheel")) {
+      std::string id = node->attribute("id");
+      if (!isDigits(id)) continue; // config_loader.py skips invalid ids
+      Wheel wheel;
+      wheel.id = atoi(id.c_str());
+      if (!loadWheel(*node, wheel, error)) return false;
+      // Only the first canvas wheel counts, the rest are ordinary wheels
+      if (wheel.isCanvas) {
+        if (machine.canvasWheel < 0) machine.canvasWheel = (int)machine.wheels.size();
+        else wheel.isCanvas = false;
+      }
+      machine.wheels.push_back(wheel);
+    }
+  }
+
+  std::vector<PendingTarget> pending;
+  if (const XmlNode* linkages = root.child("linkages")) {
+    for (const XmlNode* node : linkages->childrenNamed("rod")) {
+      std::string id = node->attribute("id");
+      if (!isDigits(id)) continue;
+      Rod rod;
+      rod.id = atoi(id.c_str());
+      if (!loadRod(*node, machine.rods.size(), rod, pending, error)) return false;
+      if (rod.hasPen && machine.penRod < 0) machine.penRod = (int)machine.rods.size();
+      machine.rods.push_back(rod);
+    }
+  }
+
+  for (const PendingTarget& target : pending) {
+    if (!resolveTarget(machine, target, error)) {
+      error = path + ": " + error;
+      return false;
+    }
+  }
+
+  if (machine.penRod < 0) {
+    error = path + ": no rod has a <pen_position>";
+    return false;
+  }
+  return true;
+}
+
+double wheelAngularRate(const Machine& machine, size_t wheelIndex) {
+  const Wheel& wheel = machine.wheels[wheelIndex];
+  if (wheel.rotationRate != 0) return wheel.rotationRate;
+  return 2.0 * M_PI * wheel.baseRatio * machine.masterSpeed;
+}
+
+double wheelRotation(const Machine& machine, size_t wheelIndex, double t) {
+  const Wheel& wheel = machine.wheels[wheelIndex];
+  if (machine.stepTrace) return wheel.traceMotor >= 0 ? machine.stepTrace->angle(wheel.traceMotor, t) : 0;
+  double rate = wheelAngularRate(machine, wheelIndex);
+  if (wheel.lfoDepth <= 0 || wheel.lfoRate <= 0) return rate * t;
+
+  // Speed factor 1 + depth * sin (bipolar) or 1 + depth * (sin + 1) / 2
+  // (unipolar), integrated from 0 to t
+  double depth = wheel.lfoDepth / 100.0;
+  double omega = 2.0 * M_PI * wheel.lfoRate;
+  double swing = (1.0 - std::cos(omega * t)) / omega;
+  if (wheel.lfoBipolar) return rate * (t + depth * swing);
+  return rate * (t * (1.0 + 0.5 * depth) + 0.5 * depth * swing);
+}
+
+bool hasVaryingWheelSpeed(const Machine& machine) {
+  if (machine.stepTrace) return true;
+  for (const Wheel& wheel : machine.wheels) {
+    if (wheel.lfoDepth > 0 && wheel.lfoRate > 0) return true;
+  }
+  return false;
+}
+
+bool setWheelRotationRate(Machine& machine, int wheelId, double radPerSecond) {
+  int index = findWheel(machine, wheelId);
+  if (index < 0) return false;
+  machine.wheels[index].rotationRate = radPerSecond;
+  // Zero means "use the ratio"; keep an explicit stop meaning stop
+  if (radPerSecond == 0) machine.wheels[index].baseRatio = 0;
+  return true;
+}
+
+bool setWheelRatio(Machine& machine, int wheelId, double ratio) {
+  int index = findWheel(machine, wheelId);
+  if (index < 0) return false;
+  machine.wheels[index].baseRatio = ratio;
+  machine.wheels[index].rotationRate = 0;
+  return true;
+}
+
+int findWheel(const Machine& machine, int wheelId) {
+  for (size_t i = 0; i < machine.wheels.size(); i++) {
+    if (machine.wheels[i].id == wheelId) return (int)i;
+  }
+  return -1;
+}
+
+int findRod(const Machine& machine, int rodId) {
+  for (size_t i = 0; i < machine.rods.size(); i++) {
+    if (machine.rods[i].id == rodId) return (int)i;
+  }
+  return -1;
+}
+
+} // namespace cycloid
@@ -0,0 +1,106 @@
+/**
+ * MachineModel.h
+ *
+ * In-memory machine description for the native simulator, loaded from the
+ * same <machine_configuration> XML as config_loader.py: drive wheels with
+ * connection points, the canvas wheel, rods with start/mid/end connections
+ * and the pen position.
+ */
+
+#ifndef MACHINE_MODEL_H
+#define MACHINE_MODEL_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cycloid {
+
+class StepTrace;
+
+struct ConnectionPoint {
+  std::string id;
+  double radius = 0;
+};
+
+struct Wheel {
+  int id = 0;
+  bool isCanvas = false;
+  double centerX = 0, centerY = 0;
+  double diameter = 0;
+  double baseRatio = 1.0;
+  double rotationRate = 0;       // rad/s, relative to the canvas frame
+  double lfoDepth = 0;           // Speed modulation in percent, as the firmware LFO (0 = off)
+  double lfoRate = 0;            // Hz
+  bool lfoBipolar = false;       // false: speed swings 1..1+depth, true: 1-depth..1+depth
+  int traceMotor = -1;           // Column of Machine::stepTrace that turns this wheel, -1 if none
+  std::vector<ConnectionPoint> points;
+};
+
+enum RodPointKind { ROD_START = 0, ROD_MID = 1, ROD_END = 2 };
+
+// What one rod point is pinned to ("wheel_N_point_pX" or "rod_N_start|mid|end")
+struct JointTarget {
+  enum Kind { NONE, WHEEL_POINT, ROD_POINT } kind = NONE;
+  int index = -1;               // Index into Machine::wheels or Machine::rods
+  double radius = 0;            // WHEEL_POINT: connection point radius
+  RodPointKind rodPoint = ROD_START;
+};
+
+struct Rod {
+  int id = 0;
+  double length = 0;
+  bool fixedLength = true;      // false: a mid connection slides along the rod
+  double startX = 0, startY = 0; // Assembly pose from the XML
+  double endX = 0, endY = 0;
+  bool hasMid = false;
+  double midDistance = 0;
+  JointTarget start, mid, end;  // Indexed by RodPointKind via target()
+  bool hasPen = false;
+  double penDistance = 0;
+
+  const JointTarget& target(RodPointKind point) const { return point == ROD_START ? start : point == ROD_MID ? mid : end; }
+  // Distance of a rod point from the rod start
+  double pointDistance(RodPointKind point) const { return point == ROD_START ? 0 : point == ROD_MID ? midDistance : length; }
+};
+
+struct Machine {
+  double masterSpeed = 1.0;
+  std::vector<Wheel> wheels;
+  std::vector<Rod> rods;
+  int canvasWheel = -1;         // Index into wheels, -1 if the canvas is fixed
+  int penRod = -1;              // Index into rods (first rod with a pen)
+  std::shared_ptr<const StepTrace> stepTrace; // When set, wheels turn as recorded instead of at their rates
+};
+
+// Load and resolve every connection; false with a message on any error
+bool loadMachineXml(const std::string& path, Machine& machine, std::string& error);
+
+// Angular rate of a wheel in rad/s relative to the canvas frame.
+// rotation_rate wins when set; a wheel without one turns at
+// base_ratio * master_speed revolutions per second.
+double wheelAngularRate(const Machine& machine, size_t wheelIndex);
+
+// Angle turned relative to the canvas frame after t seconds: the rate
+// above times t, plus the integral of the wheel's LFO when it has one.
+// The LFO starts at phase 0, as on the machine after a reset.
+// With a step trace the angle is the traced motor's instead, and a wheel
+// no motor drives stands still.
+double wheelRotation(const Machine& machine, size_t wheelIndex, double t);
+
+// True if any wheel turns at a varying speed (an active LFO or a step trace)
+bool hasVaryingWheelSpeed(const Machine& machine);
+
+// Command-line style overrides by XML id; false if no wheel has that id
+bool setWheelRotationRate(Machine& machine, int wheelId, double radPerSecond);
+bool setWheelRatio(Machine& machine, int wheelId, double ratio);
+
+// Master time is the firmware's period of one revolution at ratio 1.0
+inline void setMasterTime(Machine& machine, double millis) { machine.masterSpeed = 1000.0 / millis; }
+
+int findWheel(const Machine& machine, int wheelId);
+int findRod(const Machine& machine, int rodId);
+
+} // namespace cycloid
+
+#endif // MACHINE_MODEL_H
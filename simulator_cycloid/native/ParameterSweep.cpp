@@ -0,0 +1,382 @@
+/**
+ * ParameterSweep.cpp
+ *
+ * Implements the multithreaded parameter sweep: axis parsing, closure
+ * periods, and the work-stealing worker pool.
+ */
+
+#include "ParameterSweep.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace cycloid {
+
+namespace {
+
+// Candidate numbers [next, end) still to run by one worker. The owner takes
+// from the front; a thief takes the back half.
+struct WorkRange {
+  std::mutex lock;
+  size_t next = 0, end = 0;
+};
+
+class WorkStealingRanges {
+ public:
+  WorkStealingRanges(size_t count, unsigned int workers) : ranges(workers) {
+    for (unsigned int w = 0; w < workers; w++) {
+      ranges[w].next = count * w / workers;
+      ranges[w].end = count * (w + 1) / workers;
+    }
+  }
+
+  // Next candidate for worker; false once every range is empty
+  bool take(unsigned int worker, size_t& index) {
+    {
+      std::lock_guard<std::mutex> guard(ranges[worker].lock);
+      if (ranges[worker].next < ranges[worker].end) {
+        index = ranges[worker].next++;
+        return true;
+      }
+    }
+    for (size_t k = 1; k < ranges.size(); k++) {
+      WorkRange& victim = ranges[(worker + k) % ranges.size()];
+      size_t first, end;
+      {
+        std::lock_guard<std::mutex> guard(victim.lock);
+        size_t remaining = victim.end - victim.next;
+        if (remaining == 0) continue;
+        first = victim.end - (remaining + 1) / 2;
+        end = victim.end;
+        victim.end = first;
+      }
+      steals++;
+      std::lock_guard<std::mutex> guard(ranges[worker].lock);
+      ranges[worker].next = first + 1;
+      ranges[worker].end = end;
+      index = first;
+      return true;
+    }
+    return false;
+  }
+
+  size_t stealCount() const { return steals; }
+
+ private:
+  std::vector<WorkRange> ranges;
+  std::atomic<size_t> steals{ 0 };
+};
+
+// State shared by the workers of one sweep
+struct SweepRun {
+  const Machine& machine;
+  const SweepOptions& options;
+  SweepSink& sink;
+  WorkStealingRanges work;
+  std::atomic<bool> stop{ false };
+  std::mutex sinkLock;              // Also guards completed and error
+  size_t completed = 0;
+  std::string error;
+
+  SweepRun(const Machine& machine, const SweepOptions& options, SweepSink& sink, size_t count, unsigned int threads)
+      : machine(machine), options(options), sink(sink), work(count, threads) {}
+
+  void fail(const std::string& message) {
+    std::lock_guard<std::mutex> guard(sinkLock);
+    if (error.empty()) error = message;
+    stop = true;
+  }
+};
+
+}  // namespace
+
+// --- Forward Declarations for Static Functions ---
+static void runWorker(SweepRun& run, unsigned int worker, size_t count);
+static void applyCandidate(const SweepOptions& options, size_t index, Machine& machine, std::vector<double>& values);
+static bool approximateRatio(double value, long long& numerator, uint64_t& denominator);
+static uint64_t gcd64(uint64_t a, uint64_t b);
+static bool lcm64(uint64_t a, uint64_t b, uint64_t& result);
+
+std::string SweepAxis::name() const {
+  switch (parameter) {
+    case SWEEP_RATIO: return "ratio_" + std::to_string(wheelId);
+    case SWEEP_MASTER_TIME: return "master_time_ms";
+    case SWEEP_LFO_DEPTH: return "lfo_depth_" + std::to_string(wheelId);
+    case SWEEP_LFO_RATE: return "lfo_rate_" + std::to_string(wheelId);
+  }
+  return "";
+}
+
+bool parseSweepAxis(const std::string& text, SweepAxis& axis, std::string& error) {
+  size_t equals = text.find('=');
+  if (equals == std::string::npos) {
+    error = "sweep '" + text + "' needs <parameter>=<from>:<to>:<steps>";
+    return false;
+  }
+  std::string parameter = text.substr(0, equals);
+  std::string wheel;
+  size_t colon = parameter.find(':');
+  if (colon != std::string::npos) {
+    wheel = parameter.substr(colon + 1);
+    parameter = parameter.substr(0, colon);
+  }
+
+  if (parameter == "ratio") axis.parameter = SWEEP_RATIO;
+  else if (parameter == "master-time") axis.parameter = SWEEP_MASTER_TIME;
+  else if (parameter == "lfo-depth") axis.parameter = SWEEP_LFO_DEPTH;
+  else if (parameter == "lfo-rate") axis.parameter = SWEEP_LFO_RATE;
+  else {
+    error = "unknown sweep parameter '" + parameter + "'";
+    return false;
+  }
+  if ((axis.parameter == SWEEP_MASTER_TIME) != wheel.empty()) {
+    error = axis.parameter == SWEEP_MASTER_TIME ? "master-time takes no wheel id" : parameter + " needs a wheel id, e.g. " + parameter + ":2=...";
+    return false;
+  }
+  if (!wheel.empty()) {
+    char* end;
+    axis.wheelId = (int)strtol(wheel.c_str(), &end, 10);
+    if (*end != '\0') {
+      error = "invalid wheel id '" + wheel + "'";
+      return false;
+    }
+  }
+
+  double steps;
+  char trailing;
+  if (sscanf(text.c_str() + equals + 1, "%lf:%lf:%lf%c", &axis.from, &axis.to, &steps, &trailing) != 3 || steps < 1 ||
+      steps != std::floor(steps)) {
+    error = "invalid range in '" + text + "', expected <from>:<to>:<steps>";
+    return false;
+  }
+  axis.steps = (size_t)steps;
+  if (axis.parameter == SWEEP_MASTER_TIME && std::min(axis.from, axis.to) <= 0) {
+    error = "master time must be positive";
+    return false;
+  }
+  return true;
+}
+
+PatternClosure computeClosure(const Machine& machine) {
+  PatternClosure closure;
+  double master = machine.masterSpeed > 0 ? machine.masterSpeed : 1.0;
+
+  // Every periodic motion in master revolutions: wheel speeds (mean speed
+  // under an LFO) and LFO frequencies
+  std::vector<double> speeds;
+  for (size_t i = 0; i < machine.wheels.size(); i++) {
+    const Wheel& wheel = machine.wheels[i];
+    double speed = wheelAngularRate(machine, i) / (2.0 * M_PI * master);
+    if (speed == 0) continue;
+    if (wheel.lfoDepth > 0 && wheel.lfoRate > 0) {
+      if (!wheel.lfoBipolar) speed *= 1.0 + 0.5 * wheel.lfoDepth / 100.0;
+      speeds.push_back(wheel.lfoRate / master);
+    }
+    speeds.push_back(speed);
+  }
+  if (speeds.empty()) return closure;
+
+  closure.closes = true;
+  std::vector<long long> numerators(speeds.size());
+  std::vector<uint64_t> denominators(speeds.size());
+  uint64_t denominatorLcm = 1;
+  for (size_t i = 0; i < speeds.size(); i++) {
+    if (!approximateRatio(speeds[i], numerators[i], denominators[i])) closure.closes = false;
+    if (numerators[i] == 0) continue;
+    if (!lcm64(denominatorLcm, denominators[i], denominatorLcm)) {
+      closure.closes = false;
+      return closure;
+    }
+  }
+
+  // T = lcm(q) / gcd(|p| * lcm(q) / q)
+  uint64_t turnsGcd = 0;
+  for (size_t i = 0; i < speeds.size(); i++) {
+    if (numerators[i] == 0) continue;
+    uint64_t scale = denominatorLcm / denominators[i];
+    uint64_t p = (uint64_t)std::llabs(numerators[i]);
+    if (p > UINT64_MAX / scale) {
+      closure.closes = false;
+      return closure;
+    }
+    turnsGcd = gcd64(turnsGcd, p * scale);
+  }
+  if (turnsGcd == 0) return closure;   // Every speed rounds to a stop
+  closure.masterRevs = (double)denominatorLcm / (double)turnsGcd;
+  closure.seconds = closure.masterRevs / master;
+  return closure;
+}
+
+size_t sweepCandidateCount(const SweepOptions& options) {
+  size_t count = 1;
+  for (const SweepAxis& axis : options.axes) {
+    if (axis.steps != 0 && count > SIZE_MAX / axis.steps) return 0;
+    count *= axis.steps;
+  }
+  return count;
+}
+
+bool runSweep(const Machine& machine, const SweepOptions& options, SweepSink& sink, SweepSummary& summary, std::string& error) {
+  summary = SweepSummary();
+  summary.candidates = sweepCandidateCount(options);
+  if (summary.candidates == 0) {
+    error = "the sweep has too many candidates";
+    return false;
+  }
+  if (options.samples == 0 || options.maxDuration < 0) {
+    error = "need at least one sample and a non-negative duration";
+    return false;
+  }
+  // Fail on a bad wheel id before starting any thread
+  for (const SweepAxis& axis : options.axes) {
+    if (axis.parameter != SWEEP_MASTER_TIME && findWheel(machine, axis.wheelId) < 0) {
+      error = "no wheel " + std::to_string(axis.wheelId);
+      return false;
+    }
+  }
+
+  unsigned int threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+  threads = (unsigned int)std::min<size_t>(threads, summary.candidates);
+  SweepRun run(machine, options, sink, summary.candidates, threads);
+
+  std::vector<std::thread> pool;
+  for (unsigned int w = 1; w < threads; w++) pool.emplace_back(runWorker, std::ref(run), w, summary.candidates);
+  runWorker(run, 0, summary.candidates);
+  for (std::thread& thread : pool) thread.join();
+
+  summary.completed = run.completed;
+  summary.threads = threads;
+  summary.steals = run.work.stealCount();
+  error = run.error;
+  return error.empty();
+}
+
+// --- Internal Helpers ---
+
+static void runWorker(SweepRun& run, unsigned int worker, size_t count) {
+  const SweepOptions& options = run.options;
+  Machine machine;
+  MetricsSink path;
+  SweepResult result;
+  int digits = (int)std::to_string(count - 1).size();
+  std::string error;
+
+  size_t index;
+  while (!run.stop && run.work.take(worker, index)) {
+    machine = run.machine;
+    applyCandidate(options, index, machine, result.values);
+    result.index = index;
+    result.closure = computeClosure(machine);
+    result.duration = (result.closure.closes && result.closure.seconds > 0)
+                          ? std::min(result.closure.seconds, options.maxDuration)
+                          : options.maxDuration;
+
+    PathOptions pathOptions;
+    pathOptions.duration = result.duration;
+    pathOptions.samples = options.samples;
+    pathOptions.maxDeviation = options.maxDeviation;
+    pathOptions.solver = options.solver;
+    PathResult pathResult;
+    path.clear();
+    if (!generatePath(machine, pathOptions, path, pathResult, error)) {
+      run.fail(error);
+      return;
+    }
+    result.metrics = path.compute();
+    result.solver = pathResult.solver;
+
+    if (!options.thumbnailDir.empty()) {
+      char name[32];
+      snprintf(name, sizeof(name), "/%0*zu.pgm", digits, index);
+      if (!path.writeThumbnail(options.thumbnailDir + name, options.thumbnailSize, error)) {
+        run.fail(error);
+        return;
+      }
+    }
+
+    std::lock_guard<std::mutex> guard(run.sinkLock);
+    if (run.stop) return;
+    if (!run.sink.write(result)) {
+      run.stop = true;
+      return;
+    }
+    run.completed++;
+  }
+}
+
+// Candidate index in mixed radix over the axes, last axis fastest
+static void applyCandidate(const SweepOptions& options, size_t index, Machine& machine, std::vector<double>& values) {
+  values.assign(options.axes.size(), 0);
+  for (size_t a = options.axes.size(); a-- > 0;) {
+    const SweepAxis& axis = options.axes[a];
+    double value = axis.value(index % axis.steps);
+    index /= axis.steps;
+    values[a] = value;
+
+    int wheel = findWheel(machine, axis.wheelId);
+    switch (axis.parameter) {
+      case SWEEP_RATIO: setWheelRatio(machine, axis.wheelId, value); break;
+      case SWEEP_MASTER_TIME: setMasterTime(machine, value); break;
+      case SWEEP_LFO_DEPTH: machine.wheels[wheel].lfoDepth = value; break;
+      case SWEEP_LFO_RATE: machine.wheels[wheel].lfoRate = value; break;
+    }
+  }
+}
+
+/**
+ * Best fraction p/q for value with q <= CLOSURE_MAX_DENOMINATOR, from the
+ * continued fraction convergents as in the firmware's PatternPeriod.
+ * @return true if the fraction matches value within CLOSURE_TOLERANCE
+ */
+static bool approximateRatio(double value, long long& numerator, uint64_t& denominator) {
+  long long h0 = 0, h1 = 1;   // Convergent numerators
+  long long k0 = 1, k1 = 0;   // Convergent denominators
+  double x = std::fabs(value);
+  if (x > 1e15) {
+    numerator = 0;
+    denominator = 1;
+    return false;
+  }
+
+  for (int i = 0; i < 32; i++) {
+    long long a = (long long)x;
+    long long h2 = a * h1 + h0;
+    long long k2 = a * k1 + k0;
+    if (k2 > CLOSURE_MAX_DENOMINATOR) break;
+    h0 = h1; h1 = h2;
+    k0 = k1; k1 = k2;
+
+    double remainder = x - (double)a;
+    if (remainder < 1e-12) break;
+    x = 1.0 / remainder;
+  }
+
+  numerator = (value < 0) ? -h1 : h1;
+  denominator = (uint64_t)k1;
+  return std::fabs(std::fabs(value) - (double)h1 / (double)k1) < CLOSURE_TOLERANCE;
+}
+
+static uint64_t gcd64(uint64_t a, uint64_t b) {
+  while (b != 0) {
+    uint64_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// lcm with overflow detection; false if the result does not fit
+static bool lcm64(uint64_t a, uint64_t b, uint64_t& result) {
+  uint64_t reduced = a / gcd64(a, b);
+  if (reduced > UINT64_MAX / b) return false;
+  result = reduced * b;
+  return true;
+}
+
+} // namespace cycloid
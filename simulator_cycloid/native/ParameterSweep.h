@@ -0,0 +1,109 @@
+/**
+ * ParameterSweep.h
+ *
+ * Evaluates every combination of a set of parameter ranges (wheel ratios,
+ * master time, wheel LFO depth and rate) on one machine, to find settings
+ * worth keeping as ratio presets. Candidates are numbered in mixed radix
+ * over the axes, last axis fastest, so none are held in memory: each worker
+ * thread owns a range of candidate numbers and steals half of another
+ * worker's remaining range when its own runs out.
+ *
+ * Each candidate runs for one closure period (capped by maxDuration) and is
+ * reported through a SweepSink as soon as it completes, in completion order.
+ */
+
+#ifndef PARAMETER_SWEEP_H
+#define PARAMETER_SWEEP_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "MachineModel.h"
+#include "PathGenerator.h"
+#include "PathMetrics.h"
+
+namespace cycloid {
+
+#define SWEEP_DEFAULT_SAMPLES 4096       // Samples per candidate
+#define SWEEP_DEFAULT_THUMBNAIL 64       // Thumbnail size in pixels
+#define CLOSURE_MAX_DENOMINATOR 100      // As PERIOD_MAX_DENOMINATOR on the firmware
+#define CLOSURE_TOLERANCE 1e-9           // Max |ratio - p/q| for an exact fraction
+
+enum SweepParameter {
+  SWEEP_RATIO,          // Wheel base ratio
+  SWEEP_MASTER_TIME,    // Milliseconds per revolution at ratio 1.0
+  SWEEP_LFO_DEPTH,      // Wheel LFO depth, percent
+  SWEEP_LFO_RATE        // Wheel LFO rate, Hz
+};
+
+struct SweepAxis {
+  SweepParameter parameter = SWEEP_RATIO;
+  int wheelId = 0;            // XML id; unused for SWEEP_MASTER_TIME
+  double from = 0, to = 0;
+  size_t steps = 1;           // Evenly spaced from..to inclusive
+
+  double value(size_t step) const { return steps > 1 ? from + (to - from) * (double)step / (double)(steps - 1) : from; }
+  std::string name() const;   // CSV column, e.g. "ratio_2"
+};
+
+// "<parameter>[:<wheel id>]=<from>:<to>:<steps>" with parameter one of
+// ratio, master-time, lfo-depth, lfo-rate (master-time takes no wheel id)
+bool parseSweepAxis(const std::string& text, SweepAxis& axis, std::string& error);
+
+struct SweepOptions {
+  std::vector<SweepAxis> axes;
+  double maxDuration = 60.0;        // Longest machine time per candidate
+  size_t samples = SWEEP_DEFAULT_SAMPLES;
+  double maxDeviation = 0;          // As PathOptions; samples then sets the base spacing
+  PathSolver solver = PATH_SOLVER_COMPILED;
+  unsigned int threads = 0;         // 0: one per hardware thread
+  std::string thumbnailDir;         // Empty: no thumbnails
+  int thumbnailSize = SWEEP_DEFAULT_THUMBNAIL;
+};
+
+// When the pen returns to its start, as PatternPeriod on the firmware: each
+// wheel's speed relative to the master is made a fraction p/q, and the path
+// closes after lcm(q) / gcd(p * lcm(q) / q) master revolutions. A wheel LFO
+// adds its own frequency and raises the wheel's mean speed.
+struct PatternClosure {
+  bool closes = false;        // Every speed is an exact fraction
+  double masterRevs = 0;      // Nearest closure when !closes; 0 if none fits 64 bits
+  double seconds = 0;
+};
+
+PatternClosure computeClosure(const Machine& machine);
+
+struct SweepResult {
+  size_t index = 0;
+  std::vector<double> values;  // One per axis
+  PatternClosure closure;
+  double duration = 0;         // Machine time simulated
+  PathMetrics metrics;
+  SolverStats solver;
+};
+
+class SweepSink {
+ public:
+  virtual ~SweepSink() {}
+  // Called by one thread at a time; return false to stop the sweep
+  virtual bool write(const SweepResult& result) = 0;
+};
+
+struct SweepSummary {
+  size_t candidates = 0;
+  size_t completed = 0;
+  unsigned int threads = 0;
+  size_t steals = 0;
+};
+
+// Product of the axis step counts; 0 if it does not fit in size_t
+size_t sweepCandidateCount(const SweepOptions& options);
+
+// Run the sweep; false with a message on the first error (a thumbnail that
+// cannot be written, a machine that cannot be solved)
+bool runSweep(const Machine& machine, const SweepOptions& options, SweepSink& sink, SweepSummary& summary, std::string& error);
+
+} // namespace cycloid
+
+#endif // PARAMETER_SWEEP_H
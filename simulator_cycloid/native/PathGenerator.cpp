@@ -0,0 +1,173 @@
+/**
+ * PathGenerator.cpp
+ *
+ * Implements chunked pen path generation for the native simulator
+ */
+
+#include "PathGenerator.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "BatchEvaluator.h"
+#include "CompiledLinkage.h"
+
+namespace cycloid {
+
+// Both solvers share solve(t) / penPosition() / stats()
+template <typename Solver>
+static void runSolver(Solver& solver, const PathOptions& options, PathSink& sink, PathResult& result) {
+  std::vector<PenSample> chunk;
+  chunk.reserve(PATH_CHUNK_SAMPLES);
+  double dt = (options.samples > 1) ? options.duration / (double)(options.samples - 1) : 0;
+  size_t samples = options.times ? options.times->size() : options.samples;
+
+  for (size_t i = 0; i < samples; i++) {
+    PenSample sample;
+    sample.t = options.times ? (*options.times)[i] : dt * (double)i;
+    solver.solve(sample.t);
+    solver.penPosition(sample.x, sample.y);
+    chunk.push_back(sample);
+
+    if (chunk.size() == PATH_CHUNK_SAMPLES || i + 1 == samples) {
+      result.samples += chunk.size();
+      bool more = sink.write(chunk.data(), chunk.size());
+      chunk.clear();
+      if (!more) break;
+    }
+  }
+
+  result.solver = solver.stats();
+}
+
+// Distance from p to the segment a-b
+static double segmentDistance(const PenSample& p, const PenSample& a, const PenSample& b) {
+  double dx = b.x - a.x, dy = b.y - a.y;
+  double px = p.x - a.x, py = p.y - a.y;
+  double length2 = dx * dx + dy * dy;
+  double f = length2 > 0 ? (px * dx + py * dy) / length2 : 0;
+  f = f < 0 ? 0 : (f > 1 ? 1 : f);
+  return std::hypot(px - f * dx, py - f * dy);
+}
+
+// Error-controlled steps. Each step solves its midpoint and its end and is
+// accepted when the midpoint lies close enough to the chord; a rejected
+// step is halved, its midpoint becoming the new end. The midpoint's
+// distance is the sagitta, about curvature * speed^2 * h^2 / 8, so the next
+// step is scaled by sqrt(aim / sagitta) and at most doubles, which keeps a
+// step from jumping over a loop that the last one approached. When the
+// speed changes within a step the error peaks off the midpoint, hence
+// accepting only PATH_ADAPTIVE_ACCEPT of maxDeviation there. The first
+// step is the shortest allowed and grows from there, so the step size
+// owes nothing to the uniform sample count.
+template <typename Solver>
+static void runAdaptive(Solver& solver, const PathOptions& options, PathSink& sink, PathResult& result) {
+  std::vector<PenSample> chunk;
+  chunk.reserve(PATH_CHUNK_SAMPLES);
+  double maxStep = options.duration / PATH_ADAPTIVE_MIN_STEPS, minStep = options.duration / PATH_ADAPTIVE_MAX_STEPS;
+  double accept = PATH_ADAPTIVE_ACCEPT * options.maxDeviation, aim = PATH_ADAPTIVE_AIM * options.maxDeviation;
+
+  auto solveAt = [&](double t, PenSample& sample) {
+    sample.t = t;
+    solver.solve(t);
+    solver.penPosition(sample.x, sample.y);
+  };
+  auto flush = [&]() {
+    result.samples += chunk.size();
+    bool more = sink.write(chunk.data(), chunk.size());
+    chunk.clear();
+    return more;
+  };
+
+  PenSample last, mid, end;
+  solveAt(0, last);
+  chunk.push_back(last);
+  double step = minStep;
+  bool more = true;
+  while (more && last.t < options.duration) {
+    double h = std::min(step, options.duration - last.t);
+    // The last step ends exactly at duration
+    solveAt(h < options.duration - last.t ? last.t + h : options.duration, end);
+    double sagitta;
+    for (;;) {
+      solveAt(last.t + 0.5 * h, mid);
+      sagitta = segmentDistance(mid, last, end);
+      if (sagitta <= accept || h <= minStep) break;
+      h *= 0.5;
+      end = mid;
+    }
+
+    chunk.push_back(end);
+    last = end;
+    if (chunk.size() == PATH_CHUNK_SAMPLES) more = flush();
+    double growth = sagitta > 0 ? std::sqrt(aim / sagitta) : 2.0;
+    step = std::max(minStep, std::min(maxStep, h * std::min(growth, 2.0)));
+  }
+  if (more && !chunk.empty()) flush();
+
+  result.solver = solver.stats();
+}
+
+// Closed-form programs: whole chunks at a time through the batch evaluator
+static void runBatches(BatchEvaluator& evaluator, const PathOptions& options, PathSink& sink, PathResult& result) {
+  std::vector<PenSample> chunk(PATH_CHUNK_SAMPLES);
+  std::vector<double> x(PATH_CHUNK_SAMPLES), y(PATH_CHUNK_SAMPLES);
+  double dt = (options.samples > 1) ? options.duration / (double)(options.samples - 1) : 0;
+
+  for (size_t first = 0; first < options.samples; first += PATH_CHUNK_SAMPLES) {
+    size_t count = std::min((size_t)PATH_CHUNK_SAMPLES, options.samples - first);
+    evaluator.evaluate(dt, first, count, x.data(), y.data());
+    for (size_t i = 0; i < count; i++) chunk[i] = { dt * (double)(first + i), x[i], y[i] };
+
+    result.samples += count;
+    if (!sink.write(chunk.data(), count)) break;
+  }
+
+  result.solver = evaluator.stats();
+}
+
+bool BoundsSink::write(const PenSample* samples, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    minX = std::min(minX, samples[i].x);
+    maxX = std::max(maxX, samples[i].x);
+    minY = std::min(minY, samples[i].y);
+    maxY = std::max(maxY, samples[i].y);
+  }
+  return true;
+}
+
+bool generatePath(const Machine& machine, const PathOptions& options, PathSink& sink, PathResult& result, std::string& error) {
+  result = PathResult();
+  if (options.times ? options.times->empty() : (options.samples == 0 || options.duration < 0)) {
+    error = "need at least one sample and a non-negative duration";
+    return false;
+  }
+  if (!(options.maxDeviation >= 0)) {
+    error = "the maximum deviation must not be negative";
+    return false;
+  }
+
+  bool adaptive = options.maxDeviation > 0 && !options.times;
+  if (options.solver == PATH_SOLVER_NEWTON) {
+    LinkageSolver solver(machine);
+    if (adaptive) {
+      runAdaptive(solver, options, sink, result);
+    } else {
+      runSolver(solver, options, sink, result);
+    }
+  } else {
+    CompiledLinkage solver(machine);
+    BatchEvaluator evaluator(solver);
+    if (adaptive) {
+      runAdaptive(solver, options, sink, result);
+    } else if (evaluator.supported() && !options.times) {   // Batches need evenly spaced samples
+      runBatches(evaluator, options, sink, result);
+    } else {
+      runSolver(solver, options, sink, result);
+    }
+  }
+  return true;
+}
+
+} // namespace cycloid
@@ -0,0 +1,78 @@
+/**
+ * PathGenerator.h
+ *
+ * Streams the pen path of a Machine over time in fixed-size chunks, so
+ * consumers (CSV writer, rasterizer, exporters) never need the whole path
+ * in memory.
+ */
+
+#ifndef PATH_GENERATOR_H
+#define PATH_GENERATOR_H
+
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "LinkageSolver.h"
+#include "MachineModel.h"
+
+namespace cycloid {
+
+#define PATH_CHUNK_SAMPLES 4096
+#define PATH_ADAPTIVE_MIN_STEPS 256.0          // Longest adaptive step is duration / this
+#define PATH_ADAPTIVE_MAX_STEPS 16777216.0     // Shortest adaptive step, and the first, is duration / this
+#define PATH_ADAPTIVE_ACCEPT 0.8               // Largest midpoint error accepted, as a share of maxDeviation
+#define PATH_ADAPTIVE_AIM 0.65                 // Midpoint error the next step is sized for, likewise
+
+struct PenSample {
+  double t;
+  double x, y;
+};
+
+class PathSink {
+ public:
+  virtual ~PathSink() {}
+  // Called with consecutive chunks; return false to stop generation early
+  virtual bool write(const PenSample* samples, size_t count) = 0;
+};
+
+// Bounding box of everything written, for a first pass that sizes the output
+class BoundsSink : public PathSink {
+ public:
+  bool write(const PenSample* samples, size_t count) override;
+  bool empty() const { return minX > maxX; }
+  double minX = HUGE_VAL, minY = HUGE_VAL, maxX = -HUGE_VAL, maxY = -HUGE_VAL;
+};
+
+enum PathSolver {
+  PATH_SOLVER_COMPILED,       // Closed-form program, Newton only where it cannot order the rods
+  PATH_SOLVER_NEWTON          // Whole-machine Newton iteration on every sample
+};
+
+struct PathOptions {
+  double duration = 60.0;     // Seconds of machine time
+  size_t samples = 3600;      // Evenly spaced from 0 to duration inclusive, as np.linspace
+  PathSolver solver = PATH_SOLVER_COMPILED;
+  // > 0: sample adaptively instead, so the straight segment between two
+  // samples stays within maxDeviation (mm) of the pen. The tolerance alone
+  // sets the step; samples is ignored, and duration only bounds the step
+  // to between 1 / PATH_ADAPTIVE_MAX_STEPS and 1 / PATH_ADAPTIVE_MIN_STEPS
+  // of itself.
+  double maxDeviation = 0;
+  // When set, sample at these increasing times instead (the rows of a step
+  // trace); duration and samples are ignored
+  const std::vector<double>* times = nullptr;
+};
+
+struct PathResult {
+  size_t samples = 0;         // Samples delivered to the sink
+  SolverStats solver;
+};
+
+// Generate the path; false with a message if the machine cannot be solved
+bool generatePath(const Machine& machine, const PathOptions& options, PathSink& sink, PathResult& result, std::string& error);
+
+} // namespace cycloid
+
+#endif // PATH_GENERATOR_H
@@ -0,0 +1,165 @@
+/**
+ * PathMetrics.cpp
+ *
+ * Implements path metrics and thumbnails for the parameter sweep
+ */
+
+#include "PathMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace cycloid {
+
+#define METRICS_CELL_ENTRIES 16    // Average cells per segment before the grid is coarsened
+
+bool MetricsSink::write(const PenSample* samples, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    x.push_back(samples[i].x);
+    y.push_back(samples[i].y);
+  }
+  return true;
+}
+
+void MetricsSink::clear() {
+  x.clear();
+  y.clear();
+}
+
+PathMetrics MetricsSink::compute() {
+  PathMetrics metrics;
+  if (x.empty()) return metrics;
+
+  metrics.minX = metrics.maxX = x[0];
+  metrics.minY = metrics.maxY = y[0];
+  for (size_t i = 1; i < x.size(); i++) {
+    metrics.minX = std::min(metrics.minX, x[i]);
+    metrics.maxX = std::max(metrics.maxX, x[i]);
+    metrics.minY = std::min(metrics.minY, y[i]);
+    metrics.maxY = std::max(metrics.maxY, y[i]);
+    metrics.inkLength += std::hypot(x[i] - x[i - 1], y[i] - y[i - 1]);
+  }
+
+  metrics.crossings = countCrossings(metrics.minX, metrics.minY, metrics.maxX, metrics.maxY);
+  double diagonal = std::hypot(metrics.maxX - metrics.minX, metrics.maxY - metrics.minY);
+  if (metrics.inkLength > 0) metrics.crossingDensity = metrics.crossings * diagonal / metrics.inkLength;
+  return metrics;
+}
+
+// --- Internal Helpers ---
+
+// Segment i joins samples i and i + 1. Every segment is listed in each grid
+// cell its bounding box touches; a crossing is counted only in the cell that
+// contains it, so pairs sharing several cells are not counted twice.
+size_t MetricsSink::countCrossings(double minX, double minY, double maxX, double maxY) {
+  size_t segments = x.size() < 2 ? 0 : x.size() - 1;
+  if (segments < 3) return 0;
+
+  int grid = std::min(METRICS_MAX_GRID, std::max(1, (int)std::sqrt((double)segments)));
+  int cellsX = 1, cellsY = 1;
+  double cellW = 1, cellH = 1;
+  auto cellOf = [&](double px, double py, int& cx, int& cy) {
+    cx = std::min(cellsX - 1, std::max(0, (int)((px - minX) / cellW)));
+    cy = std::min(cellsY - 1, std::max(0, (int)((py - minY) / cellH)));
+  };
+
+  // Coarsen the grid until long segments no longer fill it many times over
+  for (;;) {
+    cellsX = (maxX > minX) ? grid : 1;
+    cellsY = (maxY > minY) ? grid : 1;
+    cellW = (maxX > minX) ? (maxX - minX) / cellsX : 1;
+    cellH = (maxY > minY) ? (maxY - minY) / cellsY : 1;
+    cellStart.assign((size_t)cellsX * cellsY + 1, 0);
+
+    size_t entries = 0;
+    for (size_t i = 0; i < segments; i++) {
+      int x0, y0, x1, y1;
+      cellOf(std::min(x[i], x[i + 1]), std::min(y[i], y[i + 1]), x0, y0);
+      cellOf(std::max(x[i], x[i + 1]), std::max(y[i], y[i + 1]), x1, y1);
+      for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) cellStart[(size_t)cy * cellsX + cx + 1]++;
+      }
+      entries += (size_t)(x1 - x0 + 1) * (y1 - y0 + 1);
+    }
+    if (grid == 1 || entries <= segments * METRICS_CELL_ENTRIES) break;
+    grid /= 2;
+  }
+
+  for (size_t c = 1; c < cellStart.size(); c++) cellStart[c] += cellStart[c - 1];
+  cellSegments.resize(cellStart.back());
+  std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+  for (size_t i = 0; i < segments; i++) {
+    int x0, y0, x1, y1;
+    cellOf(std::min(x[i], x[i + 1]), std::min(y[i], y[i + 1]), x0, y0);
+    cellOf(std::max(x[i], x[i + 1]), std::max(y[i], y[i + 1]), x1, y1);
+    for (int cy = y0; cy <= y1; cy++) {
+      for (int cx = x0; cx <= x1; cx++) cellSegments[fill[(size_t)cy * cellsX + cx]++] = (int)i;
+    }
+  }
+
+  size_t crossings = 0;
+  for (int cy = 0; cy < cellsY; cy++) {
+    for (int cx = 0; cx < cellsX; cx++) {
+      size_t cell = (size_t)cy * cellsX + cx;
+      for (int a = cellStart[cell]; a < cellStart[cell + 1]; a++) {
+        int i = cellSegments[a];
+        double ax = x[i], ay = y[i], adx = x[i + 1] - ax, ady = y[i + 1] - ay;
+        for (int b = a + 1; b < cellStart[cell + 1]; b++) {
+          int j = cellSegments[b];
+          if (j == i + 1) continue;   // Neighbours share a sample
+          double bdx = x[j + 1] - x[j], bdy = y[j + 1] - y[j];
+          double denom = adx * bdy - ady * bdx;
+          if (denom == 0) continue;   // Parallel or a stopped pen
+          double ox = x[j] - ax, oy = y[j] - ay;
+          double s = (ox * bdy - oy * bdx) / denom;
+          double u = (ox * ady - oy * adx) / denom;
+          // Strictly inside both, so touching at a sample is not a crossing
+          if (!(s > 0 && s < 1 && u > 0 && u < 1)) continue;
+          int px, py;
+          cellOf(ax + s * adx, ay + s * ady, px, py);
+          if (px == cx && py == cy) crossings++;
+        }
+      }
+    }
+  }
+  return crossings;
+}
+
+bool MetricsSink::writeThumbnail(const std::string& path, int size, std::string& error) const {
+  std::vector<unsigned char> pixels((size_t)size * size, 255);
+  if (!x.empty()) {
+    double minX = *std::min_element(x.begin(), x.end()), maxX = *std::max_element(x.begin(), x.end());
+    double minY = *std::min_element(y.begin(), y.end()), maxY = *std::max_element(y.begin(), y.end());
+    double span = std::max(maxX - minX, maxY - minY);
+    double inner = size - 1 - 2 * THUMBNAIL_MARGIN;
+    double scale = (span > 0 && inner > 0) ? inner / span : 0;
+    // Centered, y up as in the machine frame
+    double offsetX = 0.5 * (size - 1) - 0.5 * (minX + maxX) * scale;
+    double offsetY = 0.5 * (size - 1) + 0.5 * (minY + maxY) * scale;
+
+    for (size_t i = 0; i < x.size(); i++) {
+      double x0 = (i > 0 ? x[i - 1] : x[i]) * scale + offsetX, y0 = offsetY - (i > 0 ? y[i - 1] : y[i]) * scale;
+      double x1 = x[i] * scale + offsetX, y1 = offsetY - y[i] * scale;
+      int steps = std::max(1, (int)std::ceil(std::max(std::fabs(x1 - x0), std::fabs(y1 - y0))));
+      for (int k = 0; k <= steps; k++) {
+        double f = (double)k / steps;
+        int px = (int)std::lround(x0 + f * (x1 - x0)), py = (int)std::lround(y0 + f * (y1 - y0));
+        if (px >= 0 && px < size && py >= 0 && py < size) pixels[(size_t)py * size + px] = 0;
+      }
+    }
+  }
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file) {
+    error = "cannot write " + path;
+    return false;
+  }
+  fprintf(file, "P5\n%d %d\n255\n", size, size);
+  bool ok = fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+  ok = (fclose(file) == 0) && ok;
+  if (!ok) error = "error writing " + path;
+  return ok;
+}
+
+} // namespace cycloid
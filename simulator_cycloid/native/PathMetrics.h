@@ -0,0 +1,57 @@
+/**
+ * PathMetrics.h
+ *
+ * Summary figures for one pen path, used to rank sweep candidates: the
+ * bounding box, the ink length, how often the path crosses itself, and a
+ * small grayscale thumbnail. The sink keeps the samples it is given (one
+ * candidate's path, a few thousand points) because crossings need them all.
+ */
+
+#ifndef PATH_METRICS_H
+#define PATH_METRICS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "PathGenerator.h"
+
+namespace cycloid {
+
+#define METRICS_MAX_GRID 256       // Cells per side of the crossing grid
+#define THUMBNAIL_MARGIN 2         // Blank pixels around the drawing
+
+struct PathMetrics {
+  double minX = 0, minY = 0, maxX = 0, maxY = 0;
+  double inkLength = 0;
+  size_t crossings = 0;            // Proper crossings of non-adjacent segments
+  // Crossings per bounding-box diagonal of ink; independent of scale and
+  // of the sample count once the path is resolved
+  double crossingDensity = 0;
+};
+
+class MetricsSink : public PathSink {
+ public:
+  bool write(const PenSample* samples, size_t count) override;
+
+  // Forget the previous path, keeping the buffers
+  void clear();
+
+  // Bounding box and ink length come from the samples; crossings are
+  // counted on a uniform grid so a path costs about O(n) rather than O(n²)
+  PathMetrics compute();
+
+  // size x size 8-bit PGM of the path fitted to its bounding box; false
+  // with a message if the file cannot be written
+  bool writeThumbnail(const std::string& path, int size, std::string& error) const;
+
+ private:
+  size_t countCrossings(double minX, double minY, double maxX, double maxY);
+
+  std::vector<double> x, y;
+  std::vector<int> cellStart, cellSegments;   // Segments by grid cell, CSR layout
+};
+
+} // namespace cycloid
+
+#endif // PATH_METRICS_H
@@ -0,0 +1,85 @@
+/**
+ * PathSimplifier.cpp
+ *
+ * Implements windowed Ramer-Douglas-Peucker simplification
+ */
+
+#include "PathSimplifier.h"
+
+#include <cmath>
+
+namespace cycloid {
+
+bool PathSimplifier::write(const PenSample* samples, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    x.push_back(samples[i].x);
+    y.push_back(samples[i].y);
+    if (x.size() == SIMPLIFY_WINDOW && !flushWindow(false)) return false;
+  }
+  inputs += count;
+  return true;
+}
+
+bool PathSimplifier::finish() {
+  return flushWindow(true);
+}
+
+// --- Internal Helpers ---
+
+// Simplify the window; pass on every kept vertex but the last unless this
+// is the end of the path, and start the next window from that vertex
+bool PathSimplifier::flushWindow(bool last) {
+  size_t n = x.size();
+  if (n == 0) return true;
+  keep.assign(n, 0);
+  keep[0] = keep[n - 1] = 1;
+
+  // Iterative RDP: split each span at its farthest sample while that lies
+  // beyond the tolerance of the chord. Distances are to the chord segment,
+  // so a span that ends where it began (a closed loop) still splits.
+  double limit = tolerance * tolerance;
+  stack.clear();
+  if (n > 2) stack.push_back({ 0, n - 1 });
+  while (!stack.empty()) {
+    size_t first = stack.back().first, end = stack.back().second;
+    stack.pop_back();
+    double ax = x[first], ay = y[first];
+    double dx = x[end] - ax, dy = y[end] - ay;
+    double length2 = dx * dx + dy * dy;
+    double farthest = -1;
+    size_t split = first;
+    for (size_t i = first + 1; i < end; i++) {
+      double px = x[i] - ax, py = y[i] - ay;
+      double f = length2 > 0 ? (px * dx + py * dy) / length2 : 0;
+      f = f < 0 ? 0 : (f > 1 ? 1 : f);
+      double ex = px - f * dx, ey = py - f * dy;
+      double distance2 = ex * ex + ey * ey;
+      if (distance2 > farthest) {
+        farthest = distance2;
+        split = i;
+      }
+    }
+    if (farthest <= limit) continue;
+    keep[split] = 1;
+    if (split - first > 1) stack.push_back({ first, split });
+    if (end - split > 1) stack.push_back({ split, end });
+  }
+
+  size_t passOn = last ? n : n - 1;
+  for (size_t i = 0; i < passOn; i++) {
+    if (!keep[i]) continue;
+    outputs++;
+    if (!out.vertex(x[i], y[i])) return false;
+  }
+
+  double lastX = x[n - 1], lastY = y[n - 1];
+  x.clear();
+  y.clear();
+  if (!last) {
+    x.push_back(lastX);
+    y.push_back(lastY);
+  }
+  return true;
+}
+
+} // namespace cycloid
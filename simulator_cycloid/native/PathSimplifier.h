@@ -0,0 +1,62 @@
+/**
+ * PathSimplifier.h
+ *
+ * Streaming Ramer-Douglas-Peucker simplification of a pen path. Samples
+ * are collected into windows of SIMPLIFY_WINDOW points; each full window is
+ * simplified and its kept vertices passed on, except the last, which opens
+ * the next window. Memory is one window whatever the path length, and every
+ * dropped sample stays within the tolerance of the polyline that replaces
+ * it, as with whole-path RDP. The only difference is that window ends are
+ * always kept, which costs a vertex per window.
+ *
+ * RDP keeps vertices where the path bends, so tight loops keep their
+ * samples and long gentle arcs collapse to a few chords.
+ */
+
+#ifndef PATH_SIMPLIFIER_H
+#define PATH_SIMPLIFIER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "PathGenerator.h"
+
+namespace cycloid {
+
+#define SIMPLIFY_WINDOW 8192
+
+class VertexSink {
+ public:
+  virtual ~VertexSink() {}
+  // Called with each kept vertex in path order; return false to stop
+  virtual bool vertex(double x, double y) = 0;
+};
+
+class PathSimplifier : public PathSink {
+ public:
+  // tolerance: largest distance, in path units, of a dropped sample from
+  // the simplified polyline
+  PathSimplifier(double tolerance, VertexSink& out) : tolerance(tolerance), out(out) {}
+
+  bool write(const PenSample* samples, size_t count) override;
+
+  // Simplify and pass on what is left; call once after the last write()
+  bool finish();
+
+  size_t inputCount() const { return inputs; }
+  size_t outputCount() const { return outputs; }
+
+ private:
+  bool flushWindow(bool last);
+
+  double tolerance;
+  VertexSink& out;
+  std::vector<double> x, y;
+  std::vector<char> keep;
+  std::vector<std::pair<size_t, size_t>> stack;
+  size_t inputs = 0, outputs = 0;
+};
+
+} // namespace cycloid
+
+#endif // PATH_SIMPLIFIER_H
@@ -0,0 +1,199 @@
+/**
+ * PngWriter.cpp
+ *
+ * Implements the streaming PNG encoder: zlib framing, a fixed-Huffman
+ * deflate block with run-length matches, Adler-32 and chunk CRC-32.
+ */
+
+#include "PngWriter.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace cycloid {
+
+#define DEFLATE_MAX_RUN 258
+#define ADLER_MODULUS 65521
+#define ADLER_BLOCK 5552       // Most bytes summed before the Adler sums can overflow 32 bits
+
+// --- Forward Declarations for Static Functions ---
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size);
+static void putBigEndian(uint8_t* out, uint32_t value);
+
+// Deflate length codes 257..285: base length and extra bits
+static const uint16_t LENGTH_BASE[29] = { 3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                          31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                          2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+PngWriter::PngWriter(FILE* file, uint32_t width, uint32_t height)
+    : file(file), width(width), height(height), previous(width, 0), filtered(width + 1) {
+  static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  failed = fwrite(signature, 1, sizeof(signature), file) != sizeof(signature);
+
+  uint8_t header[13];
+  putBigEndian(header, width);
+  putBigEndian(header + 4, height);
+  header[8] = 8;     // Bit depth
+  header[9] = 0;     // Grayscale
+  header[10] = 0;    // Deflate
+  header[11] = 0;    // Adaptive filtering
+  header[12] = 0;    // Not interlaced
+  writeChunk("IHDR", header, sizeof(header));
+
+  // zlib header (deflate, 32K window, no dictionary), then an open
+  // non-final fixed-Huffman block
+  pending.push_back(0x78);
+  pending.push_back(0x01);
+  putBits(0, 1);
+  putBits(1, 2);
+}
+
+void PngWriter::writeRow(const uint8_t* pixels) {
+  if (rows >= height) {
+    failed = true;
+    return;
+  }
+  // Up filter: most of a drawing repeats the row above
+  filtered[0] = 2;
+  for (uint32_t x = 0; x < width; x++) filtered[x + 1] = (uint8_t)(pixels[x] - previous[x]);
+  memcpy(previous.data(), pixels, width);
+  compress(filtered.data(), filtered.size());
+  rows++;
+}
+
+bool PngWriter::finish(std::string& error) {
+  // End the open block, then an empty final block
+  putHuffman(0, 7);
+  putBits(1, 1);
+  putBits(1, 2);
+  putHuffman(0, 7);
+  if (bitCount > 0) putBits(0, 8 - bitCount);
+
+  uint8_t adler[4];
+  putBigEndian(adler, ((adlerB % ADLER_MODULUS) << 16) | (adlerA % ADLER_MODULUS));
+  flushBytes(false);
+  pending.insert(pending.end(), adler, adler + 4);
+  flushBytes(true);
+  writeChunk("IEND", nullptr, 0);
+
+  if (rows != height) {
+    error = "image has " + std::to_string(rows) + " rows, expected " + std::to_string(height);
+    return false;
+  }
+  if (failed) error = "error writing PNG";
+  return !failed;
+}
+
+// --- Internal Helpers ---
+
+void PngWriter::compress(const uint8_t* data, size_t count) {
+  for (size_t start = 0; start < count; start += ADLER_BLOCK) {
+    size_t end = std::min(count, start + ADLER_BLOCK);
+    for (size_t i = start; i < end; i++) {
+      adlerA += data[i];
+      adlerB += adlerA;
+    }
+    adlerA %= ADLER_MODULUS;
+    adlerB %= ADLER_MODULUS;
+  }
+
+  size_t i = 0;
+  while (i < count) {
+    if (data[i] == lastByte) {
+      size_t run = 1;
+      while (i + run < count && run < DEFLATE_MAX_RUN && data[i + run] == lastByte) run++;
+      if (run >= 3) {
+        putRun((unsigned int)run);
+        i += run;
+        continue;
+      }
+    }
+    putLiteral(data[i]);
+    lastByte = data[i];
+    i++;
+  }
+  flushBytes(false);
+}
+
+// Fixed Huffman code of a literal/length symbol (RFC 1951, 3.2.6)
+void PngWriter::putLiteral(unsigned int value) {
+  if (value < 144) putHuffman(0x30 + value, 8);
+  else if (value < 256) putHuffman(0x190 + value - 144, 9);
+  else if (value < 280) putHuffman(value - 256, 7);
+  else putHuffman(0xC0 + value - 280, 8);
+}
+
+// Repeat the previous byte length times (a match at distance 1)
+void PngWriter::putRun(unsigned int length) {
+  int code = 28;
+  while (LENGTH_BASE[code] > length) code--;
+  putLiteral(257 + code);
+  if (LENGTH_EXTRA[code]) putBits(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+  putHuffman(0, 5);    // Distance code 0: distance 1
+}
+
+void PngWriter::putBits(uint32_t bits, int count) {
+  bitBuffer |= (uint64_t)bits << bitCount;
+  bitCount += count;
+  while (bitCount >= 8) {
+    pending.push_back((uint8_t)bitBuffer);
+    bitBuffer >>= 8;
+    bitCount -= 8;
+  }
+}
+
+// Huffman codes are packed most significant bit first
+void PngWriter::putHuffman(uint32_t code, int length) {
+  uint32_t reversed = 0;
+  for (int i = 0; i < length; i++) reversed |= ((code >> i) & 1) << (length - 1 - i);
+  putBits(reversed, length);
+}
+
+void PngWriter::flushBytes(bool all) {
+  size_t start = 0;
+  while (pending.size() - start >= PNG_CHUNK_BYTES || (all && start < pending.size())) {
+    size_t size = std::min((size_t)PNG_CHUNK_BYTES, pending.size() - start);
+    writeChunk("IDAT", pending.data() + start, size);
+    start += size;
+  }
+  pending.erase(pending.begin(), pending.begin() + start);
+}
+
+void PngWriter::writeChunk(const char* type, const uint8_t* data, size_t size) {
+  uint8_t header[8], trailer[4];
+  putBigEndian(header, (uint32_t)size);
+  memcpy(header + 4, type, 4);
+  uint32_t crc = crc32Update(0xFFFFFFFFu, header + 4, 4);
+  crc = crc32Update(crc, data, size) ^ 0xFFFFFFFFu;
+  putBigEndian(trailer, crc);
+
+  bool ok = fwrite(header, 1, 8, file) == 8;
+  if (size > 0) ok = ok && fwrite(data, 1, size, file) == size;
+  ok = ok && fwrite(trailer, 1, 4, file) == 4;
+  if (!ok) failed = true;
+}
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t size) {
+  static const struct CrcTable {
+    uint32_t entries[256];
+    CrcTable() {
+      for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        entries[n] = c;
+      }
+    }
+  } table;
+  for (size_t i = 0; i < size; i++) crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return crc;
+}
+
+static void putBigEndian(uint8_t* out, uint32_t value) {
+  out[0] = (uint8_t)(value >> 24);
+  out[1] = (uint8_t)(value >> 16);
+  out[2] = (uint8_t)(value >> 8);
+  out[3] = (uint8_t)value;
+}
+
+} // namespace cycloid
@@ -0,0 +1,64 @@
+/**
+ * PngWriter.h
+ *
+ * Streaming 8-bit grayscale PNG encoder with no zlib dependency. Rows are
+ * compressed as they arrive and written out in IDAT chunks of about
+ * PNG_CHUNK_BYTES, so an image of any height needs one row of memory.
+ *
+ * Compression is a single fixed-Huffman deflate block that only looks for
+ * runs (matches at distance 1) after the PNG "Up" filter. That is all a
+ * pattern preview needs: blank paper and unchanged columns collapse to a
+ * few bits per 258 bytes, and the encoder stays a few dozen lines.
+ */
+
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace cycloid {
+
+#define PNG_CHUNK_BYTES 65536
+
+class PngWriter {
+ public:
+  // Writes the signature and header; check ok() before adding rows
+  PngWriter(FILE* file, uint32_t width, uint32_t height);
+
+  // One row of width gray values, top to bottom
+  void writeRow(const uint8_t* pixels);
+
+  // Ends the deflate stream and writes IEND; false on a short row count or
+  // a write error
+  bool finish(std::string& error);
+
+  bool ok() const { return !failed; }
+
+ private:
+  void compress(const uint8_t* data, size_t count);
+  void putLiteral(unsigned int value);
+  void putRun(unsigned int length);
+  void putBits(uint32_t bits, int count);
+  void putHuffman(uint32_t code, int length);
+  void flushBytes(bool all);
+  void writeChunk(const char* type, const uint8_t* data, size_t size);
+
+  FILE* file;
+  uint32_t width, height, rows = 0;
+  bool failed = false;
+
+  std::vector<uint8_t> previous, filtered;   // Last row; current row after the Up filter
+  int lastByte = -1;                         // Previous byte of the stream, for runs
+  uint32_t adlerA = 1, adlerB = 0;
+
+  uint64_t bitBuffer = 0;
+  int bitCount = 0;
+  std::vector<uint8_t> pending;              // Compressed bytes not yet in an IDAT chunk
+};
+
+} // namespace cycloid
+
+#endif // PNG_WRITER_H
@@ -0,0 +1,267 @@
+/**
+ * Rasterizer.cpp
+ *
+ * Implements banded ink rendering: a bounds pass to fit the view, worker
+ * threads that each render one band per path pass, and an in-order writer
+ * feeding PngWriter.
+ */
+
+#include "Rasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "PngWriter.h"
+
+namespace cycloid {
+
+namespace {
+
+// World to pixel mapping; pixel (i, j) covers [i, i + 1) x [j, j + 1)
+struct RasterView {
+  double originX = 0, originY = 0;   // World point at the top-left image corner
+  double scale = 1;                  // Pixels per world unit
+  uint32_t width = 1, height = 1;
+};
+
+// Stamps the nib along the path, keeping only what lands in rows
+// [firstRow, firstRow + rows) of ink
+class BandSink : public PathSink {
+ public:
+  BandSink(const RasterView& view, double radius, double dwell, uint32_t firstRow, uint32_t rows, float* ink)
+      : view(view), radius(radius), reach(radius + 1.0), dwell(dwell), firstRow(firstRow), rows(rows), ink(ink) {}
+
+  bool write(const PenSample* samples, size_t count) override {
+    // Skip chunks that cannot reach the band
+    double top = HUGE_VAL, bottom = -HUGE_VAL;
+    if (hasPrevious) top = bottom = previousY;
+    for (size_t i = 0; i < count; i++) {
+      double py = (view.originY - samples[i].y) * view.scale;
+      top = std::min(top, py);
+      bottom = std::max(bottom, py);
+    }
+    bool touches = bottom >= firstRow - reach && top <= firstRow + rows + reach;
+
+    for (size_t i = 0; i < count; i++) {
+      double px = (samples[i].x - view.originX) * view.scale;
+      double py = (view.originY - samples[i].y) * view.scale;
+      if (touches && hasPrevious) drawSegment(previousX, previousY, px, py, samples[i].t - previousT);
+      previousX = px;
+      previousY = py;
+      previousT = samples[i].t;
+      hasPrevious = true;
+    }
+    return true;
+  }
+
+ private:
+  // The nib takes seconds to go from (x0, y0) to (x1, y1); ink it bleeds
+  // meanwhile is spread over the segment's stamps
+  void drawSegment(double x0, double y0, double x1, double y1, double seconds) {
+    if (std::max(y0, y1) < firstRow - reach || std::min(y0, y1) > firstRow + rows + reach) return;
+    double length = std::hypot(x1 - x0, y1 - y0);
+    double rest = dwell * seconds;
+    if (length == 0) {
+      if (rest > 0) stamp(x0, y0, (float)rest);
+      return;
+    }
+    int stamps = std::max(1, (int)std::ceil(length / RASTER_DAB_SPACING));
+    // A straight pass through a pixel center sums to 1: the nib profile
+    // integrates to 2 * radius across the stroke
+    float weight = (float)((length / (2.0 * radius) + rest) / stamps);
+    for (int k = 0; k < stamps; k++) {
+      double f = (k + 0.5) / stamps;
+      stamp(x0 + f * (x1 - x0), y0 + f * (y1 - y0), weight);
+    }
+  }
+
+  // Round nib with a one-pixel anti-aliased edge, sampled at pixel centers
+  void stamp(double cx, double cy, float weight) {
+    int top = std::max((int)firstRow, (int)std::floor(cy - reach));
+    int bottom = std::min((int)(firstRow + rows) - 1, (int)std::ceil(cy + reach));
+    int left = std::max(0, (int)std::floor(cx - reach));
+    int right = std::min((int)view.width - 1, (int)std::ceil(cx + reach));
+    for (int py = top; py <= bottom; py++) {
+      float* row = ink + (size_t)(py - firstRow) * view.width;
+      double dy = py + 0.5 - cy;
+      for (int px = left; px <= right; px++) {
+        double dx = px + 0.5 - cx;
+        double coverage = radius + 0.5 - std::sqrt(dx * dx + dy * dy);
+        if (coverage > 0) row[px] += weight * (float)std::min(coverage, 1.0);
+      }
+    }
+  }
+
+  const RasterView& view;
+  double radius, reach, dwell;
+  uint32_t firstRow, rows;
+  float* ink;
+  double previousX = 0, previousY = 0, previousT = 0;
+  bool hasPrevious = false;
+};
+
+// A rendered band waiting for the writer
+struct BandSlot {
+  std::vector<uint8_t> pixels;
+  size_t band = 0;
+  bool ready = false;
+};
+
+// State shared by the render workers and the writer
+struct RenderRun {
+  const Machine& machine;
+  const PathOptions& path;
+  const RasterOptions& options;
+  RasterView view;
+  size_t bands = 0;
+
+  std::mutex lock;
+  std::condition_variable changed;
+  size_t nextBand = 0, writtenBands = 0;
+  std::vector<BandSlot> slots;
+  bool stop = false;
+  std::string error;
+  RasterResult result;
+
+  RenderRun(const Machine& machine, const PathOptions& path, const RasterOptions& options)
+      : machine(machine), path(path), options(options) {}
+};
+
+}  // namespace
+
+// --- Forward Declarations for Static Functions ---
+static bool fitView(const Machine& machine, const PathOptions& path, const RasterOptions& options, RasterView& view,
+                    RasterResult& result, std::string& error);
+static void renderWorker(RenderRun& run);
+
+bool renderPattern(const Machine& machine, const PathOptions& path, const RasterOptions& options, FILE* png,
+                   RasterResult& result, std::string& error) {
+  result = RasterResult();
+  if (options.size == 0 || options.penWidth < 1 || !(options.inkOpacity > 0 && options.inkOpacity < 1) ||
+      !(options.dwell >= 0)) {
+    error = "need a positive size, a pen width of at least 1, an ink opacity between 0 and 1 and a non-negative dwell";
+    return false;
+  }
+
+  RenderRun run(machine, path, options);
+  if (!fitView(machine, path, options, run.view, run.result, error)) return false;
+  run.bands = (run.view.height + RASTER_BAND_ROWS - 1) / RASTER_BAND_ROWS;
+
+  unsigned int threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+  threads = (unsigned int)std::min<size_t>(threads, run.bands);
+  run.slots.resize(threads);
+  for (BandSlot& slot : run.slots) slot.pixels.resize((size_t)run.view.width * RASTER_BAND_ROWS);
+
+  std::vector<std::thread> pool;
+  for (unsigned int w = 0; w < threads; w++) pool.emplace_back(renderWorker, std::ref(run));
+
+  // Write bands in order as they complete
+  PngWriter writer(png, run.view.width, run.view.height);
+  for (size_t band = 0; band < run.bands; band++) {
+    BandSlot& slot = run.slots[band % run.slots.size()];
+    {
+      std::unique_lock<std::mutex> guard(run.lock);
+      run.changed.wait(guard, [&] { return run.stop || (slot.ready && slot.band == band); });
+      if (run.stop) break;
+    }
+    uint32_t firstRow = (uint32_t)band * RASTER_BAND_ROWS;
+    uint32_t rows = std::min<uint32_t>(RASTER_BAND_ROWS, run.view.height - firstRow);
+    for (uint32_t r = 0; r < rows; r++) writer.writeRow(slot.pixels.data() + (size_t)r * run.view.width);
+
+    std::lock_guard<std::mutex> guard(run.lock);
+    slot.ready = false;
+    run.writtenBands++;
+    if (!writer.ok()) {
+      run.error = "error writing PNG";
+      run.stop = true;
+    }
+    run.changed.notify_all();
+  }
+  for (std::thread& thread : pool) thread.join();
+
+  result = run.result;
+  if (!run.error.empty()) {
+    error = run.error;
+    return false;
+  }
+  return writer.finish(error);
+}
+
+// --- Internal Helpers ---
+
+// One pass over the path for its bounds; the longer side gets options.size pixels
+static bool fitView(const Machine& machine, const PathOptions& path, const RasterOptions& options, RasterView& view,
+                    RasterResult& result, std::string& error) {
+  BoundsSink bounds;
+  PathResult pathResult;
+  if (!generatePath(machine, path, bounds, pathResult, error)) return false;
+  result.samples += pathResult.samples;
+  result.solver = pathResult.solver;
+
+  double spanX = bounds.maxX - bounds.minX, spanY = bounds.maxY - bounds.minY;
+  double span = std::max(spanX, spanY);
+  double inner = options.size * (1.0 - 2.0 * RASTER_MARGIN);
+  view.scale = span > 0 ? inner / span : 1.0;
+  view.width = spanX >= spanY ? options.size : std::max<uint32_t>(1, (uint32_t)std::lround(options.size * spanX / span));
+  view.height = spanY >= spanX ? options.size : std::max<uint32_t>(1, (uint32_t)std::lround(options.size * spanY / span));
+  // Center the path; y grows upward in the machine frame and downward in the image
+  view.originX = 0.5 * (bounds.minX + bounds.maxX) - 0.5 * view.width / view.scale;
+  view.originY = 0.5 * (bounds.minY + bounds.maxY) + 0.5 * view.height / view.scale;
+  result.width = view.width;
+  result.height = view.height;
+  return true;
+}
+
+static void renderWorker(RenderRun& run) {
+  const RasterView& view = run.view;
+  std::vector<float> ink((size_t)view.width * RASTER_BAND_ROWS);
+  double radius = 0.5 * run.options.penWidth;
+  // Gray = 255 * (1 - opacity)^ink
+  double absorption = -std::log(1.0 - run.options.inkOpacity);
+  std::string error;
+
+  for (;;) {
+    size_t band;
+    {
+      std::unique_lock<std::mutex> guard(run.lock);
+      run.changed.wait(guard, [&] {
+        return run.stop || run.nextBand >= run.bands || run.nextBand < run.writtenBands + run.slots.size();
+      });
+      if (run.stop || run.nextBand >= run.bands) return;
+      band = run.nextBand++;
+    }
+
+    uint32_t firstRow = (uint32_t)band * RASTER_BAND_ROWS;
+    uint32_t rows = std::min<uint32_t>(RASTER_BAND_ROWS, view.height - firstRow);
+    std::fill(ink.begin(), ink.end(), 0.0f);
+    BandSink sink(view, radius, run.options.dwell, firstRow, rows, ink.data());
+    PathResult pathResult;
+    bool ok = generatePath(run.machine, run.path, sink, pathResult, error);
+
+    BandSlot& slot = run.slots[band % run.slots.size()];
+    float maxInk = 0;
+    for (size_t i = 0; ok && i < (size_t)rows * view.width; i++) {
+      maxInk = std::max(maxInk, ink[i]);
+      slot.pixels[i] = (uint8_t)std::lround(255.0 * std::exp(-absorption * ink[i]));
+    }
+
+    std::lock_guard<std::mutex> guard(run.lock);
+    if (!ok) {
+      if (run.error.empty()) run.error = error;
+      run.stop = true;
+    } else {
+      slot.band = band;
+      slot.ready = true;
+      run.result.bands++;
+      run.result.samples += pathResult.samples;
+      run.result.maxInk = std::max(run.result.maxInk, (double)maxInk);
+    }
+    run.changed.notify_all();
+  }
+}
+
+} // namespace cycloid
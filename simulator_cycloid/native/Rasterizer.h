@@ -0,0 +1,63 @@
+/**
+ * Rasterizer.h
+ *
+ * Renders a pen path as an anti-aliased ink-density image for large-format
+ * previews. The pen is a round nib that lays down ink as it moves: it is
+ * stamped along every segment at sub-pixel spacing, each stamp weighted by
+ * the distance it covers, so one pass deposits one unit of ink and every
+ * crossing or retrace adds more. Ink turns into gray by Beer-Lambert
+ * absorption, so dense regions darken gradually instead of clipping.
+ * With a dwell rate the nib also bleeds ink for as long as it touches the
+ * paper, so slow stretches come out darker and a pause in a step trace
+ * leaves a blot.
+ *
+ * The image is cut into bands of RASTER_BAND_ROWS rows. Each worker thread
+ * renders one band at a time by generating the whole path again and keeping
+ * only the stamps that reach its rows, and bands go to the PNG encoder in
+ * order. Memory is a few bands, whatever the path length or image size;
+ * the closed-form batch evaluator makes the repeated path cheap.
+ */
+
+#ifndef RASTERIZER_H
+#define RASTERIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "MachineModel.h"
+#include "PathGenerator.h"
+
+namespace cycloid {
+
+#define RASTER_BAND_ROWS 256
+#define RASTER_DAB_SPACING 0.25        // Pixels between pen stamps along the path
+#define RASTER_DEFAULT_SIZE 4096
+#define RASTER_DEFAULT_SAMPLES 1000000
+#define RASTER_MARGIN 0.02             // Blank border, as a fraction of the image size
+
+struct RasterOptions {
+  uint32_t size = RASTER_DEFAULT_SIZE; // Longer side in pixels; the other follows the path's aspect
+  double penWidth = 2.0;               // Nib diameter in pixels, at least 1
+  double inkOpacity = 0.5;             // Share of light absorbed by one pass, 0..1 exclusive
+  double dwell = 0;                    // Passes' worth of ink per second the nib rests on a spot
+  unsigned int threads = 0;            // 0: one per hardware thread
+};
+
+struct RasterResult {
+  uint32_t width = 0, height = 0;
+  size_t bands = 0;
+  size_t samples = 0;                  // Path samples generated, over every band
+  double maxInk = 0;                   // Most passes laid on one pixel
+  SolverStats solver;                  // Of one pass over the path
+};
+
+// Render the path of machine as an 8-bit grayscale PNG into png (opened
+// "wb"); false with a message if the path or the file fails
+bool renderPattern(const Machine& machine, const PathOptions& path, const RasterOptions& options, FILE* png,
+                   RasterResult& result, std::string& error);
+
+} // namespace cycloid
+
+#endif // RASTERIZER_H
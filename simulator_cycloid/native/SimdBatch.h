@@ -0,0 +1,184 @@
+/**
+ * SimdBatch.h
+ *
+ * BATCH_SAMPLES doubles processed as one value by the batch evaluator,
+ * held in four SIMD registers: AVX-512 (32 samples), AVX/AVX2 (16) or
+ * SSE2 (8), or eight plain doubles when none is available. Each operation
+ * of a linkage program is a long dependency chain; four independent
+ * registers keep the vector units busy where two left them waiting.
+ * The instruction set is fixed at compile time by the compiler's target
+ * flags (-mavx2, -march=native); there is no runtime dispatch.
+ *
+ * batchRsqrt() is the one operation the evaluator leans on for every
+ * length. AVX-512 has a 14-bit reciprocal square root estimate; two
+ * Newton-Raphson steps take it to full double precision, at a fraction of
+ * the cost of the sqrt and divide it replaces. Other targets divide.
+ */
+
+#ifndef SIMD_BATCH_H
+#define SIMD_BATCH_H
+
+#include <cmath>
+
+#if defined(__AVX512F__) || defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace cycloid {
+
+// --- Target Vector ---
+
+#if defined(__AVX512F__)
+
+#define SIMD_INSTRUCTION_SET "AVX-512"
+#define SIMD_WIDTH 8
+#define BATCH_SAMPLES 32
+typedef __m512d SimdVector;
+inline SimdVector simdSet(double value) { return _mm512_set1_pd(value); }
+inline SimdVector simdLoad(const double* p) { return _mm512_loadu_pd(p); }
+inline void simdStore(double* p, SimdVector v) { _mm512_storeu_pd(p, v); }
+inline SimdVector simdAdd(SimdVector a, SimdVector b) { return _mm512_add_pd(a, b); }
+inline SimdVector simdSub(SimdVector a, SimdVector b) { return _mm512_sub_pd(a, b); }
+inline SimdVector simdMul(SimdVector a, SimdVector b) { return _mm512_mul_pd(a, b); }
+inline SimdVector simdDiv(SimdVector a, SimdVector b) { return _mm512_div_pd(a, b); }
+inline SimdVector simdSqrt(SimdVector a) { return _mm512_sqrt_pd(a); }
+inline SimdVector simdRsqrtEstimate(SimdVector a) { return _mm512_rsqrt14_pd(a); }
+#define SIMD_RSQRT_STEPS 2   // Newton-Raphson steps after the 14-bit estimate
+inline SimdVector simdMax(SimdVector a, SimdVector b) { return _mm512_max_pd(a, b); }
+inline bool simdAnyNotLess(SimdVector a, SimdVector b) { return _mm512_cmp_pd_mask(a, b, _CMP_NLT_UQ) != 0; }
+
+#elif defined(__AVX__)
+
+#define SIMD_INSTRUCTION_SET "AVX"
+#define SIMD_WIDTH 4
+#define BATCH_SAMPLES 16
+typedef __m256d SimdVector;
+inline SimdVector simdSet(double value) { return _mm256_set1_pd(value); }
+inline SimdVector simdLoad(const double* p) { return _mm256_loadu_pd(p); }
+inline void simdStore(double* p, SimdVector v) { _mm256_storeu_pd(p, v); }
+inline SimdVector simdAdd(SimdVector a, SimdVector b) { return _mm256_add_pd(a, b); }
+inline SimdVector simdSub(SimdVector a, SimdVector b) { return _mm256_sub_pd(a, b); }
+inline SimdVector simdMul(SimdVector a, SimdVector b) { return _mm256_mul_pd(a, b); }
+inline SimdVector simdDiv(SimdVector a, SimdVector b) { return _mm256_div_pd(a, b); }
+inline SimdVector simdSqrt(SimdVector a) { return _mm256_sqrt_pd(a); }
+inline SimdVector simdMax(SimdVector a, SimdVector b) { return _mm256_max_pd(a, b); }
+inline bool simdAnyNotLess(SimdVector a, SimdVector b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_NLT_UQ)) != 0; }
+
+#elif defined(__SSE2__)
+
+#define SIMD_INSTRUCTION_SET "SSE2"
+#define SIMD_WIDTH 2
+#define BATCH_SAMPLES 8
+typedef __m128d SimdVector;
+inline SimdVector simdSet(double value) { return _mm_set1_pd(value); }
+inline SimdVector simdLoad(const double* p) { return _mm_loadu_pd(p); }
+inline void simdStore(double* p, SimdVector v) { _mm_storeu_pd(p, v); }
+inline SimdVector simdAdd(SimdVector a, SimdVector b) { return _mm_add_pd(a, b); }
+inline SimdVector simdSub(SimdVector a, SimdVector b) { return _mm_sub_pd(a, b); }
+inline SimdVector simdMul(SimdVector a, SimdVector b) { return _mm_mul_pd(a, b); }
+inline SimdVector simdDiv(SimdVector a, SimdVector b) { return _mm_div_pd(a, b); }
+inline SimdVector simdSqrt(SimdVector a) { return _mm_sqrt_pd(a); }
+inline SimdVector simdMax(SimdVector a, SimdVector b) { return _mm_max_pd(a, b); }
+inline bool simdAnyNotLess(SimdVector a, SimdVector b) { return _mm_movemask_pd(_mm_cmpnlt_pd(a, b)) != 0; }
+
+#else
+
+#define SIMD_INSTRUCTION_SET "scalar"
+#define SIMD_WIDTH 1
+#define BATCH_SAMPLES 8
+typedef double SimdVector;
+inline SimdVector simdSet(double value) { return value; }
+inline SimdVector simdLoad(const double* p) { return *p; }
+inline void simdStore(double* p, SimdVector v) { *p = v; }
+inline SimdVector simdAdd(SimdVector a, SimdVector b) { return a + b; }
+inline SimdVector simdSub(SimdVector a, SimdVector b) { return a - b; }
+inline SimdVector simdMul(SimdVector a, SimdVector b) { return a * b; }
+inline SimdVector simdDiv(SimdVector a, SimdVector b) { return a / b; }
+inline SimdVector simdSqrt(SimdVector a) { return std::sqrt(a); }
+inline SimdVector simdMax(SimdVector a, SimdVector b) { return a > b ? a : b; }
+inline bool simdAnyNotLess(SimdVector a, SimdVector b) { return !(a < b); }
+
+#endif
+
+#define BATCH_VECTORS (BATCH_SAMPLES / SIMD_WIDTH)
+
+// Lane-vector loops are short and fixed; unroll them even at -O2
+#if defined(__GNUC__) && !defined(__clang__)
+#define BATCH_UNROLL _Pragma("GCC unroll 8")
+#else
+#define BATCH_UNROLL
+#endif
+
+// --- Batch ---
+
+struct Batch {
+  SimdVector v[BATCH_VECTORS];
+
+  static Batch set(double value) {
+    Batch b;
+    BATCH_UNROLL for (int i = 0; i < BATCH_VECTORS; i++) b.v[i] = simdSet(value);
+    return b;
+  }
+  static Batch load(const double* p) {
+    Batch b;
+    BATCH_UNROLL for (int i = 0; i < BATCH_VECTORS; i++) b.v[i] = simdLoad(p + i * SIMD_WIDTH);
+    return b;
+  }
+  void store(double* p) const {
+    BATCH_UNROLL for (int i = 0; i < BATCH_VECTORS; i++) simdStore(p + i * SIMD_WIDTH, v[i]);
+  }
+};
+
+#define BATCH_BINARY(name, op)                                                         \
+  inline Batch name(const Batch& a, const Batch& b) {                                  \
+    Batch r;                                                                           \
+    BATCH_UNROLL for (int i = 0; i < BATCH_VECTORS; i++) r.v[i] = op(a.v[i], b.v[i]); \
+    return r;                                                                          \
+  }
+
+BATCH_BINARY(operator+, simdAdd)
+BATCH_BINARY(operator-, simdSub)
+BATCH_BINARY(operator*, simdMul)
+BATCH_BINARY(operator/, simdDiv)
+BATCH_BINARY(batchMax, simdMax)
+
+#undef BATCH_BINARY
+
+inline Batch batchSqrt(const Batch& a) {
+  Batch r;
+  BATCH_UNROLL for (int i = 0; i < BATCH_VECTORS; i++) r.v[i] = simdSqrt(a.v[i]);
+  return r;
+}
+
+// 1 / sqrt(a) for positive a
+inline Batch batchRsqrt(const Batch& a) {
+  Batch r;
+#ifdef SIMD_RSQRT_STEPS
+  const SimdVector half = simdSet(0.5), threeHalves = simdSet(1.5);
+  BATCH_UNROLL for (int i = 0; i < BATCH_VECTORS; i++) {
+    SimdVector y = simdRsqrtEstimate(a.v[i]);
+    SimdVector halfA = simdMul(half, a.v[i]);
+    BATCH_UNROLL for (int step = 0; step < SIMD_RSQRT_STEPS; step++) {
+      y = simdMul(y, simdSub(threeHalves, simdMul(halfA, simdMul(y, y))));
+    }
+    r.v[i] = y;
+  }
+#else
+  BATCH_UNROLL for (int i = 0; i < BATCH_VECTORS; i++) r.v[i] = simdDiv(simdSet(1.0), simdSqrt(a.v[i]));
+#endif
+  return r;
+}
+
+inline Batch batchAbs(const Batch& a) { return batchMax(a, Batch::set(0) - a); }
+
+// True if any lane of a is not below limit (NaN included)
+inline bool batchAnyNotLess(const Batch& a, double limit) {
+  SimdVector bound = simdSet(limit);
+  bool any = false;
+  BATCH_UNROLL for (int i = 0; i < BATCH_VECTORS; i++) any = any || simdAnyNotLess(a.v[i], bound);
+  return any;
+}
+
+} // namespace cycloid
+
+#endif // SIMD_BATCH_H
@@ -0,0 +1,122 @@
+/**
+ * StepTrace.cpp
+ *
+ * Implements step trace loading and wheel angle lookup
+ */
+
+#include "StepTrace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace cycloid {
+
+#define TRACE_READ_BYTES (1 << 20)
+
+// --- Forward Declarations for Static Functions ---
+static bool parseRow(const char* line, double& timeMicros, long long* positions, int& count);
+
+bool StepTrace::load(const std::string& path, double gearRatio, std::string& error) {
+  motors = 0;
+  times.clear();
+  angles.clear();
+  if (!(gearRatio > 0)) {
+    error = "gear ratio must be positive";
+    return false;
+  }
+
+  FILE* file = fopen(path.c_str(), "r");
+  if (!file) {
+    error = "cannot open " + path + ": " + strerror(errno);
+    return false;
+  }
+  std::vector<char> line(TRACE_READ_BYTES);
+  long microstep = 1;
+  double firstMicros = 0, lastMicros = 0, wrapMicros = 0;   // lastMicros as read, before unwrapping
+  size_t lineNumber = 0;
+  long long positions[TRACE_MAX_MOTORS];
+  bool ok = true;
+
+  while (ok && fgets(line.data(), (int)line.size(), file)) {
+    lineNumber++;
+    const char* text = line.data();
+    while (*text == ' ' || *text == '\t') text++;
+    if (*text == '#' || *text == '\n' || *text == '\r' || *text == '\0') continue;
+    std::string where = path + ":" + std::to_string(lineNumber) + ": ";
+
+    if (strncmp(text, "microstep", 9) == 0) {
+      char* end;
+      microstep = strtol(text + 9, &end, 10);
+      while (*end == ' ' || *end == '\r' || *end == '\n') end++;
+      if (microstep < 1 || microstep > 128 || (microstep & (microstep - 1)) || *end != '\0') {
+        error = where + "invalid microstep mode";
+        ok = false;
+      }
+      continue;
+    }
+    // A header row such as "t_us,m1,m2" before the first snapshot
+    if (times.empty() && isalpha((unsigned char)*text)) continue;
+
+    double micros;
+    int count;
+    if (!parseRow(text, micros, positions, count)) {
+      error = where + "expected <time_us>,<position>,... with at most " + std::to_string(TRACE_MAX_MOTORS) + " motors";
+      ok = false;
+    } else if (motors != 0 && count != motors) {
+      error = where + std::to_string(count) + " positions, expected " + std::to_string(motors);
+      ok = false;
+    } else if (!times.empty() && micros < lastMicros && lastMicros - micros <= TRACE_MICROS_RANGE / 2) {
+      error = where + "time goes backwards";
+      ok = false;
+    } else {
+      if (times.empty()) firstMicros = micros;
+      // Anything else that drops is micros() wrapping
+      if (!times.empty() && micros < lastMicros) wrapMicros += TRACE_MICROS_RANGE;
+      motors = count;
+      lastMicros = micros;
+      times.push_back((micros + wrapMicros - firstMicros) * 1e-6);
+      double stepAngle = 2.0 * M_PI / (TRACE_STEPS_PER_MOTOR_REV * (double)microstep * gearRatio);
+      for (int m = 0; m < count; m++) angles.push_back(stepAngle * (double)positions[m]);
+    }
+  }
+  fclose(file);
+
+  if (ok && times.empty()) {
+    error = path + ": no step rows";
+    ok = false;
+  }
+  return ok;
+}
+
+double StepTrace::angle(int motor, double t) const {
+  return angles[rowAt(t) * motors + motor];
+}
+
+// --- Internal Helpers ---
+
+size_t StepTrace::rowAt(double t) const {
+  size_t row = std::upper_bound(times.begin(), times.end(), t) - times.begin();
+  return row == 0 ? 0 : row - 1;
+}
+
+// "<time>,<p1>,...,<pn>"; false on anything else
+static bool parseRow(const char* line, double& timeMicros, long long* positions, int& count) {
+  char* end;
+  timeMicros = strtod(line, &end);
+  if (end == line || !std::isfinite(timeMicros)) return false;
+  count = 0;
+  while (*end == ',') {
+    if (count == TRACE_MAX_MOTORS) return false;
+    const char* start = end + 1;
+    positions[count++] = strtoll(start, &end, 10);
+    if (end == start) return false;
+  }
+  while (*end == ' ' || *end == '\r' || *end == '\n') end++;
+  return count > 0 && *end == '\0';
+}
+
+} // namespace cycloid
@@ -0,0 +1,69 @@
+/**
+ * StepTrace.h
+ *
+ * Motor step positions recorded from the firmware (a host build or a
+ * capture from the machine), used to drive the linkage with what the
+ * motors actually did instead of ideal wheel speeds. Ramps, pauses, LFO
+ * updates every LFO_UPDATE_INTERVAL and AccelStepper's whole-microsecond
+ * step intervals all show up in the drawing.
+ *
+ * The trace is a text file, one row per snapshot of the step counters:
+ *
+ *   # comment
+ *   microstep 16
+ *   <time_us>,<motor 1 position>,<motor 2 position>,...
+ *
+ * Times are micros() and must not decrease, except where the 32-bit
+ * counter wraps (every 71.6 minutes): a drop of more than half its range
+ * is read as a wrap and unwrapped by adding TRACE_MICROS_RANGE, so a long
+ * capture can start at any time after boot. Positions are
+ * AccelStepper::currentPosition() in the microstep mode set by the last
+ * "microstep" line (the firmware rescales positions when the mode
+ * changes). A motor turns its wheel by
+ *
+ *   position / (getStepsPerWheelRev() * GEAR_RATIO)
+ *
+ * revolutions, where getStepsPerWheelRev() = STEPS_PER_MOTOR_REV * microstep
+ * counts motor steps and the belt reduces them by GEAR_RATIO. Between rows
+ * the wheels hold their angle, as a stepper does between steps.
+ */
+
+#ifndef STEP_TRACE_H
+#define STEP_TRACE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cycloid {
+
+#define TRACE_STEPS_PER_MOTOR_REV 200   // As STEPS_PER_MOTOR_REV in the firmware's Config.h
+#define TRACE_GEAR_RATIO 3              // As GEAR_RATIO
+#define TRACE_MAX_MOTORS 4              // As MOTORS_COUNT
+#define TRACE_MICROS_RANGE 4294967296.0 // micros() is an unsigned long and wraps at 2^32
+
+class StepTrace {
+ public:
+  // Parse a trace file; false with a message naming the line on any error
+  bool load(const std::string& path, double gearRatio, std::string& error);
+
+  size_t rowCount() const { return times.size(); }
+  int motorCount() const { return motors; }
+  double duration() const { return times.empty() ? 0 : times.back(); }
+  const std::vector<double>& rowTimes() const { return times; }   // Seconds from the first row
+
+  // Wheel angle (radians) driven by motor at time t: the last row at or
+  // before t, or the first row before the trace starts
+  double angle(int motor, double t) const;
+
+ private:
+  size_t rowAt(double t) const;
+
+  int motors = 0;
+  std::vector<double> times;
+  std::vector<double> angles;   // rowCount() x motors
+};
+
+} // namespace cycloid
+
+#endif // STEP_TRACE_H
@@ -0,0 +1,105 @@
+/**
+ * SvgExporter.cpp
+ *
+ * Implements chunked SVG polyline output for simplified pen paths
+ */
+
+#include "SvgExporter.h"
+
+#include "PathSimplifier.h"
+
+namespace cycloid {
+
+namespace {
+
+// Polylines of at most limit vertices, y flipped so the drawing is not
+// mirrored (SVG y grows downward)
+class SvgPolylineWriter : public VertexSink {
+ public:
+  SvgPolylineWriter(FILE* file, double left, double top, size_t limit)
+      : file(file), left(left), top(top), limit(limit) {}
+
+  bool vertex(double x, double y) override {
+    x -= left;
+    y = top - y;
+    if (limit > 0 && count == limit) {
+      closePolyline();
+      // The next chunk starts where this one ended
+      openPolyline();
+      fprintf(file, "%.3f,%.3f", lastX, lastY);
+      count = 1;
+    }
+    if (count == 0) {
+      openPolyline();
+    } else {
+      fputc(' ', file);
+    }
+    fprintf(file, "%.3f,%.3f", x, y);
+    lastX = x;
+    lastY = y;
+    count++;
+    return !ferror(file);
+  }
+
+  void finish() {
+    if (count > 0) closePolyline();
+    count = 0;
+  }
+
+  size_t polylines = 0;
+
+ private:
+  void openPolyline() {
+    fputs("<polyline points=\"", file);
+    polylines++;
+  }
+  void closePolyline() { fputs("\"/>\n", file); }
+
+  FILE* file;
+  double left, top;
+  size_t limit;
+  size_t count = 0;    // Vertices in the open polyline
+  double lastX = 0, lastY = 0;
+};
+
+}  // namespace
+
+bool exportSvg(const Machine& machine, const PathOptions& path, const SvgOptions& options, FILE* file,
+               SvgResult& result, std::string& error) {
+  result = SvgResult();
+  if (!(options.tolerance >= 0) || options.chunkVertices == 1) {
+    error = "need a non-negative tolerance and at least 2 vertices per chunk";
+    return false;
+  }
+
+  BoundsSink bounds;
+  PathResult pathResult;
+  if (!generatePath(machine, path, bounds, pathResult, error)) return false;
+  double left = bounds.minX - SVG_MARGIN, top = bounds.maxY + SVG_MARGIN;
+  double width = bounds.maxX - bounds.minX + 2 * SVG_MARGIN, height = bounds.maxY - bounds.minY + 2 * SVG_MARGIN;
+
+  fprintf(file,
+          "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+          "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%.3fmm\" height=\"%.3fmm\" viewBox=\"0 0 %.3f %.3f\">\n"
+          "<g fill=\"none\" stroke=\"black\" stroke-width=\"%.3f\" stroke-linecap=\"round\" stroke-linejoin=\"round\">\n",
+          width, height, width, height, options.strokeWidth);
+
+  SvgPolylineWriter writer(file, left, top, options.chunkVertices);
+  PathSimplifier simplifier(options.tolerance, writer);
+  if (!generatePath(machine, path, simplifier, pathResult, error)) return false;
+  simplifier.finish();
+  writer.finish();
+  fputs("</g>\n</svg>\n", file);
+
+  result.samples = simplifier.inputCount();
+  result.vertices = simplifier.outputCount();
+  result.polylines = writer.polylines;
+  result.solver = pathResult.solver;
+  if (ferror(file)) {
+    error = "error writing SVG";
+    return false;
+  }
+  return true;
+}
+
+} // namespace cycloid
@@ -0,0 +1,50 @@
+/**
+ * SvgExporter.h
+ *
+ * Writes a pen path as a plotter-ready SVG: the path is simplified by
+ * PathSimplifier as it streams out of the solver and written as polylines
+ * of at most chunkVertices vertices each, so a plotter driver with a
+ * limited command buffer can take one chunk at a time. Consecutive chunks
+ * share their joining vertex, so the pen draws one unbroken line.
+ *
+ * Drawing units are millimetres, as on the simulator canvas. A first pass
+ * over the path finds its bounds for the viewBox; nothing but the current
+ * simplification window is held in memory.
+ */
+
+#ifndef SVG_EXPORTER_H
+#define SVG_EXPORTER_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include "MachineModel.h"
+#include "PathGenerator.h"
+
+namespace cycloid {
+
+#define SVG_DEFAULT_TOLERANCE 0.02   // mm; well under a plotter pen's line width
+#define SVG_DEFAULT_SAMPLES 1000000
+#define SVG_MARGIN 5.0               // mm of blank paper around the drawing
+
+struct SvgOptions {
+  double tolerance = SVG_DEFAULT_TOLERANCE;
+  size_t chunkVertices = 0;          // 0: one polyline
+  double strokeWidth = 0.3;          // mm
+};
+
+struct SvgResult {
+  size_t samples = 0;                // Path samples simplified (the bounds pass is not counted)
+  size_t vertices = 0;               // Vertices written
+  size_t polylines = 0;
+  SolverStats solver;
+};
+
+// Write the SVG to file; false with a message if the path or the file fails
+bool exportSvg(const Machine& machine, const PathOptions& path, const SvgOptions& options, FILE* file,
+               SvgResult& result, std::string& error);
+
+} // namespace cycloid
+
+#endif // SVG_EXPORTER_H
@@ -0,0 +1,245 @@
+/**
+ * XmlDocument.cpp
+ *
+ * Recursive-descent XML reader. Not validating: DTDs and processing
+ * instructions are skipped, namespaces are kept as part of the name.
+ */
+
+#include "XmlDocument.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace cycloid {
+
+// --- Node Accessors ---
+
+const XmlNode* XmlNode::child(const char* childName) const {
+  for (const XmlNode& node : children) {
+    if (node.name == childName) return &node;
+  }
+  return nullptr;
+}
+
+std::vector<const XmlNode*> XmlNode::childrenNamed(const char* childName) const {
+  std::vector<const XmlNode*> result;
+  for (const XmlNode& node : children) {
+    if (node.name == childName) result.push_back(&node);
+  }
+  return result;
+}
+
+bool XmlNode::hasAttribute(const char* attributeName) const {
+  for (const auto& attr : attributes) {
+    if (attr.first == attributeName) return true;
+  }
+  return false;
+}
+
+std::string XmlNode::attribute(const char* attributeName, const char* fallback) const {
+  for (const auto& attr : attributes) {
+    if (attr.first == attributeName) return attr.second;
+  }
+  return fallback;
+}
+
+std::string XmlNode::childText(const char* childName, const char* fallback) const {
+  const XmlNode* node = child(childName);
+  return node ? node->text : std::string(fallback);
+}
+
+// --- Parser ---
+
+namespace {
+
+struct Parser {
+  const std::string& src;
+  size_t pos = 0;
+  std::string error;
+
+  explicit Parser(const std::string& source) : src(source) {}
+
+  bool atEnd() const { return pos >= src.size(); }
+  bool startsWith(const char* token) const { return src.compare(pos, strlen(token), token) == 0; }
+
+  int lineNumber() const {
+    int line = 1;
+    for (size_t i = 0; i < pos && i < src.size(); i++) {
+      if (src[i] == '\n') line++;
+    }
+    return line;
+  }
+
+  bool fail(const std::string& reason) {
+    if (error.empty()) error = "line " + std::to_string(lineNumber()) + ": " + reason;
+    return false;
+  }
+
+  void skipWhitespace() {
+    while (!atEnd() && isspace((unsigned char)src[pos])) pos++;
+  }
+
+  // Skip "<?...?>", "<!--...-->" and "<!...>" constructs
+  bool skipMarkup() {
+    const char* terminator;
+    if (startsWith("<?")) terminator = "?>";
+    else if (startsWith("<!--")) terminator = "-->";
+    else if (startsWith("<!")) terminator = ">";
+    else return false;
+    size_t end = src.find(terminator, pos + 2);
+    pos = (end == std::string::npos) ? src.size() : end + strlen(terminator);
+    return true;
+  }
+
+  static bool isNameChar(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '-' || c == '.' || c == ':';
+  }
+
+  bool readName(std::string& name) {
+    size_t start = pos;
+    while (!atEnd() && isNameChar(src[pos])) pos++;
+    if (pos == start) return fail("expected a name");
+    name.assign(src, start, pos - start);
+    return true;
+  }
+
+  bool decodeEntities(const std::string& raw, std::string& out) {
+    out.clear();
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); i++) {
+      if (raw[i] != '&') { out += raw[i]; continue; }
+      size_t semi = raw.find(';', i);
+      if (semi == std::string::npos) return fail("unterminated entity");
+      std::string entity = raw.substr(i + 1, semi - i - 1);
+      if (entity == "lt") out += '<';
+      else if (entity == "gt") out += '>';
+      else if (entity == "amp") out += '&';
+      else if (entity == "quot") out += '"';
+      else if (entity == "apos") out += '\'';
+      else if (!entity.empty() && entity[0] == '#') {
+        long code = (entity.size() > 1 && entity[1] == 'x') ? strtol(entity.c_str() + 2, nullptr, 16)
+                                                             : strtol(entity.c_str() + 1, nullptr, 10);
+        if (code <= 0 || code > 0x7F) return fail("unsupported character reference &" + entity + ";");
+        out += (char)code;
+      } else {
+        return fail("unknown entity &" + entity + ";");
+      }
+      i = semi;
+    }
+    return true;
+  }
+
+  bool parseAttributes(XmlNode& node, bool& selfClosing) {
+    selfClosing = false;
+    while (true) {
+      skipWhitespace();
+      if (atEnd()) return fail("unterminated start tag <" + node.name + ">");
+      if (startsWith("/>")) { pos += 2; selfClosing = true; return true; }
+      if (src[pos] == '>') { pos++; return true; }
+
+      std::string name;
+      if (!readName(name)) return false;
+      skipWhitespace();
+      if (atEnd() || src[pos] != '=') return fail("expected '=' after attribute " + name);
+      pos++;
+      skipWhitespace();
+      if (atEnd() || (src[pos] != '"' && src[pos] != '\'')) return fail("expected quoted value for " + name);
+      char quote = src[pos++];
+      size_t end = src.find(quote, pos);
+      if (end == std::string::npos) return fail("unterminated value for " + name);
+      std::string value;
+      if (!decodeEntities(src.substr(pos, end - pos), value)) return false;
+      node.attributes.emplace_back(name, value);
+      pos = end + 1;
+    }
+  }
+
+  bool parseElement(XmlNode& node) {
+    pos++; // '<'
+    if (!readName(node.name)) return false;
+    bool selfClosing;
+    if (!parseAttributes(node, selfClosing)) return false;
+    if (selfClosing) return true;
+
+    std::string rawText;
+    while (true) {
+      if (atEnd()) return fail("missing </" + node.name + ">");
+      if (startsWith("</")) {
+        pos += 2;
+        std::string closing;
+        if (!readName(closing)) return false;
+        if (closing != node.name) return fail("</" + closing + "> closes <" + node.name + ">");
+        skipWhitespace();
+        if (atEnd() || src[pos] != '>') return fail("malformed end tag </" + closing + ">");
+        pos++;
+        break;
+      }
+      if (startsWith("<![CDATA[")) {
+        size_t end = src.find("]]>", pos);
+        if (end == std::string::npos) return fail("unterminated CDATA section");
+        rawText.append(src, pos + 9, end - pos - 9);
+        pos = end + 3;
+        continue;
+      }
+      if (skipMarkup()) continue;
+      if (src[pos] == '<') {
+        node.children.emplace_back();
+        if (!parseElement(node.children.back())) return false;
+        continue;
+      }
+      size_t next = src.find('<', pos);
+      if (next == std::string::npos) next = src.size();
+      rawText.append(src, pos, next - pos);
+      pos = next;
+    }
+
+    if (!decodeEntities(rawText, node.text)) return false;
+    size_t first = node.text.find_first_not_of(" \t\r\n");
+    size_t last = node.text.find_last_not_of(" \t\r\n");
+    node.text = (first == std::string::npos) ? std::string() : node.text.substr(first, last - first + 1);
+    return true;
+  }
+
+  bool parseDocument(XmlNode& root) {
+    while (true) {
+      skipWhitespace();
+      if (atEnd()) return fail("no root element");
+      if (!skipMarkup()) break;
+    }
+    if (src[pos] != '<') return fail("expected '<'");
+    if (!parseElement(root)) return false;
+    while (true) {
+      skipWhitespace();
+      if (atEnd()) return true;
+      if (!skipMarkup()) return fail("content after the root element");
+    }
+  }
+};
+
+} // namespace
+
+bool parseXml(const std::string& source, XmlNode& root, std::string& error) {
+  Parser parser(source);
+  root = XmlNode();
+  if (parser.parseDocument(root)) return true;
+  error = parser.error;
+  return false;
+}
+
+bool parseXmlFile(const std::string& path, XmlNode& root, std::string& error) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    error = "cannot open " + path;
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  if (!parseXml(buffer.str(), root, error)) {
+    error = path + ": " + error;
+    return false;
+  }
+  return true;
+}
+
+} // namespace cycloid
@@ -0,0 +1,41 @@
+/**
+ * XmlDocument.h
+ *
+ * Minimal XML reader for the simulator's machine configuration files.
+ * Handles elements, attributes, text, comments, the XML declaration and
+ * the five predefined entities - everything config_writer.py emits.
+ */
+
+#ifndef XML_DOCUMENT_H
+#define XML_DOCUMENT_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cycloid {
+
+struct XmlNode {
+  std::string name;
+  std::vector<std::pair<std::string, std::string>> attributes;
+  std::vector<XmlNode> children;
+  std::string text;   // Concatenated character data, whitespace-trimmed
+
+  // First child element with this name, or nullptr
+  const XmlNode* child(const char* childName) const;
+  // All child elements with this name, in document order
+  std::vector<const XmlNode*> childrenNamed(const char* childName) const;
+
+  bool hasAttribute(const char* attributeName) const;
+  std::string attribute(const char* attributeName, const char* fallback = "") const;
+  // Text of the named child element, or fallback if it is missing
+  std::string childText(const char* childName, const char* fallback = "") const;
+};
+
+// Parse a whole document; on failure error holds "line N: reason"
+bool parseXml(const std::string& source, XmlNode& root, std::string& error);
+bool parseXmlFile(const std::string& path, XmlNode& root, std::string& error);
+
+} // namespace cycloid
+
+#endif // XML_DOCUMENT_H
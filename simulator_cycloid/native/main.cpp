@@ -0,0 +1,912 @@
+/**
+ * main.cpp
+ *
+ * Command-line front end for the native cycloid simulator.
+ *
+ *   cycloid_sim solve <machine.xml> [options]   Pen path as CSV (t,x,y); exits
+ *                                               with 2 if any sample failed
+ *   cycloid_sim compile <machine.xml>           Print the compiled linkage program
+ *   cycloid_sim check <machine.xml> [options]   Compare the compiled program with
+ *                                               whole-machine Newton
+ *   cycloid_sim bench <machine.xml> [options]   Solver throughput, no output
+ *   cycloid_sim sweep <machine.xml> [options]   Metrics for every combination of
+ *                                               --sweep ranges as CSV
+ *   cycloid_sim render <machine.xml> --out <png> [options]
+ *                                               Ink-density preview as PNG
+ *   cycloid_sim export <machine.xml> [options]  Simplified plotter SVG
+ *   cycloid_sim convert <machine.xml> --out <image>
+ *                                               Compile the XML to a binary
+ *                                               machine image (MachineImage.h)
+ *   cycloid_sim validate <machine.xml> [--image <file>]
+ *                                               Check that the image (by default
+ *                                               one built in memory) loads back
+ *                                               as the XML does
+ *
+ * Every command takes a machine image in place of the XML.
+ *
+ * Common options:
+ *   --duration <s>        Machine time to simulate (default 60)
+ *   --samples <n>         Evenly spaced samples (default 60 per second)
+ *   --max-deviation <mm>  Sample adaptively instead, keeping the chord
+ *                         between samples this close to the pen; --samples
+ *                         is then ignored
+ *   --ratio <id>=<r>      Turn wheel <id> at r revolutions per second
+ *   --rate <id>=<rad/s>   Turn wheel <id> at a fixed angular rate
+ *   --master-time <ms>    Period of one revolution at ratio 1.0
+ *   --lfo-depth <id>=<%>  LFO depth of wheel <id>, as on the machine
+ *   --lfo-rate <id>=<Hz>  LFO rate of wheel <id>
+ *   --lfo-bipolar <id>=<0|1>
+ *   --solver <name>       compiled (default) or newton
+ *   --out <file>          Write output here instead of stdout
+ *   --trace <file>        Turn the wheels by a recorded step trace (see
+ *                         StepTrace.h), sampled at its rows; --duration
+ *                         and --samples are then ignored
+ *   --motor <k>=<id>      Trace motor k (from 1) turns wheel <id>; default:
+ *                         motor k turns the k-th wheel in the XML
+ *   --gear-ratio <r>      Motor turns per wheel turn (default 3)
+ *
+ * Sweep options:
+ *   --sweep <parameter>[:<id>]=<from>:<to>:<steps>   Repeatable; parameter
+ *                         is ratio, master-time, lfo-depth or lfo-rate
+ *   --threads <n>         Worker threads (default: all hardware threads)
+ *   --thumbs <dir>        Write a PGM thumbnail per candidate into <dir>
+ *   --thumb-size <px>     Thumbnail size (default 64)
+ *
+ * Render options:
+ *   --size <px>           Longer image side (default 4096)
+ *   --pen-width <px>      Nib diameter (default 2)
+ *   --ink <opacity>       Share of light one pass absorbs (default 0.5)
+ *   --dwell <passes/s>    Ink the resting nib bleeds per second (default 0)
+ *   --threads <n>         Worker threads (default: all hardware threads)
+ *
+ * Export options:
+ *   --tolerance <mm>      Largest distance of a dropped sample (default 0.02)
+ *   --chunk <n>           At most n vertices per polyline (default: no limit)
+ *   --stroke <mm>         Stroke width (default 0.3)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BatchEvaluator.h"
+#include "CompiledLinkage.h"
+#include "MachineImage.h"
+#include "MachineModel.h"
+#include "ParameterSweep.h"
+#include "PathGenerator.h"
+#include "PathSimplifier.h"
+#include "Rasterizer.h"
+#include "StepTrace.h"
+#include "SvgExporter.h"
+
+using namespace cycloid;
+
+#define BENCH_DEFAULT_SAMPLES 10000000
+#define BENCH_NEWTON_SAMPLES 100000      // Whole-machine Newton is benchmarked on fewer samples
+#define BENCH_COMPARE_SAMPLES 1000000    // Batch results checked against scalar ones
+#define CHECK_TOLERANCE 1e-6             // Pen distance between the solvers, relative to the longest rod
+
+// --- Option Parsing ---
+
+struct CommonOptions {
+  std::string machinePath;
+  std::string outPath;
+  PathOptions path;
+  bool samplesGiven = false;
+  std::vector<std::pair<int, double>> ratios;
+  std::vector<std::pair<int, double>> rates;
+  double masterTime = 0;                           // 0: as in the XML
+  std::vector<std::pair<int, double>> lfoDepths, lfoRates, lfoBipolar;
+  std::string tracePath;
+  std::vector<std::pair<int, double>> traceMotors;  // Motor number, wheel id
+  double gearRatio = TRACE_GEAR_RATIO;
+  std::vector<std::pair<std::string, std::string>> extra;   // Command-specific options
+};
+
+static void printUsage() {
+  fprintf(stderr,
+          "Usage: cycloid_sim <command> <machine.xml> [options]\n"
+          "\n"
+          "Commands:\n"
+          "  solve      Pen path as CSV (t,x,y); exit status 2 if any sample failed\n"
+          "  compile    Print the compiled linkage program\n"
+          "  check      Compare the compiled program with whole-machine Newton\n"
+          "  bench      Solver throughput without output (default 10M samples)\n"
+          "  sweep      Metrics for every combination of --sweep ranges as CSV\n"
+          "  render     Ink-density preview as PNG (needs --out)\n"
+          "  export     Simplified plotter SVG\n"
+          "  convert    Compile the XML to a binary machine image (needs --out)\n"
+          "  validate   Check a machine image against the XML (--image <file>, or\n"
+          "             one built in memory)\n"
+          "\n"
+          "Every command takes a machine image in place of the XML.\n"
+          "\n"
+          "Options:\n"
+          "  --duration <s>        Machine time to simulate (default 60)\n"
+          "  --samples <n>         Evenly spaced samples (default 60 per second)\n"
+          "  --max-deviation <mm>  Sample adaptively, keeping the chord between samples\n"
+          "                        this close to the pen (--samples is then ignored)\n"
+          "  --ratio <id>=<r>      Turn wheel <id> at r revolutions per second\n"
+          "  --rate <id>=<rad/s>   Turn wheel <id> at a fixed angular rate\n"
+          "  --master-time <ms>    Period of one revolution at ratio 1.0\n"
+          "  --lfo-depth <id>=<%%>  LFO depth of wheel <id>, as on the machine\n"
+          "  --lfo-rate <id>=<Hz>  LFO rate of wheel <id>\n"
+          "  --lfo-bipolar <id>=<0|1>\n"
+          "  --solver <name>       compiled (default) or newton\n"
+          "  --out <file>          Write output here instead of stdout\n"
+          "  --trace <file>        Turn the wheels by a recorded step trace, sampled at\n"
+          "                        its rows (--duration and --samples are ignored)\n"
+          "  --motor <k>=<id>      Trace motor k (from 1) turns wheel <id> (default: the\n"
+          "                        k-th wheel in the XML)\n"
+          "  --gear-ratio <r>      Motor turns per wheel turn (default 3)\n"
+          "\n"
+          "Sweep options (--samples is per candidate, default 4096; --duration caps\n"
+          "each candidate's closure period):\n"
+          "  --sweep <parameter>[:<id>]=<from>:<to>:<steps>\n"
+          "                        Repeatable; ratio, master-time, lfo-depth, lfo-rate\n"
+          "  --threads <n>         Worker threads (default: all hardware threads)\n"
+          "  --thumbs <dir>        Write a PGM thumbnail per candidate into <dir>\n"
+          "  --thumb-size <px>     Thumbnail size (default 64)\n"
+          "\n"
+          "Render options (--samples defaults to 1000000):\n"
+          "  --size <px>           Longer image side (default 4096)\n"
+          "  --pen-width <px>      Nib diameter (default 2)\n"
+          "  --ink <opacity>       Share of light one pass absorbs (default 0.5)\n"
+          "  --dwell <passes/s>    Ink the resting nib bleeds per second (default 0)\n"
+          "  --threads <n>         Worker threads (default: all hardware threads)\n"
+          "\n"
+          "Export options (--samples defaults to 1000000):\n"
+          "  --tolerance <mm>      Largest distance of a dropped sample (default 0.02)\n"
+          "  --chunk <n>           At most n vertices per polyline (default: no limit)\n"
+          "  --stroke <mm>         Stroke width (default 0.3)\n");
+}
+
+static bool parseDouble(const char* text, double& value) {
+  char* end;
+  value = strtod(text, &end);
+  return end != text && *end == '\0';
+}
+
+static bool isExtraOption(const char* arg, const char* const* extraNames) {
+  for (; extraNames && *extraNames; extraNames++) {
+    if (strcmp(arg, *extraNames) == 0) return true;
+  }
+  return false;
+}
+
+// "<id>=<value>" as used by --ratio, --rate, --motor and the --lfo options
+static bool parseAssignment(const char* text, std::pair<int, double>& assignment) {
+  const char* equals = strchr(text, '=');
+  if (!equals || equals == text) return false;
+  char* end;
+  long id = strtol(text, &end, 10);
+  if (end != equals) return false;
+  assignment.first = (int)id;
+  return parseDouble(equals + 1, assignment.second);
+}
+
+// Consume the options shared by every command. Names listed in extraNames
+// are collected in options.extra for the command; other unknown ones are an error.
+static bool parseCommonOptions(int argc, char** argv, int first, CommonOptions& options,
+                               const char* const* extraNames = nullptr) {
+  for (int i = first; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    if (arg[0] != '-') {
+      if (!options.machinePath.empty()) {
+        fprintf(stderr, "Error: unexpected argument '%s'\n", arg);
+        return false;
+      }
+      options.machinePath = arg;
+      continue;
+    }
+    if (!value) {
+      fprintf(stderr, "Error: %s needs a value\n", arg);
+      return false;
+    }
+    i++;
+    bool ok = true;
+    if (strcmp(arg, "--duration") == 0) {
+      ok = parseDouble(value, options.path.duration) && options.path.duration >= 0;
+    } else if (strcmp(arg, "--samples") == 0) {
+      double samples;
+      ok = parseDouble(value, samples) && samples >= 1;
+      options.path.samples = (size_t)samples;
+      options.samplesGiven = true;
+    } else if (strcmp(arg, "--max-deviation") == 0) {
+      ok = parseDouble(value, options.path.maxDeviation) && options.path.maxDeviation > 0;
+    } else if (strcmp(arg, "--ratio") == 0 || strcmp(arg, "--rate") == 0) {
+      std::pair<int, double> assignment;
+      ok = parseAssignment(value, assignment);
+      (strcmp(arg, "--ratio") == 0 ? options.ratios : options.rates).push_back(assignment);
+    } else if (strcmp(arg, "--master-time") == 0) {
+      ok = parseDouble(value, options.masterTime) && options.masterTime > 0;
+    } else if (strcmp(arg, "--lfo-depth") == 0 || strcmp(arg, "--lfo-rate") == 0 || strcmp(arg, "--lfo-bipolar") == 0) {
+      std::pair<int, double> assignment;
+      ok = parseAssignment(value, assignment) && assignment.second >= 0;
+      (strcmp(arg, "--lfo-depth") == 0 ? options.lfoDepths
+       : strcmp(arg, "--lfo-rate") == 0 ? options.lfoRates : options.lfoBipolar).push_back(assignment);
+    } else if (strcmp(arg, "--solver") == 0) {
+      ok = strcmp(value, "compiled") == 0 || strcmp(value, "newton") == 0;
+      options.path.solver = (strcmp(value, "newton") == 0) ? PATH_SOLVER_NEWTON : PATH_SOLVER_COMPILED;
+    } else if (strcmp(arg, "--out") == 0) {
+      options.outPath = value;
+    } else if (strcmp(arg, "--trace") == 0) {
+      options.tracePath = value;
+    } else if (strcmp(arg, "--motor") == 0) {
+      std::pair<int, double> assignment;
+      ok = parseAssignment(value, assignment) && assignment.first >= 1 && assignment.first <= TRACE_MAX_MOTORS;
+      options.traceMotors.push_back(assignment);
+    } else if (strcmp(arg, "--gear-ratio") == 0) {
+      ok = parseDouble(value, options.gearRatio) && options.gearRatio > 0;
+    } else if (isExtraOption(arg, extraNames)) {
+      options.extra.emplace_back(arg, value);
+    } else {
+      fprintf(stderr, "Error: unknown option %s\n", arg);
+      return false;
+    }
+    if (!ok) {
+      fprintf(stderr, "Error: invalid value '%s' for %s\n", value, arg);
+      return false;
+    }
+  }
+  if (options.machinePath.empty()) {
+    fprintf(stderr, "Error: no machine file given\n");
+    return false;
+  }
+  // Same density as the Python simulator: 60 samples per second
+  if (!options.samplesGiven) {
+    double samples = options.path.duration * 60.0;
+    options.path.samples = samples < 60 ? 60 : (size_t)samples;
+  }
+  return true;
+}
+
+// Load --trace and assign its motors to wheels; the path is then sampled
+// at the trace rows
+static bool loadTrace(CommonOptions& options, Machine& machine) {
+  auto trace = std::make_shared<StepTrace>();
+  std::string error;
+  if (!trace->load(options.tracePath, options.gearRatio, error)) {
+    fprintf(stderr, "Error: %s\n", error.c_str());
+    return false;
+  }
+  if (options.traceMotors.empty()) {
+    for (int motor = 0; motor < trace->motorCount() && motor < (int)machine.wheels.size(); motor++) {
+      machine.wheels[motor].traceMotor = motor;
+    }
+  }
+  for (const auto& assignment : options.traceMotors) {
+    int index = findWheel(machine, (int)assignment.second);
+    if (index < 0) {
+      fprintf(stderr, "Error: no wheel %g\n", assignment.second);
+      return false;
+    }
+    if (assignment.first > trace->motorCount()) {
+      fprintf(stderr, "Error: the trace has %d motors\n", trace->motorCount());
+      return false;
+    }
+    machine.wheels[index].traceMotor = assignment.first - 1;
+  }
+  machine.stepTrace = trace;
+  options.path.times = &trace->rowTimes();
+  fprintf(stderr, "Trace: %zu rows of %d motors over %.3f s\n", trace->rowCount(), trace->motorCount(),
+          trace->duration());
+  return true;
+}
+
+// Wheel speed and LFO options, on top of what the machine file says
+static bool applyOverrides(const CommonOptions& options, Machine& machine) {
+  for (const auto& ratio : options.ratios) {
+    if (!setWheelRatio(machine, ratio.first, ratio.second)) {
+      fprintf(stderr, "Error: no wheel %d\n", ratio.first);
+      return false;
+    }
+  }
+  for (const auto& rate : options.rates) {
+    if (!setWheelRotationRate(machine, rate.first, rate.second)) {
+      fprintf(stderr, "Error: no wheel %d\n", rate.first);
+      return false;
+    }
+  }
+  if (options.masterTime > 0) setMasterTime(machine, options.masterTime);
+  // Each LFO option sets one field and keeps the others
+  for (int field = 0; field < 3; field++) {
+    const auto& settings = field == 0 ? options.lfoDepths : field == 1 ? options.lfoRates : options.lfoBipolar;
+    for (const auto& setting : settings) {
+      int index = findWheel(machine, setting.first);
+      if (index < 0) {
+        fprintf(stderr, "Error: no wheel %d\n", setting.first);
+        return false;
+      }
+      Wheel& wheel = machine.wheels[index];
+      if (field == 0) wheel.lfoDepth = setting.second;
+      if (field == 1) wheel.lfoRate = setting.second;
+      if (field == 2) wheel.lfoBipolar = setting.second != 0;
+    }
+  }
+  return true;
+}
+
+static bool loadMachine(CommonOptions& options, Machine& machine) {
+  std::string error;
+  bool loaded = isMachineImage(options.machinePath) ? loadMachineImage(options.machinePath, machine, error)
+                                                    : loadMachineXml(options.machinePath, machine, error);
+  if (!loaded) {
+    fprintf(stderr, "Error: %s\n", error.c_str());
+    return false;
+  }
+  return applyOverrides(options, machine) && (options.tracePath.empty() || loadTrace(options, machine));
+}
+
+static FILE* openOutput(const std::string& path) {
+  if (path.empty()) return stdout;
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file) fprintf(stderr, "Error: cannot write %s\n", path.c_str());
+  return file;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void printSolverSummary(const PathResult& result, double seconds) {
+  fprintf(stderr, "%zu samples in %.3f s (%.0f samples/s)\n", result.samples, seconds,
+          seconds > 0 ? result.samples / seconds : 0.0);
+  const SolverStats& stats = result.solver;
+  if (stats.samples > 0) {
+    fprintf(stderr, "Solver: %.2f iterations/sample (max %u), %llu substepped, %llu failures, max residual %.3g\n",
+            (double)stats.iterations / stats.samples, stats.maxIterations, (unsigned long long)stats.substepped,
+            (unsigned long long)stats.failures, stats.maxResidual);
+  }
+}
+
+// --- Commands ---
+
+class CsvSink : public PathSink {
+ public:
+  explicit CsvSink(FILE* file) : file(file) {}
+  bool write(const PenSample* samples, size_t count) override {
+    for (size_t i = 0; i < count; i++) {
+      fprintf(file, "%.6f,%.6f,%.6f\n", samples[i].t, samples[i].x, samples[i].y);
+    }
+    return !ferror(file);
+  }
+
+ private:
+  FILE* file;
+};
+
+class StoreSink : public PathSink {
+ public:
+  bool write(const PenSample* samples, size_t count) override {
+    stored.insert(stored.end(), samples, samples + count);
+    return true;
+  }
+  std::vector<PenSample> stored;
+};
+
+static int runSolve(int argc, char** argv) {
+  CommonOptions options;
+  Machine machine;
+  if (!parseCommonOptions(argc, argv, 2, options) || !loadMachine(options, machine)) return 1;
+
+  FILE* out = openOutput(options.outPath);
+  if (!out) return 1;
+  fprintf(out, "t,x,y\n");
+
+  CsvSink sink(out);
+  PathResult result;
+  std::string error;
+  auto start = std::chrono::steady_clock::now();
+  bool ok = generatePath(machine, options.path, sink, result, error);
+  double seconds = secondsSince(start);
+  if (out != stdout) fclose(out);
+
+  if (!ok) {
+    fprintf(stderr, "Error: %s\n", error.c_str());
+    return 1;
+  }
+  printSolverSummary(result, seconds);
+  // The CSV has the best fit at a failed sample; say so rather than pass it off as the path
+  if (result.solver.failures > 0) {
+    fprintf(stderr, "Warning: %llu of %zu samples failed (max residual %.3g); the pen is off the linkage there\n",
+            (unsigned long long)result.solver.failures, result.samples, result.solver.maxResidual);
+    return 2;
+  }
+  return 0;
+}
+
+static int runCompile(int argc, char** argv) {
+  CommonOptions options;
+  Machine machine;
+  if (!parseCommonOptions(argc, argv, 2, options) || !loadMachine(options, machine)) return 1;
+
+  FILE* out = openOutput(options.outPath);
+  if (!out) return 1;
+  CompiledLinkage linkage(machine);
+  fputs(linkage.listing().c_str(), out);
+  if (out != stdout) fclose(out);
+  return 0;
+}
+
+// Regression check for the compiler: the program must solve every sample
+// whole-machine Newton solves, and put the pen where Newton does
+static int runCheck(int argc, char** argv) {
+  CommonOptions options;
+  Machine machine;
+  if (!parseCommonOptions(argc, argv, 2, options) || !loadMachine(options, machine)) return 1;
+
+  CompiledLinkage linkage(machine);
+  PathOptions compiledPath = options.path, newtonPath = options.path;
+  compiledPath.solver = PATH_SOLVER_COMPILED;
+  newtonPath.solver = PATH_SOLVER_NEWTON;
+  StoreSink compiledSamples, newtonSamples;
+  PathResult compiled, newton;
+  std::string error;
+  if (!generatePath(machine, compiledPath, compiledSamples, compiled, error) ||
+      !generatePath(machine, newtonPath, newtonSamples, newton, error)) {
+    fprintf(stderr, "Error: %s\n", error.c_str());
+    return 1;
+  }
+
+  double deviation = 0, worstT = 0;
+  for (size_t i = 0; i < compiledSamples.stored.size(); i++) {
+    const PenSample& a = compiledSamples.stored[i];
+    const PenSample& b = newtonSamples.stored[i];
+    double distance = std::hypot(a.x - b.x, a.y - b.y);
+    if (!(distance <= deviation)) {
+      deviation = distance;
+      worstT = a.t;
+    }
+  }
+  printf("%zu operations, %zu Newton blocks; %zu samples\n", linkage.operationCount(), linkage.newtonBlockCount(),
+         compiled.samples);
+  printf("compiled: %llu failures, max residual %.3g\n", (unsigned long long)compiled.solver.failures,
+         compiled.solver.maxResidual);
+  printf("newton:   %llu failures, max residual %.3g\n", (unsigned long long)newton.solver.failures,
+         newton.solver.maxResidual);
+  printf("Pen deviation: max %.3g at t = %g\n", deviation, worstT);
+
+  if (!(deviation <= CHECK_TOLERANCE * linkage.lengthUnit()) || compiled.solver.failures > newton.solver.failures) {
+    printf("FAIL: the compiled program does not follow Newton\n");
+    return 1;
+  }
+  if (compiled.solver.failures > 0) {
+    printf("FAIL: both solvers fail on some samples; the machine cannot reach those poses\n");
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
+
+// A run with failed samples spends its time on poses the machine cannot reach
+// (best fits, stalled Newton blocks), so its rate says nothing; only the failures are quoted
+static void printThroughput(const char* name, size_t samples, double seconds, const SolverStats& stats) {
+  if (stats.failures > 0) {
+    printf("%-16s %10zu samples in %7.3f s  %llu failed, max residual %.3g: no throughput quoted\n", name, samples,
+           seconds, (unsigned long long)stats.failures, stats.maxResidual);
+  } else {
+    printf("%-16s %10zu samples in %7.3f s  %8.2f M samples/s  (max residual %.3g)\n", name, samples, seconds,
+           seconds > 0 ? samples / seconds / 1e6 : 0.0, stats.maxResidual);
+  }
+}
+
+static int runBench(int argc, char** argv) {
+  CommonOptions options;
+  Machine machine;
+  if (!parseCommonOptions(argc, argv, 2, options) || !loadMachine(options, machine)) return 1;
+  size_t samples = options.samplesGiven ? options.path.samples : BENCH_DEFAULT_SAMPLES;
+  double dt = (samples > 1) ? options.path.duration / (double)(samples - 1) : 0;
+
+  CompiledLinkage linkage(machine);
+  BatchEvaluator evaluator(linkage);
+  printf("%zu operations, %zu Newton blocks; batches of %d on %s\n", linkage.operationCount(),
+         linkage.newtonBlockCount(), BATCH_SAMPLES, BatchEvaluator::instructionSet());
+
+  // The checksum keeps the compiler from dropping unused pen positions
+  double checksum = 0, x, y;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < samples; i++) {
+    linkage.solve(dt * (double)i);
+    linkage.penPosition(x, y);
+    checksum += x + y;
+  }
+  printThroughput("compiled scalar", samples, secondsSince(start), linkage.stats());
+
+  std::vector<double> batchX(PATH_CHUNK_SAMPLES), batchY(PATH_CHUNK_SAMPLES);
+  if (evaluator.supported()) {
+    start = std::chrono::steady_clock::now();
+    for (size_t first = 0; first < samples; first += PATH_CHUNK_SAMPLES) {
+      size_t count = std::min((size_t)PATH_CHUNK_SAMPLES, samples - first);
+      evaluator.evaluate(dt, first, count, batchX.data(), batchY.data());
+      checksum += batchX[count - 1] + batchY[count - 1];
+    }
+    printThroughput("compiled batch", samples, secondsSince(start), evaluator.stats());
+
+    double deviation = 0;
+    size_t compared = std::min(samples, (size_t)BENCH_COMPARE_SAMPLES);
+    for (size_t first = 0; first < compared; first += PATH_CHUNK_SAMPLES) {
+      size_t count = std::min((size_t)PATH_CHUNK_SAMPLES, compared - first);
+      evaluator.evaluate(dt, first, count, batchX.data(), batchY.data());
+      for (size_t i = 0; i < count; i++) {
+        linkage.solve(dt * (double)(first + i));
+        linkage.penPosition(x, y);
+        deviation = std::max(deviation, std::hypot(batchX[i] - x, batchY[i] - y));
+      }
+    }
+    printf("Batch vs scalar: max deviation %.3g over %zu samples\n", deviation, compared);
+  } else {
+    printf("compiled batch   not available: the program has Newton blocks, a wheel LFO or a step trace\n");
+  }
+
+  // Streaming simplification of the same path, as `export` does it
+  class CountingSink : public VertexSink {
+   public:
+    bool vertex(double, double) override { return true; }
+  } vertices;
+  PathSimplifier simplifier(SVG_DEFAULT_TOLERANCE, vertices);
+  PathOptions simplifyPath = options.path;
+  simplifyPath.samples = samples;
+  simplifyPath.maxDeviation = 0;
+  PathResult simplifyResult;
+  std::string error;
+  start = std::chrono::steady_clock::now();
+  generatePath(machine, simplifyPath, simplifier, simplifyResult, error);
+  simplifier.finish();
+  printThroughput("path + simplify", simplifyResult.samples, secondsSince(start), simplifyResult.solver);
+  printf("Simplified to %zu vertices at %g tolerance: %.1fx fewer\n", simplifier.outputCount(), SVG_DEFAULT_TOLERANCE,
+         simplifier.outputCount() ? (double)simplifyResult.samples / simplifier.outputCount() : 0.0);
+
+  // Adaptive sampling of the same path, at the export tolerance unless --max-deviation is given
+  class DiscardSink : public PathSink {
+   public:
+    bool write(const PenSample*, size_t) override { return true; }
+  } discard;
+  PathOptions adaptivePath = simplifyPath;
+  adaptivePath.maxDeviation = options.path.maxDeviation > 0 ? options.path.maxDeviation : SVG_DEFAULT_TOLERANCE;
+  PathResult adaptiveResult;
+  start = std::chrono::steady_clock::now();
+  generatePath(machine, adaptivePath, discard, adaptiveResult, error);
+  printThroughput("adaptive", adaptiveResult.samples, secondsSince(start), adaptiveResult.solver);
+  printf("Adaptive at %g max deviation: %zu samples over %g s, %.1fx fewer than %zu uniform\n",
+         adaptivePath.maxDeviation, adaptiveResult.samples, adaptivePath.duration,
+         adaptiveResult.samples ? (double)simplifyResult.samples / adaptiveResult.samples : 0.0, simplifyResult.samples);
+
+  size_t newtonSamples = std::min(samples, (size_t)BENCH_NEWTON_SAMPLES);
+  LinkageSolver solver(machine);
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < newtonSamples; i++) {
+    solver.solve(dt * (double)i);
+    solver.penPosition(x, y);
+    checksum += x + y;
+  }
+  printThroughput("newton", newtonSamples, secondsSince(start), solver.stats());
+
+  fprintf(stderr, "(checksum %g)\n", checksum);
+  if (linkage.stats().failures > 0) {
+    printf("Warning: the machine does not solve cleanly; see `cycloid_sim check`\n");
+  }
+  return 0;
+}
+
+// One row per candidate, written as soon as it completes (so in completion
+// order; the index column gives the sweep order)
+class SweepCsvSink : public SweepSink {
+ public:
+  SweepCsvSink(FILE* file, const std::vector<SweepAxis>& axes) : file(file) {
+    fprintf(file, "index");
+    for (const SweepAxis& axis : axes) fprintf(file, ",%s", axis.name().c_str());
+    fprintf(file, ",closes,closure_revs,closure_s,simulated_s,min_x,min_y,max_x,max_y,ink_length,crossings,"
+                  "crossing_density,failures,max_residual\n");
+  }
+
+  bool write(const SweepResult& result) override {
+    fprintf(file, "%zu", result.index);
+    for (double value : result.values) fprintf(file, ",%.6g", value);
+    const PathMetrics& m = result.metrics;
+    fprintf(file, ",%d,%.6g,%.6g,%.6g,%.6f,%.6f,%.6f,%.6f,%.6f,%zu,%.4f,%llu,%.3g\n", result.closure.closes ? 1 : 0,
+            result.closure.masterRevs, result.closure.seconds, result.duration, m.minX, m.minY, m.maxX, m.maxY,
+            m.inkLength, m.crossings, m.crossingDensity, (unsigned long long)result.solver.failures,
+            result.solver.maxResidual);
+    return !ferror(file);
+  }
+
+ private:
+  FILE* file;
+};
+
+static int runSweepCommand(int argc, char** argv) {
+  static const char* const sweepOptionNames[] = { "--sweep", "--threads", "--thumbs", "--thumb-size", nullptr };
+  CommonOptions options;
+  Machine machine;
+  if (!parseCommonOptions(argc, argv, 2, options, sweepOptionNames) || !loadMachine(options, machine)) return 1;
+  if (machine.stepTrace) {
+    fprintf(stderr, "Error: a step trace fixes the wheel motion; sweep does not take --trace\n");
+    return 1;
+  }
+
+  SweepOptions sweep;
+  sweep.maxDuration = options.path.duration;
+  sweep.samples = options.samplesGiven ? options.path.samples : SWEEP_DEFAULT_SAMPLES;
+  sweep.maxDeviation = options.path.maxDeviation;
+  sweep.solver = options.path.solver;
+  std::string error;
+  for (const auto& option : options.extra) {
+    const char* name = option.first.c_str();
+    const char* value = option.second.c_str();
+    double number;
+    bool ok = true;
+    if (strcmp(name, "--sweep") == 0) {
+      SweepAxis axis;
+      if (!parseSweepAxis(value, axis, error)) {
+        fprintf(stderr, "Error: %s\n", error.c_str());
+        return 1;
+      }
+      sweep.axes.push_back(axis);
+    } else if (strcmp(name, "--threads") == 0) {
+      ok = parseDouble(value, number) && number >= 1;
+      sweep.threads = ok ? (unsigned int)number : 0;
+    } else if (strcmp(name, "--thumbs") == 0) {
+      sweep.thumbnailDir = value;
+    } else {
+      ok = parseDouble(value, number) && number >= 8 && number <= 4096;
+      sweep.thumbnailSize = (int)number;
+    }
+    if (!ok) {
+      fprintf(stderr, "Error: invalid value '%s' for %s\n", value, name);
+      return 1;
+    }
+  }
+  if (sweep.axes.empty()) {
+    fprintf(stderr, "Error: no --sweep ranges given\n");
+    return 1;
+  }
+
+  FILE* out = openOutput(options.outPath);
+  if (!out) return 1;
+  SweepCsvSink sink(out, sweep.axes);
+  SweepSummary summary;
+  auto start = std::chrono::steady_clock::now();
+  bool ok = runSweep(machine, sweep, sink, summary, error);
+  double seconds = secondsSince(start);
+  if (out != stdout) fclose(out);
+
+  if (!ok) {
+    fprintf(stderr, "Error: %s\n", error.c_str());
+    return 1;
+  }
+  fprintf(stderr, "%zu of %zu candidates in %.3f s (%.1f candidates/s) on %u threads, %zu steals\n", summary.completed,
+          summary.candidates, seconds, seconds > 0 ? summary.completed / seconds : 0.0, summary.threads, summary.steals);
+  return 0;
+}
+
+static int runRender(int argc, char** argv) {
+  static const char* const renderOptionNames[] = { "--size", "--pen-width", "--ink", "--dwell", "--threads", nullptr };
+  CommonOptions options;
+  Machine machine;
+  if (!parseCommonOptions(argc, argv, 2, options, renderOptionNames) || !loadMachine(options, machine)) return 1;
+  if (options.outPath.empty()) {
+    fprintf(stderr, "Error: render needs --out <file.png>\n");
+    return 1;
+  }
+  if (!options.samplesGiven) options.path.samples = RASTER_DEFAULT_SAMPLES;
+
+  RasterOptions raster;
+  for (const auto& option : options.extra) {
+    const char* name = option.first.c_str();
+    double number;
+    bool ok = parseDouble(option.second.c_str(), number);
+    if (strcmp(name, "--size") == 0) {
+      ok = ok && number >= 1 && number <= 1 << 20;
+      raster.size = (uint32_t)number;
+    } else if (strcmp(name, "--pen-width") == 0) {
+      ok = ok && number >= 1;
+      raster.penWidth = number;
+    } else if (strcmp(name, "--ink") == 0) {
+      ok = ok && number > 0 && number < 1;
+      raster.inkOpacity = number;
+    } else if (strcmp(name, "--dwell") == 0) {
+      ok = ok && number >= 0;
+      raster.dwell = number;
+    } else {
+      ok = ok && number >= 1;
+      raster.threads = ok ? (unsigned int)number : 0;
+    }
+    if (!ok) {
+      fprintf(stderr, "Error: invalid value '%s' for %s\n", option.second.c_str(), name);
+      return 1;
+    }
+  }
+
+  FILE* out = fopen(options.outPath.c_str(), "wb");
+  if (!out) {
+    fprintf(stderr, "Error: cannot write %s\n", options.outPath.c_str());
+    return 1;
+  }
+  RasterResult result;
+  std::string error;
+  auto start = std::chrono::steady_clock::now();
+  bool ok = renderPattern(machine, options.path, raster, out, result, error);
+  ok = (fclose(out) == 0) && ok;
+  double seconds = secondsSince(start);
+  if (!ok) {
+    fprintf(stderr, "Error: %s\n", error.empty() ? "error writing PNG" : error.c_str());
+    return 1;
+  }
+  fprintf(stderr, "%ux%u in %zu bands, %zu samples generated, in %.3f s; densest pixel %.1f passes\n", result.width,
+          result.height, result.bands, result.samples, seconds, result.maxInk);
+  return 0;
+}
+
+static int runExport(int argc, char** argv) {
+  static const char* const exportOptionNames[] = { "--tolerance", "--chunk", "--stroke", nullptr };
+  CommonOptions options;
+  Machine machine;
+  if (!parseCommonOptions(argc, argv, 2, options, exportOptionNames) || !loadMachine(options, machine)) return 1;
+  if (!options.samplesGiven) options.path.samples = SVG_DEFAULT_SAMPLES;
+
+  SvgOptions svg;
+  for (const auto& option : options.extra) {
+    const char* name = option.first.c_str();
+    double number;
+    bool ok = parseDouble(option.second.c_str(), number);
+    if (strcmp(name, "--tolerance") == 0) {
+      ok = ok && number >= 0;
+      svg.tolerance = number;
+    } else if (strcmp(name, "--chunk") == 0) {
+      ok = ok && number >= 2;
+      svg.chunkVertices = ok ? (size_t)number : 0;
+    } else {
+      ok = ok && number > 0;
+      svg.strokeWidth = number;
+    }
+    if (!ok) {
+      fprintf(stderr, "Error: invalid value '%s' for %s\n", option.second.c_str(), name);
+      return 1;
+    }
+  }
+
+  FILE* out = openOutput(options.outPath);
+  if (!out) return 1;
+  SvgResult result;
+  std::string error;
+  auto start = std::chrono::steady_clock::now();
+  bool ok = exportSvg(machine, options.path, svg, out, result, error);
+  long bytes = ftell(out);
+  if (out != stdout) ok = (fclose(out) == 0) && ok;
+  double seconds = secondsSince(start);
+  if (!ok) {
+    fprintf(stderr, "Error: %s\n", error.empty() ? "error writing SVG" : error.c_str());
+    return 1;
+  }
+  fprintf(stderr, "%zu samples -> %zu vertices (%.1fx fewer) in %zu polylines in %.3f s (%.1f M samples/s)",
+          result.samples, result.vertices, result.vertices ? (double)result.samples / result.vertices : 0.0,
+          result.polylines, seconds, seconds > 0 ? result.samples / seconds / 1e6 : 0.0);
+  if (bytes > 0) fprintf(stderr, ", %ld bytes", bytes);
+  fprintf(stderr, "\n");
+  return 0;
+}
+
+// Overrides given with the XML are compiled into the image; a trace is not
+static int runConvert(int argc, char** argv) {
+  CommonOptions options;
+  Machine machine;
+  if (!parseCommonOptions(argc, argv, 2, options)) return 1;
+  if (options.outPath.empty() || !options.tracePath.empty()) {
+    fprintf(stderr, "Error: convert needs --out <file> and takes no --trace\n");
+    return 1;
+  }
+  if (!loadMachine(options, machine)) return 1;
+
+  std::string error;
+  if (!saveMachineImage(machine, options.outPath, error)) {
+    fprintf(stderr, "Error: %s\n", error.c_str());
+    return 1;
+  }
+  fprintf(stderr, "%zu wheels, %zu rods -> %s (version %d)\n", machine.wheels.size(), machine.rods.size(),
+          options.outPath.c_str(), MACHINE_IMAGE_VERSION);
+  return 0;
+}
+
+static int runValidate(int argc, char** argv) {
+  static const char* const validateOptionNames[] = { "--image", nullptr };
+  CommonOptions options;
+  if (!parseCommonOptions(argc, argv, 2, options, validateOptionNames)) return 1;
+  if (!options.tracePath.empty()) {
+    fprintf(stderr, "Error: validate takes no --trace (images do not hold one)\n");
+    return 1;
+  }
+  std::string imagePath;
+  for (const auto& option : options.extra) imagePath = option.second;
+
+  // The XML with the same overrides convert would have compiled in
+  std::string error;
+  Machine fromXml;
+  auto start = std::chrono::steady_clock::now();
+  if (!loadMachineXml(options.machinePath, fromXml, error)) {
+    fprintf(stderr, "Error: %s\n", error.c_str());
+    return 1;
+  }
+  double xmlSeconds = secondsSince(start);
+  if (!applyOverrides(options, fromXml)) return 1;
+
+  // The image under test, and the bytes it should consist of
+  std::vector<uint8_t> encoded;
+  encodeMachineImage(fromXml, encoded);
+  Machine fromImage;
+  MachineImage image;
+  start = std::chrono::steady_clock::now();
+  bool opened = imagePath.empty() ? image.openBuffer(encoded.data(), encoded.size(), error)
+                                  : image.openFile(imagePath, error);
+  if (opened) image.toMachine(fromImage);
+  double imageSeconds = secondsSince(start);
+  if (!opened) {
+    fprintf(stderr, "Error: %s\n", error.c_str());
+    return 1;
+  }
+
+  if (!compareMachines(fromXml, fromImage, error)) {
+    fprintf(stderr, "FAIL: %s\n", error.c_str());
+    return 1;
+  }
+  std::vector<uint8_t> reencoded;
+  encodeMachineImage(fromImage, reencoded);
+  if (reencoded != encoded) {
+    fprintf(stderr, "FAIL: the image does not encode back to the same bytes\n");
+    return 1;
+  }
+
+  // Same path from both, to the last bit
+  PathOptions path = options.path;
+  path.samples = std::min<size_t>(path.samples, PATH_CHUNK_SAMPLES);
+  StoreSink xmlSamples, imageSamples;
+  PathResult result;
+  if (!generatePath(fromXml, path, xmlSamples, result, error) ||
+      !generatePath(fromImage, path, imageSamples, result, error)) {
+    fprintf(stderr, "Error: %s\n", error.c_str());
+    return 1;
+  }
+  for (size_t i = 0; i < xmlSamples.stored.size(); i++) {
+    if (xmlSamples.stored[i].x != imageSamples.stored[i].x || xmlSamples.stored[i].y != imageSamples.stored[i].y) {
+      fprintf(stderr, "FAIL: pen paths differ at t = %g\n", xmlSamples.stored[i].t);
+      return 1;
+    }
+  }
+
+  printf("OK: %zu wheels, %zu rods, %zu-byte image (version %d); %zu path samples identical\n", fromXml.wheels.size(),
+         fromXml.rods.size(), encoded.size(), MACHINE_IMAGE_VERSION, xmlSamples.stored.size());
+  printf("Load: XML %.1f us, image %.1f us\n", xmlSeconds * 1e6, imageSeconds * 1e6);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printUsage();
+    return 1;
+  }
+  const char* command = argv[1];
+  if (strcmp(command, "solve") == 0) return runSolve(argc, argv);
+  if (strcmp(command, "compile") == 0) return runCompile(argc, argv);
+  if (strcmp(command, "check") == 0) return runCheck(argc, argv);
+  if (strcmp(command, "bench") == 0) return runBench(argc, argv);
+  if (strcmp(command, "sweep") == 0) return runSweepCommand(argc, argv);
+  if (strcmp(command, "render") == 0) return runRender(argc, argv);
+  if (strcmp(command, "export") == 0) return runExport(argc, argv);
+  if (strcmp(command, "convert") == 0) return runConvert(argc, argv);
+  if (strcmp(command, "validate") == 0) return runValidate(argc, argv);
+  if (strcmp(command, "help") == 0 || strcmp(command, "--help") == 0) {
+    printUsage();
+    return 0;
+  }
+  fprintf(stderr, "Error: unknown command '%s'\n", command);
+  printUsage();
+  return 1;
+}